@@ -0,0 +1,39 @@
+# - Try to find libjpeg-turbo (TurboJPEG API)
+# Once done, this will define
+#
+#  TurboJPEG_FOUND - system has libjpeg-turbo
+#  TurboJPEG_INCLUDE_DIRS - the libjpeg-turbo include directories
+#  TurboJPEG_LIBRARIES - link these to use libjpeg-turbo
+
+include(FindPkgMacros)
+findpkg_begin(TurboJPEG)
+
+# Get path, convert backslashes as ${ENV_${var}}
+getenv_path(TURBOJPEG_HOME)
+
+# construct search paths
+set(TurboJPEG_PREFIX_PATH ${TURBOJPEG_HOME} ${ENV_TURBOJPEG_HOME})
+create_search_paths(TurboJPEG)
+# redo search if prefix path changed
+clear_if_changed(TurboJPEG_PREFIX_PATH
+  TurboJPEG_LIBRARY_FWK
+  TurboJPEG_LIBRARY_REL
+  TurboJPEG_LIBRARY_DBG
+  TurboJPEG_INCLUDE_DIR
+)
+
+set(TurboJPEG_LIBRARY_NAMES turbojpeg)
+get_debug_names(TurboJPEG_LIBRARY_NAMES)
+
+use_pkgconfig(TurboJPEG_PKGC libturbojpeg)
+
+findpkg_framework(TurboJPEG)
+
+find_path(TurboJPEG_INCLUDE_DIR NAMES turbojpeg.h HINTS ${TurboJPEG_INC_SEARCH_PATH} ${TurboJPEG_PKGC_INCLUDE_DIRS})
+
+find_library(TurboJPEG_LIBRARY_REL NAMES ${TurboJPEG_LIBRARY_NAMES} HINTS ${TurboJPEG_LIB_SEARCH_PATH} ${TurboJPEG_PKGC_LIBRARY_DIRS} PATH_SUFFIXES release relwithdebinfo minsizerel)
+find_library(TurboJPEG_LIBRARY_DBG NAMES ${TurboJPEG_LIBRARY_NAMES_DBG} HINTS ${TurboJPEG_LIB_SEARCH_PATH} ${TurboJPEG_PKGC_LIBRARY_DIRS} PATH_SUFFIXES debug)
+
+make_library_set(TurboJPEG_LIBRARY)
+
+findpkg_finish(TurboJPEG)
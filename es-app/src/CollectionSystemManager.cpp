@@ -8,6 +8,7 @@
 #include "FileData.h"
 #include "FileFilterIndex.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "ThemeData.h"
@@ -173,6 +174,8 @@ void CollectionSystemManager::saveCustomCollection(SystemData* sys)
 // loads all Collection Systems
 void CollectionSystemManager::loadCollectionSystems(bool async)
 {
+	PROFILE_SCOPE("CollectionSystemManager::loadCollectionSystems");
+
 	initAutoCollectionSystems();
 	CollectionSystemDecl decl = mCollectionSystemDeclsIndex[myCollectionsName];
 	mCustomCollectionsBundle = createNewCollectionEntry(decl.name, decl, false);
@@ -215,6 +218,8 @@ void CollectionSystemManager::loadEnabledListFromSettings()
 // updates enabled system list in System View
 void CollectionSystemManager::updateSystemsList()
 {
+	PROFILE_SCOPE("CollectionSystemManager::updateSystemsList");
+
 	// remove all Collection Systems
 	removeCollectionsFromDisplayedSystems();
 
@@ -358,9 +363,8 @@ void CollectionSystemManager::sortLastPlayed(SystemData* system)
 	const FileSorts::SortType& sort = FileSorts::getSortTypes().at(system->getSortId());
 
 	std::vector<FileData*>& childs = (std::vector<FileData*>&) rootFolder->getChildren();
-	std::sort(childs.begin(), childs.end(), sort.comparisonFunction);
-	if (!sort.ascending)
-		std::reverse(childs.begin(), childs.end());
+	FileSorts::sortFiles(childs, sort);
+	FolderData::invalidateDisplayLists();
 }
 
 void CollectionSystemManager::trimCollectionCount(FolderData* rootFolder, int limit)
@@ -1061,7 +1065,7 @@ void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<s
 		{
 			getAllGamesCollection();
 
-			Utils::ThreadPool pool;
+			Utils::TaskGroup pool;
 
 			for (auto collection : collectionsToPopulate)
 			{
@@ -75,15 +75,15 @@ std::string FileData::getCleanName() const
 
 const std::string FileData::getThumbnailPath()
 {
-	std::string thumbnail = getMetadata().get("thumbnail");
+	std::string thumbnail = getMetadata().get(MetaDataId::Thumbnail);
 
 	// no thumbnail, try image
 	if(thumbnail.empty())
 	{
-		thumbnail = getMetadata().get("image");
+		thumbnail = getMetadata().get(MetaDataId::Image);
 		
 		// no image, try to use local image
-		if(thumbnail.empty() && Settings::getInstance()->getBool("LocalArt"))
+		if(thumbnail.empty() && Settings::getInstance()->getBool(SettingKey::LocalArt))
 		{
 			const char* extList[2] = { ".png", ".jpg" };
 			for(int i = 0; i < 2; i++)
@@ -101,10 +101,10 @@ const std::string FileData::getThumbnailPath()
 		}
 
 		if (thumbnail.empty())
-			thumbnail = getMetadata().get("image");
+			thumbnail = getMetadata().get(MetaDataId::Image);
 
 		// no image, try to use local image
-		if (thumbnail.empty() && Settings::getInstance()->getBool("LocalArt"))
+		if (thumbnail.empty() && Settings::getInstance()->getBool(SettingKey::LocalArt))
 		{
 			const char* extList[2] = { ".png", ".jpg" };
 			for (int i = 0; i < 2; i++)
@@ -127,24 +127,37 @@ const std::string FileData::getThumbnailPath()
 
 const bool FileData::getFavorite()
 {
-	return getMetadata().get("favorite") == "true";
+	return getMetadata().getBool(MetaDataId::Favorite);
 }
 
 const bool FileData::getHidden()
 {
-	return getMetadata().get("hidden") == "true";
+	return getMetadata().getBool(MetaDataId::Hidden);
 }
 
 const bool FileData::getKidGame()
 {
-	return getMetadata().get("kidgame") != "false";
+	// Folders have no kidgame metadata, never filter them out
+	if (getMetadata().getType() != GAME_METADATA)
+		return true;
+
+	return getMetadata().getString(MetaDataId::KidGame) != "false";
 }
 
 static std::shared_ptr<bool> showFilenames;
 
+std::atomic<unsigned int> FolderData::mDisplayGeneration(0);
+
 void FileData::resetSettings()
 {
 	showFilenames = nullptr;
+	FolderData::invalidateDisplayLists();
+}
+
+void FileData::setMetadata(MetaDataList value)
+{
+	getMetadata() = value;
+	FolderData::invalidateDisplayLists();
 }
 
 const std::string FileData::getName()
@@ -166,20 +179,20 @@ const std::string FileData::getName()
 
 const std::string FileData::getCore() const
 {
-	return getMetadata().get("core");
+	return getMetadata().getString(MetaDataId::Core);
 }
 
 const std::string FileData::getEmulator() const
 {
-	return getMetadata().get("emulator");
+	return getMetadata().getString(MetaDataId::Emulator);
 }
 
 const std::string FileData::getVideoPath()
 {
-	std::string video = getMetadata().get("video");
+	std::string video = getMetadata().get(MetaDataId::Video);
 	
 	// no video, try to use local video
-	if(video.empty() && Settings::getInstance()->getBool("LocalArt"))
+	if(video.empty() && Settings::getInstance()->getBool(SettingKey::LocalArt))
 	{
 		std::string path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + "-video.mp4";
 		if (Utils::FileSystem::exists(path))
@@ -194,10 +207,10 @@ const std::string FileData::getVideoPath()
 
 const std::string FileData::getMarqueePath()
 {
-	std::string marquee = getMetadata().get("marquee");
+	std::string marquee = getMetadata().get(MetaDataId::Marquee);
 
 	// no marquee, try to use local marquee
-	if (marquee.empty() && Settings::getInstance()->getBool("LocalArt"))
+	if (marquee.empty() && Settings::getInstance()->getBool(SettingKey::LocalArt))
 	{
 		const char* extList[2] = { ".png", ".jpg" };
 		for(int i = 0; i < 2; i++)
@@ -219,7 +232,7 @@ const std::string FileData::getMarqueePath()
 
 const std::string FileData::getImagePath()
 {
-	std::string image = getMetadata().get("image");
+	std::string image = getMetadata().get(MetaDataId::Image);
 
 	// no image, try to use local image
 	if(image.empty())
@@ -337,13 +350,13 @@ void FileData::launchGame(Window* window)
 	{
 		FileData* gameToUpdate = getSourceFileData();
 
-		int timesPlayed = gameToUpdate->getMetadata().getInt("playcount") + 1;
+		int timesPlayed = gameToUpdate->getMetadata().getInt(MetaDataId::PlayCount) + 1;
 		gameToUpdate->getMetadata().set("playcount", std::to_string(static_cast<long long>(timesPlayed)));
 
 		//update game time played
 		time_t tend = time(NULL);
 		long elapsedSeconds = difftime(tend, tstart);
-		long gameTime = gameToUpdate->getMetadata().getInt("gametime") + elapsedSeconds;
+		long gameTime = gameToUpdate->getMetadata().getInt(MetaDataId::GameTime) + elapsedSeconds;
 		if (elapsedSeconds >= 10)
 			gameToUpdate->setMetadata("gametime", std::to_string(static_cast<long>(gameTime)));
 
@@ -423,12 +436,12 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 {
 	std::vector<FileData*> ret;
 
-	std::string showFoldersMode = Settings::getInstance()->getString("FolderViewMode");
+	std::string showFoldersMode = Settings::getInstance()->getString(SettingKey::FolderViewMode);
 	
-	bool showHiddenFiles = Settings::getInstance()->getBool("ShowHiddenFiles");
+	bool showHiddenFiles = Settings::getInstance()->getBool(SettingKey::ShowHiddenFiles);
 	bool filterKidGame = false;
 
-	if (!Settings::getInstance()->getBool("ForceDisableFilters")) 
+	if (!Settings::getInstance()->getBool(SettingKey::ForceDisableFilters)) 
 	{
 		if (UIModeController::getInstance()->isUIModeKiosk())
 			showHiddenFiles = false;
@@ -443,6 +456,34 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 	if (idx != nullptr && !idx->isFiltered())
 		idx = nullptr;
 
+	unsigned int currentSortId = sys->getSortId();
+	if (currentSortId >= FileSorts::getSortTypes().size())
+		currentSortId = 0;
+
+	// Nothing changed since the last call : the list is still valid
+	if (mDisplayList.valid &&
+		mDisplayList.system == sys &&
+		mDisplayList.index == idx &&
+		mDisplayList.filterGeneration == (idx == nullptr ? 0 : idx->getGeneration()) &&
+		mDisplayList.sortId == currentSortId &&
+		mDisplayList.displayGeneration == mDisplayGeneration &&
+		mDisplayList.metadataGeneration == MetaDataList::getGeneration() &&
+		mDisplayList.folderViewMode == showFoldersMode &&
+		mDisplayList.showHiddenFiles == showHiddenFiles &&
+		mDisplayList.filterKidGame == filterKidGame)
+		return mDisplayList.list;
+
+	mDisplayList.valid = true;
+	mDisplayList.system = sys;
+	mDisplayList.index = idx;
+	mDisplayList.filterGeneration = (idx == nullptr ? 0 : idx->getGeneration());
+	mDisplayList.sortId = currentSortId;
+	mDisplayList.displayGeneration = mDisplayGeneration;
+	mDisplayList.metadataGeneration = MetaDataList::getGeneration();
+	mDisplayList.folderViewMode = showFoldersMode;
+	mDisplayList.showHiddenFiles = showHiddenFiles;
+	mDisplayList.filterKidGame = filterKidGame;
+
 	std::vector<FileData*>* items = &mChildren;
 
 	std::vector<FileData*> flatGameList;
@@ -489,16 +530,10 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 		ret.push_back(*it);
 	}
 
-	unsigned int currentSortId = sys->getSortId();
-	if (currentSortId >= FileSorts::getSortTypes().size())
-		currentSortId = 0;
-
 	const FileSorts::SortType& sort = FileSorts::getSortTypes().at(currentSortId);
-	std::sort(ret.begin(), ret.end(), sort.comparisonFunction);
-
-	if (!sort.ascending)
-		std::reverse(ret.begin(), ret.end());
+	FileSorts::sortFiles(ret, sort);
 
+	mDisplayList.list = ret;
 	return ret;
 }
 
@@ -524,11 +559,7 @@ std::vector<FileData*> FolderData::getFlatGameList(bool displayedOnly, SystemDat
 		currentSortId = 0;
 
 	auto sort = FileSorts::getSortTypes().at(currentSortId);
-
-	std::stable_sort(ret.begin(), ret.end(), sort.comparisonFunction);
-
-	if (!sort.ascending)
-		std::reverse(ret.begin(), ret.end());
+	FileSorts::sortFiles(ret, sort, true);
 
 	return ret;
 }
@@ -569,6 +600,8 @@ void FolderData::addChild(FileData* file, bool assignParent)
 
 	if (assignParent)
 		file->setParent(this);
+
+	invalidateDisplayLists();
 }
 
 void FolderData::removeChild(FileData* file)
@@ -582,6 +615,7 @@ void FolderData::removeChild(FileData* file)
 		{
 			file->setParent(NULL);
 			mChildren.erase(it);
+			invalidateDisplayLists();
 			return;
 		}
 	}
@@ -4,8 +4,10 @@
 
 #include "utils/FileSystemUtil.h"
 #include "MetaData.h"
+#include <atomic>
 #include <unordered_map>
 
+class FileFilterIndex;
 class SystemData;
 class Window;
 struct SystemEnvironmentData;
@@ -84,7 +86,7 @@ public:
 	virtual const MetaDataList& getMetadata() const { return mMetadata; }
 	virtual MetaDataList& getMetadata() { return mMetadata; }
 
-	void setMetadata(MetaDataList value) { getMetadata() = value; }
+	void setMetadata(MetaDataList value);
 	
 	std::string getMetadata(const std::string& key) { return getMetadata().get(key); }
 	void setMetadata(const std::string& key, const std::string& value) { getMetadata().set(key, value); }
@@ -161,12 +163,38 @@ public:
 
 	FileData* findUniqueGameForFolder();
 
+	// Drops every cached display list. Called when something they depend on changes (children, display settings...)
+	static void invalidateDisplayLists() { mDisplayGeneration++; }
+
 private:
 	std::vector<FileData*> getFlatGameList(bool displayedOnly, SystemData* system) const;
 	std::vector<FileData*> mChildren;
 
 	bool	mOwnsChildrens;
 	bool	mIsDisplayableAsVirtualFolder;
+
+	// Last list returned by getChildrenListToDisplay, with everything it was built from
+	struct DisplayListCache
+	{
+		DisplayListCache() : valid(false), system(nullptr), index(nullptr), filterGeneration(0), sortId(0), displayGeneration(0), metadataGeneration(0), showHiddenFiles(false), filterKidGame(false) { }
+
+		bool             valid;
+		SystemData*      system;
+		FileFilterIndex* index;
+		unsigned int     filterGeneration;
+		unsigned int     sortId;
+		unsigned int     displayGeneration;
+		unsigned int     metadataGeneration;
+		std::string      folderViewMode;
+		bool             showHiddenFiles;
+		bool             filterKidGame;
+
+		std::vector<FileData*> list;
+	};
+
+	DisplayListCache mDisplayList;
+
+	static std::atomic<unsigned int> mDisplayGeneration;
 };
 
 #endif // ES_APP_FILE_DATA_H
@@ -4,13 +4,15 @@
 #include "views/UIModeController.h"
 #include "FileData.h"
 #include "Log.h"
+#include "MetaData.h"
 #include "Settings.h"
 
 #define UNKNOWN_LABEL "UNKNOWN"
 #define INCLUDE_UNKNOWN false;
 
 FileFilterIndex::FileFilterIndex()
-	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), filterByVertical(false)
+	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), filterByVertical(false), mGeneration(0),
+	mBitsDirty(true), mHasActiveFilter(false), mResolvedGeneration(-1), mResolvedMetadataGeneration(0)
 {
 	clearAllFilters();
 	FilterDataDecl filterDecls[] = {
@@ -26,6 +28,7 @@ FileFilterIndex::FileFilterIndex()
 	};
 
 	filterDataDecl = std::vector<FilterDataDecl>(filterDecls, filterDecls + sizeof(filterDecls) / sizeof(filterDecls[0]));
+	mKeyBits.resize(filterDataDecl.size());
 }
 
 FileFilterIndex::~FileFilterIndex()
@@ -40,6 +43,8 @@ std::vector<FilterDataDecl>& FileFilterIndex::getFilterDataDecls()
 
 void FileFilterIndex::importIndex(FileFilterIndex* indexToImport)
 {
+	mGeneration++;
+
 	struct IndexImportStructure
 	{
 		std::map<std::string, int>* destinationIndex;
@@ -78,6 +83,8 @@ void FileFilterIndex::importIndex(FileFilterIndex* indexToImport)
 
 void FileFilterIndex::resetIndex()
 {
+	mGeneration++;
+
 	clearAllFilters();
 	clearIndex(genreIndexAllKeys);
 	clearIndex(playersIndexAllKeys);
@@ -87,6 +94,12 @@ void FileFilterIndex::resetIndex()
 	clearIndex(kidGameIndexAllKeys);
 	// clearIndex(hiddenIndexAllKeys);
 	clearIndex(verticalIndexAllKeys);
+
+	std::unique_lock<std::mutex> lock(mLock);
+	mOrdinals.clear();
+	mGames.clear();
+	mFreeOrdinals.clear();
+	mBitsDirty = true;
 }
 
 std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary)
@@ -196,6 +209,8 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 
 void FileFilterIndex::addToIndex(FileData* game)
 {
+	mGeneration++;
+
 	manageGenreEntryInIndex(game);
 	managePlayerEntryInIndex(game);
 	managePubDevEntryInIndex(game);
@@ -204,10 +219,32 @@ void FileFilterIndex::addToIndex(FileData* game)
 	manageKidGameEntryInIndex(game);
 	//manageHiddenEntryInIndex(game);
 	manageVerticalEntryInIndex(game);
+
+	std::unique_lock<std::mutex> lock(mLock);
+	if (mOrdinals.find(game) != mOrdinals.cend())
+		return;
+
+	unsigned int ordinal;
+	if (!mFreeOrdinals.empty())
+	{
+		ordinal = mFreeOrdinals.back();
+		mFreeOrdinals.pop_back();
+	}
+	else
+	{
+		ordinal = (unsigned int)mGames.size();
+		mGames.push_back(nullptr);
+	}
+
+	mGames[ordinal] = game;
+	mOrdinals[game] = ordinal;
+	mBitsDirty = true;
 }
 
 void FileFilterIndex::removeFromIndex(FileData* game)
 {
+	mGeneration++;
+
 	manageGenreEntryInIndex(game, true);
 	managePlayerEntryInIndex(game, true);
 	managePubDevEntryInIndex(game, true);
@@ -216,10 +253,22 @@ void FileFilterIndex::removeFromIndex(FileData* game)
 	manageKidGameEntryInIndex(game, true);
 	//manageHiddenEntryInIndex(game, true);
 	manageVerticalEntryInIndex(game, true);
+
+	std::unique_lock<std::mutex> lock(mLock);
+	auto it = mOrdinals.find(game);
+	if (it == mOrdinals.cend())
+		return;
+
+	mGames[it->second] = nullptr;
+	mFreeOrdinals.push_back(it->second);
+	mOrdinals.erase(it);
+	mBitsDirty = true;
 }
 
 void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>* values)
 {
+	mGeneration++;
+
 	// test if it exists before setting
 	if(type == NONE)
 	{
@@ -230,7 +279,7 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 		for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it ) {
 			if ((*it).type == type)
 			{
-				FilterDataDecl filterData = (*it);
+				const FilterDataDecl& filterData = (*it);
 				*(filterData.filteredByRef) = values->size() > 0;
 				filterData.currentFilteredKeys->clear();
 				for (std::vector<std::string>::const_iterator vit = values->cbegin(); vit != values->cend(); ++vit ) {
@@ -247,9 +296,11 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 
 void FileFilterIndex::clearAllFilters()
 {
+	mGeneration++;
+
 	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
 	{
-		FilterDataDecl filterData = (*it);
+		const FilterDataDecl& filterData = (*it);
 		*(filterData.filteredByRef) = false;
 		filterData.currentFilteredKeys->clear();
 	}
@@ -258,12 +309,16 @@ void FileFilterIndex::clearAllFilters()
 
 void FileFilterIndex::resetFilters()
 {
+	mGeneration++;
+
 	clearAllFilters();
 	setUIModeFilters();
 }
 
 void FileFilterIndex::setUIModeFilters()
 {
+	mGeneration++;
+
 	if(!Settings::getInstance()->getBool("ForceDisableFilters")){
 		if (UIModeController::getInstance()->isUIModeKiosk())
 		{
@@ -311,6 +366,8 @@ void FileFilterIndex::debugPrintIndexes()
 
 void FileFilterIndex::setTextFilter(const std::string text)
 {
+	mGeneration++;
+
 	mTextFilter = Utils::String::toUpper(text);
 }
 
@@ -320,75 +377,152 @@ bool FileFilterIndex::showFile(FileData* game)
 	if (!isFiltered())
 		return true;
 
-	// if folder, needs further inspection - i.e. see if folder contains at least one element
-	// that should be shown
-	if (game->getType() == FOLDER)
-	{
-		std::vector<FileData*> children = ((FolderData*) game)->getChildren();
-		// iterate through all of the children, until there's a match
-
-		for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it ) {
-			if (showFile(*it))
-				return true;
-		}
-		return false;
-	}
+	std::unique_lock<std::mutex> lock(mLock);
+	resolveFilters();
+	return isVisible(game);
+}
 
-	bool keepGoing = false;
+void FileFilterIndex::rebuildBits()
+{
+	for (auto& keys : mKeyBits)
+		keys.clear();
 
-	if (!mTextFilter.empty() && Utils::String::toUpper(game->getName()).find(mTextFilter) != std::string::npos)
-		keepGoing = true;
+	for (unsigned int ordinal = 0; ordinal < mGames.size(); ordinal++)
+	{
+		FileData* game = mGames[ordinal];
+		if (game == nullptr)
+			continue;
 
-	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it ) {
-		FilterDataDecl filterData = (*it);
-		if(*(filterData.filteredByRef))
+		for (size_t i = 0; i < filterDataDecl.size(); i++)
 		{
-			// try to find a match
-			std::string key = getIndexableKey(game, filterData.type, false);
-			keepGoing = isKeyBeingFilteredBy(key, filterData.type);
+			const FilterDataDecl& filterData = filterDataDecl[i];
 
-			// if we didn't find a match, try for secondary keys - i.e. publisher and dev, or first genre
-			if (!keepGoing)
+			mKeyBits[i][getIndexableKey(game, filterData.type, false)].set(ordinal);
+
+			// secondary keys - i.e. publisher and dev, or first genre - match as well
+			if (filterData.hasSecondaryKey)
 			{
-				if (!filterData.hasSecondaryKey)
-				{
-					return false;
-				}
 				std::string secKey = getIndexableKey(game, filterData.type, true);
 				if (secKey != UNKNOWN_LABEL)
-				{
-					keepGoing = isKeyBeingFilteredBy(secKey, filterData.type);
-				}
+					mKeyBits[i][secKey].set(ordinal);
 			}
-			// if still nothing, then it's not a match
-			if (!keepGoing)
-				return false;
+		}
+	}
+
+	mBitsDirty = false;
+}
 
+void FileFilterIndex::resolveFilters()
+{
+	unsigned int metadataGeneration = MetaDataList::getGeneration();
+	if (mResolvedGeneration == mGeneration && mResolvedMetadataGeneration == metadataGeneration && !mBitsDirty)
+		return;
+
+	// Keys are read from the metadata : any metadata change can move a game from a key to another
+	if (mBitsDirty || mResolvedMetadataGeneration != metadataGeneration)
+		rebuildBits();
+
+	mHasActiveFilter = false;
+
+	for (size_t i = 0; i < filterDataDecl.size(); i++)
+	{
+		const FilterDataDecl& filterData = filterDataDecl[i];
+		if (!*(filterData.filteredByRef))
+			continue;
+
+		if (!mHasActiveFilter)
+			mVisible.fill(mGames.size());
+
+		mHasActiveFilter = true;
+
+		FilterBitset matches;
+		for (auto& key : *filterData.currentFilteredKeys)
+		{
+			auto bits = mKeyBits[i].find(key);
+			if (bits != mKeyBits[i].cend())
+				matches.orWith(bits->second);
 		}
 
+		mVisible.andWith(matches);
 	}
 
-	return keepGoing;
+	mFolderVisibility.clear();
+	mResolvedGeneration = mGeneration;
+	mResolvedMetadataGeneration = metadataGeneration;
 }
 
-bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type)
+bool FileFilterIndex::isVisible(FileData* game)
 {
-	const FilterIndexType filterTypes[7] = { FAVORITES_FILTER, GENRE_FILTER, PLAYER_FILTER, PUBDEV_FILTER, RATINGS_FILTER, KIDGAME_FILTER, VERTICAL_FILTER }; // ,HIDDEN_FILTER
-	std::vector<std::string> filterKeysList[7] = { favoritesIndexFilteredKeys, genreIndexFilteredKeys, playersIndexFilteredKeys, pubDevIndexFilteredKeys, ratingsIndexFilteredKeys, kidGameIndexFilteredKeys, verticalIndexFilteredKeys }; // hiddenIndexFilteredKeys
-
-	for (int i = 0; i < 6; i++)
+	// if folder, needs further inspection - i.e. see if folder contains at least one element
+	// that should be shown
+	if (game->getType() == FOLDER)
 	{
-		if (filterTypes[i] == type)
+		auto cached = mFolderVisibility.find(game);
+		if (cached != mFolderVisibility.cend())
+			return cached->second;
+
+		bool visible = false;
+
+		for (auto child : ((FolderData*)game)->getChildren())
 		{
-			for (std::vector<std::string>::const_iterator it = filterKeysList[i].cbegin(); it != filterKeysList[i].cend(); ++it )
+			if (isVisible(child))
 			{
-				if (key == (*it))
-				{
-					return true;
-				}
+				visible = true;
+				break;
 			}
-			return false;
 		}
+
+		mFolderVisibility[game] = visible;
+		return visible;
+	}
+
+	// The text filter is only used when no other filter is active
+	if (!mHasActiveFilter)
+		return !mTextFilter.empty() && Utils::String::toUpper(game->getName()).find(mTextFilter) != std::string::npos;
+
+	auto it = mOrdinals.find(game);
+	if (it != mOrdinals.cend())
+		return mVisible.test(it->second);
+
+	// Not indexed here (e.g. a game from an imported index) : match its keys directly
+	return matchesFilters(game);
+}
+
+bool FileFilterIndex::matchesFilters(FileData* game)
+{
+	for (auto& filterData : filterDataDecl)
+	{
+		if (!*(filterData.filteredByRef))
+			continue;
+
+		// try to find a match
+		if (isKeyBeingFilteredBy(getIndexableKey(game, filterData.type, false), filterData.type))
+			continue;
+
+		// if we didn't find a match, try for secondary keys - i.e. publisher and dev, or first genre
+		if (!filterData.hasSecondaryKey)
+			return false;
+
+		std::string secKey = getIndexableKey(game, filterData.type, true);
+		if (secKey == UNKNOWN_LABEL || !isKeyBeingFilteredBy(secKey, filterData.type))
+			return false;
+	}
+
+	return true;
+}
+
+bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type)
+{
+	for (auto& filterData : filterDataDecl)
+	{
+		if (filterData.type != type)
+			continue;
+
+		for (auto& filteredKey : *filterData.currentFilteredKeys)
+			if (key == filteredKey)
+				return true;
+
+		return false;
 	}
 
 	return false;
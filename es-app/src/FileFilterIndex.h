@@ -3,10 +3,51 @@
 #define ES_APP_FILE_FILTER_INDEX_H
 
 #include <map>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 class FileData;
 
+// Dense set of game ordinals, combined a whole word at a time
+class FilterBitset
+{
+public:
+	void set(unsigned int bit)
+	{
+		if (bit / 64 >= mWords.size())
+			mWords.resize(bit / 64 + 1, 0);
+
+		mWords[bit / 64] |= 1ull << (bit % 64);
+	}
+
+	inline bool test(unsigned int bit) const { return bit / 64 < mWords.size() && (mWords[bit / 64] & (1ull << (bit % 64))) != 0; }
+
+	void fill(size_t count) { mWords.assign((count + 63) / 64, ~0ull); }
+	void clear() { mWords.clear(); }
+
+	void orWith(const FilterBitset& other)
+	{
+		if (other.mWords.size() > mWords.size())
+			mWords.resize(other.mWords.size(), 0);
+
+		for (size_t i = 0; i < other.mWords.size(); i++)
+			mWords[i] |= other.mWords[i];
+	}
+
+	void andWith(const FilterBitset& other)
+	{
+		if (mWords.size() > other.mWords.size())
+			mWords.resize(other.mWords.size());
+
+		for (size_t i = 0; i < mWords.size(); i++)
+			mWords[i] &= other.mWords[i];
+	}
+
+private:
+	std::vector<unsigned long long> mWords;
+};
+
 enum FilterIndexType
 {
 	NONE,
@@ -55,10 +96,18 @@ public:
 	void setTextFilter(const std::string text);
 	inline const std::string getTextFilter() { return mTextFilter; }
 
+	// Changes each time the filters or the indexed keys change
+	inline unsigned int getGeneration() const { return mGeneration; }
+
 private:
 	std::vector<FilterDataDecl> filterDataDecl;
 	std::string getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary);
 
+	bool isVisible(FileData* game);
+	bool matchesFilters(FileData* game);
+	void rebuildBits();
+	void resolveFilters();
+
 	void manageGenreEntryInIndex(FileData* game, bool remove = false);
 	void managePlayerEntryInIndex(FileData* game, bool remove = false);
 	void managePubDevEntryInIndex(FileData* game, bool remove = false);
@@ -101,6 +150,22 @@ private:
 
 	FileData* mRootFolder;
 	std::string mTextFilter;
+	unsigned int mGeneration;
+
+	// Each indexed game gets an ordinal. For every filter type, each key owns the bitset of the games having it.
+	// Active filters are resolved once (OR of the selected keys, AND between types) into mVisible.
+	std::mutex mLock;
+	std::unordered_map<FileData*, unsigned int> mOrdinals;
+	std::vector<FileData*> mGames;
+	std::vector<unsigned int> mFreeOrdinals;
+	std::vector<std::map<std::string, FilterBitset>> mKeyBits;
+	bool mBitsDirty;
+
+	FilterBitset mVisible;
+	bool mHasActiveFilter;
+	std::unordered_map<FileData*, bool> mFolderVisibility;
+	unsigned int mResolvedGeneration;
+	unsigned int mResolvedMetadataGeneration;
 };
 
 #endif // ES_APP_FILE_FILTER_INDEX_H
@@ -2,8 +2,149 @@
 #include "utils/StringUtil.h"
 #include "EsLocale.h"
 
+#include <algorithm>
+
 namespace FileSorts
 {
+	// Key builders, they mirror the compare* functions below
+	static void nameKey(FileData* file, SortKey& key)
+	{
+		key.number = file->getType() == FOLDER ? 0 : 1;
+
+		// Same folding as compareName : toupper on each byte, compared as unsigned chars like std::string::compare does
+		key.text = file->getName();
+		for (auto& c : key.text)
+			c = (char)toupper((unsigned char)c);
+	}
+
+	static void ratingKey(FileData* file, SortKey& key)
+	{
+		key.number = file->getMetadata().getFloat(MetaDataId::Rating);
+	}
+
+	static void timesPlayedKey(FileData* file, SortKey& key)
+	{
+		if (file->getMetadata().getType() == GAME_METADATA)
+			key.number = file->getMetadata().getInt(MetaDataId::PlayCount);
+	}
+
+	static void gameTimeKey(FileData* file, SortKey& key)
+	{
+		if (file->getMetadata().getType() == GAME_METADATA)
+			key.number = file->getMetadata().getInt(MetaDataId::GameTime);
+	}
+
+	static void lastPlayedKey(FileData* file, SortKey& key)
+	{
+		key.text = file->getMetadata().getString(MetaDataId::LastPlayed);
+	}
+
+	static void numPlayersKey(FileData* file, SortKey& key)
+	{
+		key.number = file->getMetadata().getInt(MetaDataId::Players);
+	}
+
+	static void releaseDateKey(FileData* file, SortKey& key)
+	{
+		key.text = file->getMetadata().getString(MetaDataId::ReleaseDate);
+	}
+
+	static void genreKey(FileData* file, SortKey& key)
+	{
+		key.text = Utils::String::toUpper(file->getMetadata().getString(MetaDataId::Genre));
+	}
+
+	static void developerKey(FileData* file, SortKey& key)
+	{
+		key.text = Utils::String::toUpper(file->getMetadata().getString(MetaDataId::Developer));
+	}
+
+	static void publisherKey(FileData* file, SortKey& key)
+	{
+		key.text = Utils::String::toUpper(file->getMetadata().getString(MetaDataId::Publisher));
+	}
+
+	static void systemKey(FileData* file, SortKey& key)
+	{
+		key.text = Utils::String::toUpper(file->getSystemName());
+	}
+
+	static void fileCreationDateKey(FileData* file, SortKey& key)
+	{
+		key.text = Utils::FileSystem::getFileCreationDate(file->getPath()).getIsoString();
+	}
+
+	static void systemReleaseYearKey(FileData* file, SortKey& key)
+	{
+		key.text = Utils::String::toUpper(file->getSystemName());
+		key.text2 = file->getMetadata().getString(MetaDataId::ReleaseDate).substr(0, 4);
+		key.text3 = Utils::String::toUpper(file->getName());
+	}
+
+	static void releaseYearSystemKey(FileData* file, SortKey& key)
+	{
+		key.text = file->getMetadata().getString(MetaDataId::ReleaseDate).substr(0, 4);
+		key.text2 = Utils::String::toUpper(file->getSystemName());
+		key.text3 = Utils::String::toUpper(file->getName());
+	}
+
+	static inline bool compareKeys(const SortKey& key1, const SortKey& key2)
+	{
+		if (key1.number != key2.number)
+			return key1.number < key2.number;
+
+		int cmp = key1.text.compare(key2.text);
+		if (cmp != 0)
+			return cmp < 0;
+
+		cmp = key1.text2.compare(key2.text2);
+		if (cmp != 0)
+			return cmp < 0;
+
+		return key1.text3.compare(key2.text3) < 0;
+	}
+
+	void sortFiles(std::vector<FileData*>& files, const SortType& sort, bool stable)
+	{
+		if (sort.keyFunction == nullptr)
+		{
+			if (stable)
+				std::stable_sort(files.begin(), files.end(), sort.comparisonFunction);
+			else
+				std::sort(files.begin(), files.end(), sort.comparisonFunction);
+		}
+		else
+		{
+			// Each key is built once per file, instead of twice per comparison
+			std::vector<SortKey> keys(files.size());
+			std::vector<unsigned int> order(files.size());
+
+			for (size_t i = 0; i < files.size(); i++)
+			{
+				sort.keyFunction(files[i], keys[i]);
+				order[i] = (unsigned int)i;
+			}
+
+			auto compare = [&keys](unsigned int a, unsigned int b) { return compareKeys(keys[a], keys[b]); };
+
+			if (stable)
+				std::stable_sort(order.begin(), order.end(), compare);
+			else
+				std::sort(order.begin(), order.end(), compare);
+
+			std::vector<FileData*> sorted;
+			sorted.reserve(files.size());
+
+			for (auto index : order)
+				sorted.push_back(files[index]);
+
+			files.swap(sorted);
+		}
+
+		if (!sort.ascending)
+			std::reverse(files.begin(), files.end());
+	}
+
 	static Singleton* sInstance = nullptr;
 
 	Singleton* getInstance()
@@ -38,35 +179,35 @@ namespace FileSorts
 
 	Singleton::Singleton()
 	{
-		mSortTypes.push_back(SortType(FILENAME_ASCENDING, &compareName, true, _("FILENAME, ASCENDING"), _U("\uF15d ")));
-		mSortTypes.push_back(SortType(FILENAME_DESCENDING, &compareName, false, _("FILENAME, DESCENDING"), _U("\uF15e ")));
-		mSortTypes.push_back(SortType(RATING_ASCENDING, &compareRating, true, _("RATING, ASCENDING"), _U("\uF165 ")));
-		mSortTypes.push_back(SortType(RATING_DESCENDING, &compareRating, false, _("RATING, DESCENDING"), _U("\uF164 ")));
-		mSortTypes.push_back(SortType(TIMESPLAYED_ASCENDING, &compareTimesPlayed, true, _("TIMES PLAYED, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(TIMESPLAYED_DESCENDING, &compareTimesPlayed, false, _("TIMES PLAYED, DESCENDING"), _U("\uF161 ")));
-		mSortTypes.push_back(SortType(LASTPLAYED_ASCENDING, &compareLastPlayed, true, _("LAST PLAYED, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(LASTPLAYED_DESCENDING, &compareLastPlayed, false, _("LAST PLAYED, DESCENDING"), _U("\uF161 ")));
-		mSortTypes.push_back(SortType(NUMBERPLAYERS_ASCENDING, &compareNumPlayers, true, _("NUMBER PLAYERS, ASCENDING"), _U("\uF162 ")));
-		mSortTypes.push_back(SortType(NUMBERPLAYERS_DESCENDING, &compareNumPlayers, false, _("NUMBER PLAYERS, DESCENDING"), _U("\uF163 ")));
-		mSortTypes.push_back(SortType(RELEASEDATE_ASCENDING, &compareReleaseDate, true, _("RELEASE DATE, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(RELEASEDATE_DESCENDING, &compareReleaseDate, false, _("RELEASE DATE, DESCENDING"), _U("\uF161 ")));
-		mSortTypes.push_back(SortType(GENRE_ASCENDING, &compareGenre, true, _("GENRE, ASCENDING"), _U("\uF15d ")));
-		mSortTypes.push_back(SortType(GENRE_DESCENDING, &compareGenre, false, _("GENRE, DESCENDING"), _U("\uF15e ")));
-		mSortTypes.push_back(SortType(DEVELOPER_ASCENDING, &compareDeveloper, true, _("DEVELOPER, ASCENDING"), _U("\uF15d ")));
-		mSortTypes.push_back(SortType(DEVELOPER_DESCENDING, &compareDeveloper, false, _("DEVELOPER, DESCENDING"), _U("\uF15e ")));
-		mSortTypes.push_back(SortType(PUBLISHER_ASCENDING, &comparePublisher, true, _("PUBLISHER, ASCENDING"), _U("\uF15d ")));
-		mSortTypes.push_back(SortType(PUBLISHER_DESCENDING, &comparePublisher, false, _("PUBLISHER, DESCENDING"), _U("\uF15e ")));
-		mSortTypes.push_back(SortType(SYSTEM_ASCENDING, &compareSystem, true, _("SYSTEM, ASCENDING"), _U("\uF15d ")));
-		mSortTypes.push_back(SortType(SYSTEM_DESCENDING, &compareSystem, false, _("SYSTEM, DESCENDING"), _U("\uF15e ")));
-		mSortTypes.push_back(SortType(FILECREATION_DATE_ASCENDING, &compareFileCreationDate, true, _("FILE CREATION DATE, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(FILECREATION_DATE_DESCENDING, &compareFileCreationDate, false, _("FILE CREATION DATE, DESCENDING"), _U("\uF161 ")));
-		mSortTypes.push_back(SortType(GAMETIME_ASCENDING, &compareGameTime, true, _("GAME TIME, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(GAMETIME_DESCENDING, &compareGameTime, false, _("GAME TIME, DESCENDING"), _U("\uF161 ")));
-
-		mSortTypes.push_back(SortType(SYSTEM_RELEASEDATE_ASCENDING, &compareSystemReleaseYear, true, _("SYSTEM, RELEASE YEAR, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(SYSTEM_RELEASEDATE_DESCENDING, &compareSystemReleaseYear, false, _("SYSTEM, RELEASE YEAR, DESCENDING"), _U("\uF161 ")));
-		mSortTypes.push_back(SortType(RELEASEDATE_SYSTEM_ASCENDING, &compareReleaseYearSystem, true, _("RELEASE YEAR, SYSTEM, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(RELEASEDATE_SYSTEM_DESCENDING, &compareReleaseYearSystem, false, _("RELEASE YEAR, SYSTEM, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(FILENAME_ASCENDING, &compareName, &nameKey, true, _("FILENAME, ASCENDING"), _U("\uF15d ")));
+		mSortTypes.push_back(SortType(FILENAME_DESCENDING, &compareName, &nameKey, false, _("FILENAME, DESCENDING"), _U("\uF15e ")));
+		mSortTypes.push_back(SortType(RATING_ASCENDING, &compareRating, &ratingKey, true, _("RATING, ASCENDING"), _U("\uF165 ")));
+		mSortTypes.push_back(SortType(RATING_DESCENDING, &compareRating, &ratingKey, false, _("RATING, DESCENDING"), _U("\uF164 ")));
+		mSortTypes.push_back(SortType(TIMESPLAYED_ASCENDING, &compareTimesPlayed, &timesPlayedKey, true, _("TIMES PLAYED, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(TIMESPLAYED_DESCENDING, &compareTimesPlayed, &timesPlayedKey, false, _("TIMES PLAYED, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(LASTPLAYED_ASCENDING, &compareLastPlayed, &lastPlayedKey, true, _("LAST PLAYED, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(LASTPLAYED_DESCENDING, &compareLastPlayed, &lastPlayedKey, false, _("LAST PLAYED, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(NUMBERPLAYERS_ASCENDING, &compareNumPlayers, &numPlayersKey, true, _("NUMBER PLAYERS, ASCENDING"), _U("\uF162 ")));
+		mSortTypes.push_back(SortType(NUMBERPLAYERS_DESCENDING, &compareNumPlayers, &numPlayersKey, false, _("NUMBER PLAYERS, DESCENDING"), _U("\uF163 ")));
+		mSortTypes.push_back(SortType(RELEASEDATE_ASCENDING, &compareReleaseDate, &releaseDateKey, true, _("RELEASE DATE, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(RELEASEDATE_DESCENDING, &compareReleaseDate, &releaseDateKey, false, _("RELEASE DATE, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(GENRE_ASCENDING, &compareGenre, &genreKey, true, _("GENRE, ASCENDING"), _U("\uF15d ")));
+		mSortTypes.push_back(SortType(GENRE_DESCENDING, &compareGenre, &genreKey, false, _("GENRE, DESCENDING"), _U("\uF15e ")));
+		mSortTypes.push_back(SortType(DEVELOPER_ASCENDING, &compareDeveloper, &developerKey, true, _("DEVELOPER, ASCENDING"), _U("\uF15d ")));
+		mSortTypes.push_back(SortType(DEVELOPER_DESCENDING, &compareDeveloper, &developerKey, false, _("DEVELOPER, DESCENDING"), _U("\uF15e ")));
+		mSortTypes.push_back(SortType(PUBLISHER_ASCENDING, &comparePublisher, &publisherKey, true, _("PUBLISHER, ASCENDING"), _U("\uF15d ")));
+		mSortTypes.push_back(SortType(PUBLISHER_DESCENDING, &comparePublisher, &publisherKey, false, _("PUBLISHER, DESCENDING"), _U("\uF15e ")));
+		mSortTypes.push_back(SortType(SYSTEM_ASCENDING, &compareSystem, &systemKey, true, _("SYSTEM, ASCENDING"), _U("\uF15d ")));
+		mSortTypes.push_back(SortType(SYSTEM_DESCENDING, &compareSystem, &systemKey, false, _("SYSTEM, DESCENDING"), _U("\uF15e ")));
+		mSortTypes.push_back(SortType(FILECREATION_DATE_ASCENDING, &compareFileCreationDate, &fileCreationDateKey, true, _("FILE CREATION DATE, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(FILECREATION_DATE_DESCENDING, &compareFileCreationDate, &fileCreationDateKey, false, _("FILE CREATION DATE, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(GAMETIME_ASCENDING, &compareGameTime, &gameTimeKey, true, _("GAME TIME, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(GAMETIME_DESCENDING, &compareGameTime, &gameTimeKey, false, _("GAME TIME, DESCENDING"), _U("\uF161 ")));
+
+		mSortTypes.push_back(SortType(SYSTEM_RELEASEDATE_ASCENDING, &compareSystemReleaseYear, &systemReleaseYearKey, true, _("SYSTEM, RELEASE YEAR, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(SYSTEM_RELEASEDATE_DESCENDING, &compareSystemReleaseYear, &systemReleaseYearKey, false, _("SYSTEM, RELEASE YEAR, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(RELEASEDATE_SYSTEM_ASCENDING, &compareReleaseYearSystem, &releaseYearSystemKey, true, _("RELEASE YEAR, SYSTEM, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(RELEASEDATE_SYSTEM_DESCENDING, &compareReleaseYearSystem, &releaseYearSystemKey, false, _("RELEASE YEAR, SYSTEM, DESCENDING"), _U("\uF161 ")));
 	}
 
 	//returns if file1 should come before file2
@@ -87,8 +228,8 @@ namespace FileSorts
 			if (*ap == 0 || *bp == 0)
 				return false;
 
-			auto c1 = toupper(*ap);
-			auto c2 = toupper(*bp);
+			auto c1 = toupper((unsigned char)*ap);
+			auto c2 = toupper((unsigned char)*bp);
 			if (c1 != c2)
 				return c1 < c2;
 		}
@@ -98,7 +239,7 @@ namespace FileSorts
 
 	bool compareRating(const FileData* file1, const FileData* file2)
 	{
-		return file1->getMetadata().getFloat("rating") < file2->getMetadata().getFloat("rating");
+		return file1->getMetadata().getFloat(MetaDataId::Rating) < file2->getMetadata().getFloat(MetaDataId::Rating);
 	}
 
 	bool compareTimesPlayed(const FileData* file1, const FileData* file2)
@@ -106,7 +247,7 @@ namespace FileSorts
 		//only games have playcount metadata
 		if (file1->getMetadata().getType() == GAME_METADATA && file2->getMetadata().getType() == GAME_METADATA)
 		{
-			return (file1)->getMetadata().getInt("playcount") < (file2)->getMetadata().getInt("playcount");
+			return (file1)->getMetadata().getInt(MetaDataId::PlayCount) < (file2)->getMetadata().getInt(MetaDataId::PlayCount);
 		}
 
 		return false;
@@ -116,7 +257,7 @@ namespace FileSorts
 	{
 		//only games have playcount metadata
 		if (file1->getMetadata().getType() == GAME_METADATA && file2->getMetadata().getType() == GAME_METADATA)
-			return (file1)->getMetadata().getInt("gametime") < (file2)->getMetadata().getInt("gametime");
+			return (file1)->getMetadata().getInt(MetaDataId::GameTime) < (file2)->getMetadata().getInt(MetaDataId::GameTime);
 
 		return false;
 	}
@@ -125,12 +266,12 @@ namespace FileSorts
 	{
 		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
 		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->getMetadata().get("lastplayed") < (file2)->getMetadata().get("lastplayed");
+		return (file1)->getMetadata().getString(MetaDataId::LastPlayed) < (file2)->getMetadata().getString(MetaDataId::LastPlayed);
 	}
 
 	bool compareNumPlayers(const FileData* file1, const FileData* file2)
 	{
-		return (file1)->getMetadata().getInt("players") < (file2)->getMetadata().getInt("players");
+		return (file1)->getMetadata().getInt(MetaDataId::Players) < (file2)->getMetadata().getInt(MetaDataId::Players);
 	}
 
 	bool compareSystemReleaseYear(const FileData* file1, const FileData* file2)
@@ -140,8 +281,8 @@ namespace FileSorts
 
 		if (system1 == system2)
 		{
-			std::string year1 = file1->getMetadata().get("releasedate").substr(0, 4);
-			std::string year2 = file2->getMetadata().get("releasedate").substr(0, 4);
+			std::string year1 = file1->getMetadata().getString(MetaDataId::ReleaseDate).substr(0, 4);
+			std::string year2 = file2->getMetadata().getString(MetaDataId::ReleaseDate).substr(0, 4);
 
 			if (year1 == year2)
 				return Utils::String::compareIgnoreCase(((FileData*)file1)->getName(), ((FileData*)file2)->getName()) < 0;
@@ -153,8 +294,8 @@ namespace FileSorts
 
 	bool compareReleaseYearSystem(const FileData* file1, const FileData* file2)
 	{
-		std::string year1 = file1->getMetadata().get("releasedate").substr(0, 4);
-		std::string year2 = file2->getMetadata().get("releasedate").substr(0, 4);
+		std::string year1 = file1->getMetadata().getString(MetaDataId::ReleaseDate).substr(0, 4);
+		std::string year2 = file2->getMetadata().getString(MetaDataId::ReleaseDate).substr(0, 4);
 
 		if (year1 == year2)
 		{
@@ -174,7 +315,7 @@ namespace FileSorts
 	{
 		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
 		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->getMetadata().get("releasedate") < (file2)->getMetadata().get("releasedate");
+		return (file1)->getMetadata().getString(MetaDataId::ReleaseDate) < (file2)->getMetadata().getString(MetaDataId::ReleaseDate);
 	}
 
 	bool compareFileCreationDate(const FileData* file1, const FileData* file2)
@@ -187,22 +328,22 @@ namespace FileSorts
 
 	bool compareGenre(const FileData* file1, const FileData* file2)
 	{
-		std::string genre1 = Utils::String::toUpper(file1->getMetadata().get("genre"));
-		std::string genre2 = Utils::String::toUpper(file2->getMetadata().get("genre"));
+		std::string genre1 = Utils::String::toUpper(file1->getMetadata().getString(MetaDataId::Genre));
+		std::string genre2 = Utils::String::toUpper(file2->getMetadata().getString(MetaDataId::Genre));
 		return genre1.compare(genre2) < 0;
 	}
 
 	bool compareDeveloper(const FileData* file1, const FileData* file2)
 	{
-		std::string developer1 = Utils::String::toUpper(file1->getMetadata().get("developer"));
-		std::string developer2 = Utils::String::toUpper(file2->getMetadata().get("developer"));
+		std::string developer1 = Utils::String::toUpper(file1->getMetadata().getString(MetaDataId::Developer));
+		std::string developer2 = Utils::String::toUpper(file2->getMetadata().getString(MetaDataId::Developer));
 		return developer1.compare(developer2) < 0;
 	}
 
 	bool comparePublisher(const FileData* file1, const FileData* file2)
 	{
-		std::string publisher1 = Utils::String::toUpper(file1->getMetadata().get("publisher"));
-		std::string publisher2 = Utils::String::toUpper(file2->getMetadata().get("publisher"));
+		std::string publisher1 = Utils::String::toUpper(file1->getMetadata().getString(MetaDataId::Publisher));
+		std::string publisher2 = Utils::String::toUpper(file2->getMetadata().getString(MetaDataId::Publisher));
 		return publisher1.compare(publisher2) < 0;
 	}
 
@@ -42,16 +42,30 @@ namespace FileSorts
 
 	typedef bool ComparisonFunction(const FileData* a, const FileData* b);
 
+	// Precomputed sort key : once built, comparing two files is a number comparison followed by memcmps
+	struct SortKey
+	{
+		SortKey() : number(0) { }
+
+		double      number;
+		std::string text;
+		std::string text2;
+		std::string text3;
+	};
+
+	typedef void SortKeyFunction(FileData* file, SortKey& key);
+
 	struct SortType
 	{
 		int id;
 		ComparisonFunction* comparisonFunction;
+		SortKeyFunction* keyFunction;
 		bool ascending;
 		std::string description;
 		std::string icon;
 
-		SortType(int sortId, ComparisonFunction* sortFunction, bool sortAscending, const std::string & sortDescription, const std::string & iconId = "")
-			: id(sortId), comparisonFunction(sortFunction), ascending(sortAscending), description(sortDescription), icon(iconId) {}
+		SortType(int sortId, ComparisonFunction* sortFunction, SortKeyFunction* sortKeyFunction, bool sortAscending, const std::string & sortDescription, const std::string & iconId = "")
+			: id(sortId), comparisonFunction(sortFunction), keyFunction(sortKeyFunction), ascending(sortAscending), description(sortDescription), icon(iconId) {}
 	};
 
 	class Singleton
@@ -66,6 +80,9 @@ namespace FileSorts
 	SortType getSortType(int sortId);
 	const std::vector<SortType>& getSortTypes();
 
+	// Sorts using the precomputed keys of the sort type, then reverses the list if the sort is descending
+	void sortFiles(std::vector<FileData*>& files, const SortType& sort, bool stable = false);
+
 	bool compareName(const FileData* file1, const FileData* file2);
 	bool compareRating(const FileData* file1, const FileData* file2);
 	bool compareTimesPlayed(const FileData* file1, const FileData* fil2);
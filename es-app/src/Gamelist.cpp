@@ -4,6 +4,7 @@
 #include "utils/StringUtil.h"
 #include "FileData.h"
 #include "FileFilterIndex.h"
+#include "GamelistCache.h"
 #include "Log.h"
 #include "Settings.h"
 #include "SystemData.h"
@@ -99,16 +100,14 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 	return NULL;
 }
 
-void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize = SIZE_MAX)
-{	
-	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
-
+bool readGamelistEntries(const std::string xmlpath, SystemData* system, const GamelistCache::EntryCallback& onEntry, size_t checkSize)
+{
 	LOG(LogInfo) << "Gamelist::loadGamelistFile() - Parsing XML file \"" << xmlpath << "\"...";
 
 	if ( !Utils::String::endsWith(xmlpath, ".xml") )
 	{
 		LOG(LogWarning) << "Gamelist::loadGamelistFile() - file \"" << xmlpath << "\" isn't a XML file, skipped!";
-		return;
+		return false;
 	}
 
 	pugi::xml_document doc;
@@ -117,14 +116,14 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 	if (!result)
 	{
 		LOG(LogError) << "Gamelist::loadGamelistFile() - Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-		return;
+		return false;
 	}
 
 	pugi::xml_node root = doc.child("gameList");
 	if (!root)
 	{
 		LOG(LogError) << "Gamelist::loadGamelistFile() - Could not find <gameList> node in gamelist \"" << xmlpath << "\"!";
-		return;
+		return false;
 	}
 
 	if (checkSize != SIZE_MAX)
@@ -133,11 +132,9 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 		if (parentSize != checkSize)
 		{
 			LOG(LogWarning) << "Gamelist::loadGamelistFile() - gamelist size don't match !";
-			return;
+			return false;
 		}
 	}
-	
-	std::string relativeTo = system->getStartPath();
 
 	for (pugi::xml_node fileNode : root.children())
 	{
@@ -150,23 +147,41 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 		else if (tag != "game")
 			continue;
 
-		const std::string path = Utils::FileSystem::resolveRelativePath(fileNode.child("path").text().get(), relativeTo, false);
+		MetaDataList metadata = MetaDataList::createFromXML(type == FOLDER ? FOLDER_METADATA : GAME_METADATA, fileNode, system);
+		onEntry(type, fileNode.child("path").text().get(), metadata);
+	}
+
+	return true;
+}
+
+void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize = SIZE_MAX)
+{	
+	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
+
+	// Only the main gamelist is snapshotted, recovery files are small & short-lived
+	bool useCache = checkSize == SIZE_MAX && Settings::getInstance()->getBool("UseGamelistCache");
+
+	std::string relativeTo = system->getStartPath();
+
+	auto addEntry = [&](FileType type, const std::string& entryPath, MetaDataList& metadata)
+	{
+		const std::string path = Utils::FileSystem::resolveRelativePath(entryPath, relativeTo, false);
 		if (!trustGamelist && !Utils::FileSystem::exists(path))
 		{
 			LOG(LogWarning) << "Gamelist::loadGamelistFile() - File \"" << path << "\" does not exist! Ignoring.";
-			continue;
+			return;
 		}
 
 		FileData* file = findOrCreateFile(system, path, type, fileMap);
 		if (!file)
 		{
 			LOG(LogError) << "Gamelist::loadGamelistFile() - Error finding/creating FileData for \"" << path << "\", skipping.";
-			continue;
+			return;
 		}
 		else if (!file->isArcadeAsset())
 		{
 			std::string defaultName = file->getMetadata().get("name");
-			file->setMetadata(MetaDataList::createFromXML(type == FOLDER ? FOLDER_METADATA : GAME_METADATA, fileNode, system));
+			file->setMetadata(metadata);
 
 			//make sure name gets set if one didn't exist
 			if (file->getMetadata().get("name").empty())
@@ -180,7 +195,28 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 			else
 				file->getMetadata().resetChangedFlag();
 		}
+	};
+
+	if (useCache && GamelistCache::load(system, xmlpath, addEntry))
+		return;
+
+	if (!useCache)
+	{
+		readGamelistEntries(xmlpath, system, addEntry, checkSize);
+		return;
 	}
+
+	// Snapshot the raw entries while they're applied
+	GamelistCache::Writer writer(system, xmlpath);
+
+	bool read = readGamelistEntries(xmlpath, system, [&](FileType type, const std::string& entryPath, MetaDataList& metadata)
+	{
+		writer.add(type, entryPath, metadata);
+		addEntry(type, entryPath, metadata);
+	}, checkSize);
+
+	if (read)
+		writer.save();
 }
 
 std::string getTemporaryGamelistRecovery(SystemData* system)
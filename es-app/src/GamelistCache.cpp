@@ -0,0 +1,352 @@
+#include "GamelistCache.h"
+
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "SystemData.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#define GAMELIST_CACHE_MAGIC	0x4C475345 // "ESGL"
+#define GAMELIST_CACHE_VERSION	3
+
+namespace
+{
+	struct CacheHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int declHash;     // invalidates the snapshot when the metadata declarations change
+		unsigned int pathHash;     // gamelist.xml path the snapshot was built from
+		unsigned int configHash;   // es_systems.cfg <system> entry
+		unsigned long long gamelistSize;
+		long long gamelistTime;
+		long long gamelistTimeNs;
+		unsigned int entryCount;
+		unsigned int valueCount;
+		unsigned int stringCount;
+		unsigned int stringBytes;
+	};
+
+	struct EntryRecord
+	{
+		unsigned char  type;
+		unsigned char  pad;
+		unsigned short valueCount;
+		unsigned int   path;
+		unsigned int   name;
+		unsigned int   firstValue;
+	};
+
+	struct ValueRecord
+	{
+		unsigned char id;
+		unsigned char pad[3];
+		unsigned int  string;
+	};
+
+	class StringTable
+	{
+	public:
+		unsigned int add(const std::string& value)
+		{
+			auto it = mIndexes.find(value);
+			if (it != mIndexes.cend())
+				return it->second;
+
+			unsigned int index = (unsigned int)mOffsets.size();
+			mOffsets.push_back((unsigned int)mBlob.size());
+			mBlob.append(value);
+			mIndexes[value] = index;
+			return index;
+		}
+
+		unsigned int count() const { return (unsigned int)mOffsets.size(); }
+
+		std::vector<unsigned int> offsets() const
+		{
+			std::vector<unsigned int> ret = mOffsets;
+			ret.push_back((unsigned int)mBlob.size());
+			return ret;
+		}
+
+		const std::string& blob() const { return mBlob; }
+
+	private:
+		std::unordered_map<std::string, unsigned int> mIndexes;
+		std::vector<unsigned int> mOffsets;
+		std::string mBlob;
+	};
+
+	unsigned int getDeclHash()
+	{
+		std::string decls;
+
+		for (auto type : { GAME_METADATA, FOLDER_METADATA })
+		{
+			for (auto& mdd : getMDDByType(type))
+			{
+				decls += std::to_string(mdd.id) + ":" + mdd.key + "=" + mdd.defaultValue + ";";
+			}
+
+			decls += "|";
+		}
+
+		return GamelistCache::hashString(decls);
+	}
+
+	bool getGamelistStat(const std::string& xmlpath, struct stat& info)
+	{
+		return stat(xmlpath.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+	}
+}
+
+unsigned int GamelistCache::hashString(const std::string& value)
+{
+	// FNV-1a : std::hash isn't guaranteed to be stable between builds
+	unsigned int hash = 2166136261u;
+
+	for (auto c : value)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+std::string GamelistCache::getCachePath(SystemData* system)
+{
+	return Utils::FileSystem::getEsConfigPath() + "/cache/gamelists/" + system->getName() + ".bin";
+}
+
+static unsigned int getConfigHash(SystemData* system)
+{
+	return system->getSystemEnvData() == nullptr ? 0 : system->getSystemEnvData()->mConfigHash;
+}
+
+bool GamelistCache::load(SystemData* system, const std::string& xmlpath, const EntryCallback& onEntry)
+{
+	struct stat xmlInfo;
+	if (!getGamelistStat(xmlpath, xmlInfo))
+		return false;
+
+	std::string path = getCachePath(system);
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(CacheHeader))
+	{
+		close(fd);
+		return false;
+	}
+
+	size_t size = (size_t)info.st_size;
+	void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED)
+		return false;
+
+	const char* data = (const char*)map;
+	const CacheHeader* header = (const CacheHeader*)data;
+
+	bool valid =
+		header->magic == GAMELIST_CACHE_MAGIC &&
+		header->version == GAMELIST_CACHE_VERSION &&
+		header->declHash == getDeclHash() &&
+		header->pathHash == hashString(xmlpath) &&
+		header->configHash == getConfigHash(system) &&
+		header->gamelistSize == (unsigned long long)xmlInfo.st_size &&
+		header->gamelistTime == (long long)xmlInfo.st_mtim.tv_sec &&
+		header->gamelistTimeNs == (long long)xmlInfo.st_mtim.tv_nsec;
+
+	size_t entriesOffset = sizeof(CacheHeader);
+	size_t valuesOffset = entriesOffset + (size_t)header->entryCount * sizeof(EntryRecord);
+	size_t offsetsOffset = valuesOffset + (size_t)header->valueCount * sizeof(ValueRecord);
+	size_t blobOffset = offsetsOffset + ((size_t)header->stringCount + 1) * sizeof(unsigned int);
+
+	if (valid && blobOffset + header->stringBytes != size)
+	{
+		LOG(LogWarning) << "GamelistCache::load() - Truncated cache file \"" << path << "\", ignoring it";
+		valid = false;
+	}
+
+	if (valid)
+	{
+		const EntryRecord* records = (const EntryRecord*)(data + entriesOffset);
+		const ValueRecord* values = (const ValueRecord*)(data + valuesOffset);
+		const unsigned int* offsets = (const unsigned int*)(data + offsetsOffset);
+		const char* blob = data + blobOffset;
+
+		for (unsigned int i = 0; valid && i < header->stringCount; i++)
+			valid = offsets[i] <= offsets[i + 1] && offsets[i + 1] <= header->stringBytes;
+
+		auto getString = [&](unsigned int index) { return std::string(blob + offsets[index], offsets[index + 1] - offsets[index]); };
+
+		// Check every record before handing out the first entry
+		for (unsigned int i = 0; valid && i < header->entryCount; i++)
+		{
+			const EntryRecord& record = records[i];
+
+			valid = (record.type == GAME || record.type == FOLDER) &&
+				record.path < header->stringCount && record.name < header->stringCount &&
+				(size_t)record.firstValue + record.valueCount <= header->valueCount;
+
+			for (unsigned int v = record.firstValue; valid && v < record.firstValue + record.valueCount; v++)
+				valid = values[v].id != MetaDataId::Name && values[v].id < MetaDataId::COUNT && values[v].string < header->stringCount;
+		}
+
+		if (!valid)
+		{
+			LOG(LogWarning) << "GamelistCache::load() - Corrupted cache file \"" << path << "\", ignoring it";
+		}
+
+		for (unsigned int i = 0; valid && i < header->entryCount; i++)
+		{
+			const EntryRecord& record = records[i];
+
+			MetaDataList mdl(record.type == FOLDER ? FOLDER_METADATA : GAME_METADATA);
+			mdl.mRelativeTo = system;
+			mdl.mName = getString(record.name);
+
+			for (unsigned int v = record.firstValue; v < record.firstValue + record.valueCount; v++)
+				mdl.setRawValue(values[v].id, getString(values[v].string));
+
+			onEntry((FileType)record.type, getString(record.path), mdl);
+		}
+	}
+
+	unsigned int entryCount = header->entryCount;
+	munmap(map, size);
+
+	if (!valid)
+		return false;
+
+	LOG(LogInfo) << "GamelistCache::load() - Restored " << entryCount << " entries from \"" << path << "\"";
+	return true;
+}
+
+struct GamelistCache::Writer::Data
+{
+	StringTable strings;
+	std::vector<EntryRecord> records;
+	std::vector<ValueRecord> values;
+};
+
+GamelistCache::Writer::Writer(SystemData* system, const std::string& xmlpath) : mSystem(system), mXmlPath(xmlpath), mData(new Data())
+{
+}
+
+GamelistCache::Writer::~Writer()
+{
+}
+
+void GamelistCache::Writer::add(FileType type, const std::string& path, const MetaDataList& metadata)
+{
+	StringTable& strings = mData->strings;
+	std::vector<ValueRecord>& values = mData->values;
+
+	EntryRecord record;
+	memset(&record, 0, sizeof(EntryRecord));
+	record.type = (unsigned char)type;
+	record.path = strings.add(path);
+	record.name = strings.add(metadata.mName);
+	record.firstValue = (unsigned int)values.size();
+
+	for (auto& mdd : metadata.getMDD())
+	{
+		if (mdd.id == MetaDataId::Name || !metadata.hasValue(mdd.id))
+			continue;
+
+		ValueRecord value;
+		memset(&value, 0, sizeof(ValueRecord));
+		value.id = mdd.id;
+		value.string = strings.add(metadata.getRawValue(mdd.id));
+		values.push_back(value);
+	}
+
+	record.valueCount = (unsigned short)(values.size() - record.firstValue);
+	mData->records.push_back(record);
+}
+
+bool GamelistCache::Writer::save()
+{
+	const std::string& xmlpath = mXmlPath;
+	SystemData* system = mSystem;
+
+	struct stat xmlInfo;
+	if (!getGamelistStat(xmlpath, xmlInfo))
+		return false;
+
+	const StringTable& strings = mData->strings;
+	const std::vector<EntryRecord>& records = mData->records;
+	const std::vector<ValueRecord>& values = mData->values;
+
+	std::vector<unsigned int> offsets = strings.offsets();
+
+	CacheHeader header;
+	memset(&header, 0, sizeof(CacheHeader));
+	header.magic = GAMELIST_CACHE_MAGIC;
+	header.version = GAMELIST_CACHE_VERSION;
+	header.declHash = getDeclHash();
+	header.pathHash = hashString(xmlpath);
+	header.configHash = getConfigHash(system);
+	header.gamelistSize = (unsigned long long)xmlInfo.st_size;
+	header.gamelistTime = (long long)xmlInfo.st_mtim.tv_sec;
+	header.gamelistTimeNs = (long long)xmlInfo.st_mtim.tv_nsec;
+	header.entryCount = (unsigned int)records.size();
+	header.valueCount = (unsigned int)values.size();
+	header.stringCount = strings.count();
+	header.stringBytes = (unsigned int)strings.blob().size();
+
+	std::string path = getCachePath(system);
+	std::string folder = Utils::FileSystem::getParent(path);
+	if (!Utils::FileSystem::exists(folder))
+		Utils::FileSystem::createDirectory(folder);
+
+	// Write to a temporary file first, the snapshot can be mapped by another system being loaded
+	std::string tmpFile = path + ".tmp";
+
+	FILE* file = fopen(tmpFile.c_str(), "wb");
+	if (file == nullptr)
+	{
+		LOG(LogError) << "GamelistCache::Writer::save() - Unable to create \"" << tmpFile << "\"";
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(CacheHeader), 1, file) == 1;
+
+	if (ok && records.size() > 0)
+		ok = fwrite(records.data(), sizeof(EntryRecord), records.size(), file) == records.size();
+
+	if (ok && values.size() > 0)
+		ok = fwrite(values.data(), sizeof(ValueRecord), values.size(), file) == values.size();
+
+	if (ok)
+		ok = fwrite(offsets.data(), sizeof(unsigned int), offsets.size(), file) == offsets.size();
+
+	if (ok && strings.blob().size() > 0)
+		ok = fwrite(strings.blob().data(), 1, strings.blob().size(), file) == strings.blob().size();
+
+	if (fclose(file) != 0)
+		ok = false;
+
+	if (!ok || std::rename(tmpFile.c_str(), path.c_str()) != 0)
+	{
+		LOG(LogError) << "GamelistCache::Writer::save() - Error writing \"" << path << "\"";
+		Utils::FileSystem::removeFile(tmpFile);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_CACHE_H
+#define ES_APP_GAMELIST_CACHE_H
+
+#include "FileData.h"
+#include "MetaData.h"
+#include <functional>
+#include <memory>
+#include <string>
+
+class SystemData;
+
+// Binary snapshot of a system's gamelist.xml, stored in [ES config path]/cache/gamelists/[system].bin
+//
+// The file is made of a header, fixed-size entry & metadata records and a string table where
+// every distinct string (paths, developers, genres...) is stored only once. It is memory mapped
+// at load time, so restoring a system is a matter of walking the records instead of building
+// a XML DOM and looking up every metadata by name.
+//
+// A snapshot is only used if the size & modification time of the gamelist and the hash of the
+// es_systems.cfg <system> entry still match, otherwise the caller must parse the XML again.
+class GamelistCache
+{
+public:
+	// path is the raw <path> value, as written in the gamelist
+	typedef std::function<void(FileType type, const std::string& path, MetaDataList& metadata)> EntryCallback;
+
+	// Calls onEntry for every entry of a valid snapshot. Nothing is called if the snapshot is invalid
+	static bool load(SystemData* system, const std::string& xmlpath, const EntryCallback& onEntry);
+
+	// Builds a snapshot while the XML is being read, keeping only the compact records in memory
+	class Writer
+	{
+	public:
+		Writer(SystemData* system, const std::string& xmlpath);
+		~Writer();
+
+		void add(FileType type, const std::string& path, const MetaDataList& metadata);
+		bool save();
+
+	private:
+		struct Data;
+
+		SystemData* mSystem;
+		std::string mXmlPath;
+		std::unique_ptr<Data> mData;
+	};
+
+	static unsigned int hashString(const std::string& value);
+
+private:
+	static std::string getCachePath(SystemData* system);
+};
+
+#endif // ES_APP_GAMELIST_CACHE_H
@@ -8,6 +8,9 @@
 #include "Settings.h"
 #include "ImageIO.h"
 
+#include <mutex>
+#include <unordered_map>
+
 MetaDataDecl gameDecls[] = {
 	//    key,           type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
 	{ 0,  "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
@@ -40,78 +43,143 @@ MetaDataDecl folderDecls[] = {
 	{ 0,  "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
 //	{ 1,  "sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
 	{ 2,  "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
-	{ 3,  "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
-	{ 4,  "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
-	{ 5,  "video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
-	{ 6,  "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
-	{ 7,  "rating",      MD_RATING,              "0.000000",         false,      "rating",               "enter rating"},
-	{ 8,  "releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
-	{ 9,  "developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
-	{ 10, "publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
-	{ 11, "genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
-	{ 12, "players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
-	{ 13, "favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on" },
-	{ 14, "hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
+	{ 5,  "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
+	{ 8,  "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
+	{ 6,  "video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
+	{ 7,  "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
+	{ 9,  "rating",      MD_RATING,              "0.000000",         false,      "rating",               "enter rating"},
+	{ 10, "releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
+	{ 11, "developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
+	{ 12, "publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
+	{ 13, "genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
+	{ 14, "players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
+	{ 15, "favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on" },
+	{ 16, "hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
 };
 
 const std::vector<MetaDataDecl> folderMDD(folderDecls, folderDecls + sizeof(folderDecls) / sizeof(folderDecls[0]));
 
-std::map<std::string, unsigned char> MetaDataList::mGameIdMap = MetaDataList::BuildIdMap(GAME_METADATA);
-std::map<std::string, unsigned char> MetaDataList::mFolderIdMap = MetaDataList::BuildIdMap(FOLDER_METADATA);
+#define METADATA_POOL_SHARDS	16
 
-std::map<unsigned char, MetaDataType> MetaDataList::mGameTypeMap = MetaDataList::BuildTypeMap(GAME_METADATA);
-std::map<unsigned char, MetaDataType> MetaDataList::mFolderTypeMap = MetaDataList::BuildTypeMap(FOLDER_METADATA);
+namespace
+{
+	// Values shared by all the lists. Sharded by hash, so the threaded gamelist loaders rarely wait for each other
+	class MetaDataValuePool
+	{
+	public:
+		static MetaDataValuePool* getInstance()
+		{
+			static MetaDataValuePool* sInstance = new MetaDataValuePool();
+			return sInstance;
+		}
 
-std::map<unsigned char, std::string> MetaDataList::mDefaultGameMap = MetaDataList::BuildDefaultMap(GAME_METADATA);
-std::map<unsigned char, std::string> MetaDataList::mDefaultFolderMap = MetaDataList::BuildDefaultMap(FOLDER_METADATA);
+		// The value is returned with a reference added
+		const MetaDataValue* intern(const std::string& text)
+		{
+			Shard& shard = mShards[std::hash<std::string>()(text) % METADATA_POOL_SHARDS];
+			std::unique_lock<std::mutex> lock(shard.lock);
+
+			auto it = shard.values.find(text);
+			if (it != shard.values.end())
+			{
+				it->second.refs++;
+				return &it->second;
+			}
+
+			MetaDataValue& value = shard.values[text];
+			value.text = text;
+			value.intValue = atoi(text.c_str());
+			value.floatValue = (float)atof(text.c_str());
+			value.boolValue = (text == "true");
+			value.refs = 1;
+			return &value;
+		}
 
-std::map<unsigned char, MetaDataType> MetaDataList::BuildTypeMap(MetaDataListType type)
-{
-	std::map<unsigned char, MetaDataType> ret;
+		void releaseUnused()
+		{
+			size_t released = 0;
+
+			for (auto& shard : mShards)
+			{
+				std::unique_lock<std::mutex> lock(shard.lock);
+
+				for (auto it = shard.values.begin(); it != shard.values.end(); )
+				{
+					if (it->second.refs.load() == 0)
+					{
+						it = shard.values.erase(it);
+						released++;
+					}
+					else
+						it++;
+				}
+			}
+
+			LOG(LogDebug) << "MetaDataValuePool - Released " << released << " unused values";
+		}
 
-	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
-	for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		ret[iter->id] = iter->type;
+	private:
+		struct Shard
+		{
+			std::mutex lock;
+			std::unordered_map<std::string, MetaDataValue> values; // node based : pointers stay valid on rehash
+		};
 
-	return ret;
+		Shard mShards[METADATA_POOL_SHARDS];
+	};
 }
 
-std::map<std::string, unsigned char> MetaDataList::BuildIdMap(MetaDataListType type)
-{
-	std::map<std::string, unsigned char> ret;
-
-	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
-	for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		ret[iter->key] = iter->id;
+std::map<std::string, unsigned char> MetaDataList::mIdMap;
+MetaDataType MetaDataList::mTypes[MetaDataId::COUNT];
+bool MetaDataList::mInternedIds[MetaDataId::COUNT];
+const MetaDataValue* MetaDataList::mDefaultValues[MetaDataId::COUNT];
 
-	return ret;
-}
+std::atomic<unsigned int> MetaDataList::mGeneration(0);
+bool MetaDataList::mTablesBuilt = MetaDataList::BuildTables();
 
-std::map<unsigned char, std::string> MetaDataList::BuildDefaultMap(MetaDataListType type)
+bool MetaDataList::BuildTables()
 {
-	std::map<unsigned char, std::string> ret;
+	auto pool = MetaDataValuePool::getInstance();
+	auto empty = pool->intern("");
+
+	for (int i = 0; i < MetaDataId::COUNT; i++)
+	{
+		mTypes[i] = MD_STRING;
+		mInternedIds[i] = false;
+		mDefaultValues[i] = empty;
+	}
+
+	for (auto type : { GAME_METADATA, FOLDER_METADATA })
+	{
+		for (auto& mdd : getMDDByType(type))
+		{
+			mIdMap[mdd.key] = mdd.id;
+			mTypes[mdd.id] = mdd.type;
+			mDefaultValues[mdd.id] = pool->intern(mdd.defaultValue); // the tables keep this reference forever
+		}
+	}
 
-	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
-	for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		ret[iter->id] = iter->defaultValue;
+	// Only values shared by many games are pooled : dates, counters, paths & descriptions are mostly unique
+	for (auto id : { MetaDataId::Emulator, MetaDataId::Core, MetaDataId::Rating, MetaDataId::Developer, MetaDataId::Publisher, MetaDataId::Genre,
+		MetaDataId::Players, MetaDataId::Favorite, MetaDataId::Hidden, MetaDataId::KidGame, MetaDataId::ArcadeSystemName })
+		mInternedIds[id] = true;
 
-	return ret;
+	return true;
 }
 
 MetaDataType MetaDataList::getType(unsigned char id) const
 {
-	if (mType == GAME_METADATA)
-		return mGameTypeMap[id];
-
-	return mFolderTypeMap[id];
+	return mTypes[id];
 }
 
 unsigned char MetaDataList::getId(const std::string& key) const
 {
-	if (mType == GAME_METADATA)
-		return mGameIdMap[key];
+	auto it = mIdMap.find(key);
+	if (it != mIdMap.cend())
+		return it->second;
 
-	return mFolderIdMap[key];
+	LOG(LogError) << "MetaDataList - Unknown metadata \"" << key << "\"";
+	return MetaDataId::Invalid;
 }
 
 const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
@@ -128,9 +196,138 @@ const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
 	return gameMDD;
 }
 
-MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRelativeTo(nullptr)
+MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRelativeTo(nullptr), mSetIds(0)
 { 
+	for (int i = 0; i < MetaDataId::COUNT; i++)
+		mValues[i] = mDefaultValues[i];
+}
+
+MetaDataList::MetaDataList(const MetaDataList& source) : mName(source.mName), mType(source.mType), mWasChanged(source.mWasChanged),
+	mRelativeTo(source.mRelativeTo), mOwnedValues(source.mOwnedValues), mSetIds(source.mSetIds)
+{
+	for (int i = 0; i < MetaDataId::COUNT; i++)
+		mValues[i] = source.mValues[i];
+
+	addRefs();
+}
+
+MetaDataList::MetaDataList(MetaDataList&& source) : mName(std::move(source.mName)), mType(source.mType), mWasChanged(source.mWasChanged),
+	mRelativeTo(source.mRelativeTo), mOwnedValues(std::move(source.mOwnedValues)), mSetIds(source.mSetIds)
+{
+	// The references move along
+	for (int i = 0; i < MetaDataId::COUNT; i++)
+	{
+		mValues[i] = source.mValues[i];
+		source.mValues[i] = mDefaultValues[i];
+	}
 
+	source.mSetIds = 0;
+}
+
+MetaDataList::~MetaDataList()
+{
+	releaseRefs();
+}
+
+MetaDataList& MetaDataList::operator=(const MetaDataList& source)
+{
+	if (this == &source)
+		return *this;
+
+	releaseRefs();
+
+	mName = source.mName;
+	mType = source.mType;
+	mWasChanged = source.mWasChanged;
+	mRelativeTo = source.mRelativeTo;
+	mOwnedValues = source.mOwnedValues;
+	mSetIds = source.mSetIds;
+
+	for (int i = 0; i < MetaDataId::COUNT; i++)
+		mValues[i] = source.mValues[i];
+
+	addRefs();
+	return *this;
+}
+
+void MetaDataList::addRefs()
+{
+	for (int i = 0; i < MetaDataId::COUNT; i++)
+		if (mValues[i] != mDefaultValues[i])
+			mValues[i]->refs++;
+}
+
+void MetaDataList::releaseRefs()
+{
+	for (int i = 0; i < MetaDataId::COUNT; i++)
+		if (mValues[i] != mDefaultValues[i])
+			mValues[i]->refs--;
+}
+
+void MetaDataList::releaseUnusedValues()
+{
+	MetaDataValuePool::getInstance()->releaseUnused();
+}
+
+bool MetaDataList::hasValue(unsigned char id) const
+{
+	if (isInterned(id))
+		return (mSetIds & (1u << id)) != 0;
+
+	for (auto& value : mOwnedValues)
+		if (value.first == id)
+			return true;
+
+	return false;
+}
+
+const std::string& MetaDataList::getRawValue(unsigned char id) const
+{
+	if (id == MetaDataId::Name)
+		return mName;
+
+	if (!isInterned(id))
+		for (auto& value : mOwnedValues)
+			if (value.first == id)
+				return value.second;
+
+	return mValues[id]->text;
+}
+
+void MetaDataList::setRawValue(unsigned char id, const std::string& value)
+{
+	if (id == MetaDataId::Name)
+	{
+		mName = value;
+		return;
+	}
+
+	if (isInterned(id))
+	{
+		const MetaDataValue* interned = MetaDataValuePool::getInstance()->intern(value);
+
+		if (mValues[id] != mDefaultValues[id])
+			mValues[id]->refs--;
+
+		// Defaults are referenced by the tables only
+		if (interned == mDefaultValues[id])
+			interned->refs--;
+
+		mValues[id] = interned;
+		mSetIds |= 1u << id;
+		return;
+	}
+
+	for (auto& owned : mOwnedValues)
+	{
+		if (owned.first == id)
+		{
+			owned.second = value;
+			return;
+		}
+	}
+
+	mOwnedValues.push_back(std::pair<unsigned char, std::string>(id, value));
 }
 
 MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node& node, SystemData* system)
@@ -159,13 +356,10 @@ MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node&
 				value = Utils::String::toLower(value);
 
 			// Players -> remove "1-"
-			if (type == GAME_METADATA && iter->id == 14 && iter->type == MD_INT && Utils::String::startsWith(value, "1-")) // "players"
+			if (type == GAME_METADATA && iter->id == MetaDataId::Players && iter->type == MD_INT && Utils::String::startsWith(value, "1-"))
 				value = Utils::String::replace(value, "1-", "");
 			
-			if (iter->id == 0)
-				mdl.mName = value;
-			else
-				mdl.mMap[iter->id] = value;
+			mdl.setRawValue(iter->id, value);
 		}
 	}
 
@@ -184,16 +378,16 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 			continue;
 		}
 
-		auto mapIter = mMap.find(mddIter->id);
-		if (mapIter != mMap.cend())
+		if (hasValue(mddIter->id))
 		{
 			// we have this value!
 			// if it's just the default (and we ignore defaults), don't write it
-			if (ignoreDefaults && mapIter->second == mddIter->defaultValue)
+			const std::string& rawValue = getRawValue(mddIter->id);
+			if (ignoreDefaults && rawValue == mddIter->defaultValue)
 				continue;
 			
 			// try and make paths relative if we can
-			std::string value = mapIter->second;
+			std::string value = rawValue;
 			if (mddIter->type == MD_PATH)
 				value = Utils::FileSystem::createRelativePath(value, relativeTo, true);
 
@@ -209,64 +403,60 @@ const std::string& MetaDataList::getName() const
 
 void MetaDataList::set(const std::string& key, const std::string& value)
 {
-	if (key == "name")
-	{
-		if (mName == value)
-			return;
+	auto id = getId(key);
+	if (id != MetaDataId::Invalid)
+		set((MetaDataId::Id) id, value);
+}
 
-		mName = value;
-	}
-	else
+void MetaDataList::set(MetaDataId::Id id, const std::string& value)
+{
+	// Players -> remove "1-"
+	if (mType == GAME_METADATA && id == MetaDataId::Players && Utils::String::startsWith(value, "1-"))
 	{
-		auto id = getId(key);
-		
-		// Players -> remove "1-"
-		if (mType == GAME_METADATA && id == 14 && Utils::String::startsWith(value, "1-")) // "players"
-		{
-			mMap[id] = Utils::String::replace(value, "1-", "");
-			return;
-		}
-
-		auto prev = mMap.find(id);
-		if (prev != mMap.cend() && prev->second == value)
-			return;
-
-		mMap[id] = value;
+		setRawValue(id, Utils::String::replace(value, "1-", ""));
+		mGeneration++;
+		return;
 	}
 
+	if (getRawValue(id) == value)
+		return;
+
+	setRawValue(id, value);
 	mWasChanged = true;
+	mGeneration++;
 }
 
 const std::string MetaDataList::get(const std::string& key) const
 {
-	if (key == "name")
-		return mName;
-
 	auto id = getId(key);
+	if (id == MetaDataId::Invalid)
+		return "";
 
-	auto it = mMap.find(id);
-	if (it != mMap.end())
-	{		
-		if (getType(id) == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-			return Utils::FileSystem::resolveRelativePath(it->second, mRelativeTo->getStartPath(), true);
+	return get((MetaDataId::Id) id);
+}
 
-		return it->second;
-	}
+const std::string MetaDataList::get(MetaDataId::Id id) const
+{
+	if (isInterned(id))
+		return mValues[id]->text;
 
-	if (mType == GAME_METADATA)
-		return mDefaultGameMap.at(id);
+	const std::string& value = getRawValue(id);
+	if (id != MetaDataId::Name && getType(id) == MD_PATH && mRelativeTo != nullptr && !value.empty()) // if it's a path, resolve relative paths
+		return Utils::FileSystem::resolveRelativePath(value, mRelativeTo->getStartPath(), true);
 
-	return mDefaultFolderMap.at(id);
+	return value;
 }
 
 int MetaDataList::getInt(const std::string& key) const
 {
-	return atoi(get(key).c_str());
+	auto id = getId(key);
+	return id == MetaDataId::Invalid ? 0 : getInt((MetaDataId::Id) id);
 }
 
 float MetaDataList::getFloat(const std::string& key) const
 {
-	return (float)atof(get(key).c_str());
+	auto id = getId(key);
+	return id == MetaDataId::Invalid ? 0.0f : getFloat((MetaDataId::Id) id);
 }
 
 bool MetaDataList::wasChanged() const
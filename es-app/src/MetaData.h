@@ -2,7 +2,10 @@
 #ifndef ES_APP_META_DATA_H
 #define ES_APP_META_DATA_H
 
+#include <atomic>
 #include <map>
+#include <stdlib.h>
+#include <string>
 #include <vector>
 
 class SystemData;
@@ -38,6 +41,50 @@ namespace MetaDataImportType
 	};
 }
 
+// Ids are shared by game & folder declarations, so they can be used as compile-time indexes for both
+namespace MetaDataId
+{
+	enum Id : unsigned char
+	{
+		Name = 0,
+		Desc = 2,
+		Emulator = 3,
+		Core = 4,
+		Image = 5,
+		Video = 6,
+		Marquee = 7,
+		Thumbnail = 8,
+		Rating = 9,
+		ReleaseDate = 10,
+		Developer = 11,
+		Publisher = 12,
+		Genre = 13,
+		Players = 14,
+		Favorite = 15,
+		Hidden = 16,
+		KidGame = 17,
+		PlayCount = 18,
+		LastPlayed = 19,
+		ArcadeSystemName = 20,
+		GameTime = 21,
+
+		COUNT = 22,
+
+		Invalid = 0xFF // unknown key
+	};
+}
+
+// Interned value : the text is shared by every list holding it, numeric forms are parsed once.
+// refs counts the lists holding it, unused values are freed by MetaDataList::releaseUnusedValues()
+struct MetaDataValue
+{
+	std::string              text;
+	int                      intValue;
+	float                    floatValue;
+	bool                     boolValue;
+	mutable std::atomic<int> refs;
+};
+
 struct MetaDataDecl
 {
 	unsigned char id;
@@ -60,18 +107,34 @@ const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type);
 
 class MetaDataList
 {
+	friend class GamelistCache;
+
 public:
 	static MetaDataList createFromXML(MetaDataListType type, pugi::xml_node& node, SystemData* system);
 	void appendToXML(pugi::xml_node& parent, bool ignoreDefaults, const std::string& relativeTo) const;
 
 	MetaDataList(MetaDataListType type);
+	MetaDataList(const MetaDataList& source);
+	MetaDataList(MetaDataList&& source);
+	~MetaDataList();
+
+	MetaDataList& operator=(const MetaDataList& source);
 
 	void set(const std::string& key, const std::string& value);
+	void set(MetaDataId::Id id, const std::string& value);
 
 	const std::string get(const std::string& key) const;
 	int getInt(const std::string& key) const;
 	float getFloat(const std::string& key) const;
 
+	const std::string get(MetaDataId::Id id) const;
+	inline int getInt(MetaDataId::Id id) const { return isInterned(id) ? mValues[id]->intValue : atoi(get(id).c_str()); }
+	inline float getFloat(MetaDataId::Id id) const { return isInterned(id) ? mValues[id]->floatValue : (float)atof(get(id).c_str()); }
+	inline bool getBool(MetaDataId::Id id) const { return isInterned(id) ? mValues[id]->boolValue : get(id) == "true"; }
+
+	// No copy. Paths are returned as written in the gamelist, unresolved
+	inline const std::string& getString(MetaDataId::Id id) const { return isInterned(id) ? mValues[id]->text : getRawValue(id); }
+
 	bool wasChanged() const;
 	void resetChangedFlag();
 	void setDirty() { mWasChanged = true; }
@@ -82,33 +145,46 @@ public:
 
 	void importScrappedMetadata(const MetaDataList& source);
 
+	// Incremented each time a value of any list is changed : lets cached views (sorted lists) detect they're stale
+	static unsigned int getGeneration() { return mGeneration; }
+
+	// Frees the pooled values no list holds anymore. Called when the systems are deleted
+	static void releaseUnusedValues();
+
 private:
 	std::string		mName;
 	unsigned char	mType;
 	bool			mWasChanged;
 	SystemData*		mRelativeTo;
 
-	std::map<unsigned char, std::string> mMap;
-
-	unsigned char getId(const std::string& key) const;	
-	MetaDataType getType(unsigned char id) const;
+	// Low cardinality values (developer, genre, rating, players, flags...) point to the shared pool, and hold a reference
+	// unless they point to the pooled default value. Other values are mostly unique : they're owned by the list and stored apart.
+	const MetaDataValue* mValues[MetaDataId::COUNT];
+	std::vector<std::pair<unsigned char, std::string>> mOwnedValues;
+	unsigned int mSetIds; // bit per id explicitly set, even to its default value : these are written to gamelist.xml
 
+	void addRefs();
+	void releaseRefs();
 
-private: // Static maps
+	unsigned char getId(const std::string& key) const;
+	MetaDataType getType(unsigned char id) const;
 
-	static std::map<unsigned char, std::string> mDefaultGameMap;
-	static std::map<unsigned char, std::string> mDefaultFolderMap;
+	static inline bool isInterned(unsigned char id) { return mInternedIds[id]; }
 
-	static std::map<std::string, unsigned char> mGameIdMap;
-	static std::map<std::string, unsigned char> mFolderIdMap;
+	bool hasValue(unsigned char id) const;
+	const std::string& getRawValue(unsigned char id) const;
+	void setRawValue(unsigned char id, const std::string& value);
 
-	static std::map<unsigned char, MetaDataType> mGameTypeMap;
-	static std::map<unsigned char, MetaDataType> mFolderTypeMap;
+private: // Static tables
 
-	static std::map<unsigned char, std::string> BuildDefaultMap(MetaDataListType type);
-	static std::map<std::string, unsigned char> BuildIdMap(MetaDataListType type);
-	static std::map<unsigned char, MetaDataType> BuildTypeMap(MetaDataListType type);
+	static std::map<std::string, unsigned char> mIdMap;
+	static MetaDataType mTypes[MetaDataId::COUNT];
+	static bool mInternedIds[MetaDataId::COUNT];
+	static const MetaDataValue* mDefaultValues[MetaDataId::COUNT];
+	static bool mTablesBuilt;
+	static std::atomic<unsigned int> mGeneration;
 
+	static bool BuildTables();
 };
 
 #endif // ES_APP_META_DATA_H
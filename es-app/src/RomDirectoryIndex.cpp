@@ -0,0 +1,200 @@
+#include "RomDirectoryIndex.h"
+
+#include "Log.h"
+#include "Settings.h"
+#include "SystemData.h"
+
+#include <fstream>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define ROM_INDEX_MAGIC		0x49445345 // "ESDI"
+#define ROM_INDEX_VERSION	1
+
+// Directories modified less than this number of seconds before the scan are listed again next time :
+// another change could happen within the same mtime tick (FAT/exFAT have a 2 seconds resolution)
+#define ROM_INDEX_MTIME_GUARD	2
+
+static void writeUInt(std::ofstream& stream, unsigned int value) { stream.write((const char*)&value, sizeof(value)); }
+static void writeLong(std::ofstream& stream, long long value) { stream.write((const char*)&value, sizeof(value)); }
+
+static void writeString(std::ofstream& stream, const std::string& value)
+{
+	writeUInt(stream, (unsigned int)value.size());
+	stream.write(value.data(), value.size());
+}
+
+static bool readUInt(std::ifstream& stream, unsigned int& value) { return (bool)stream.read((char*)&value, sizeof(value)); }
+static bool readLong(std::ifstream& stream, long long& value) { return (bool)stream.read((char*)&value, sizeof(value)); }
+
+static bool readString(std::ifstream& stream, std::string& value)
+{
+	unsigned int size;
+	if (!readUInt(stream, size) || size > 4096)
+		return false;
+
+	value.resize(size);
+	return size == 0 || (bool)stream.read(&value[0], size);
+}
+
+RomDirectoryIndex::RomDirectoryIndex(SystemData* system) : mSystem(system), mChanged(false)
+{
+	mEnabled = Settings::getInstance()->getBool("IncrementalRomScan");
+	if (mEnabled)
+		load();
+}
+
+std::string RomDirectoryIndex::getIndexPath() const
+{
+	return Utils::FileSystem::getEsConfigPath() + "/cache/scan/" + mSystem->getName() + ".idx";
+}
+
+void RomDirectoryIndex::load()
+{
+	std::ifstream stream(getIndexPath().c_str(), std::ios::binary);
+	if (!stream.is_open())
+		return;
+
+	unsigned int magic, version, count;
+	if (!readUInt(stream, magic) || !readUInt(stream, version) || !readUInt(stream, count) || magic != ROM_INDEX_MAGIC || version != ROM_INDEX_VERSION)
+		return;
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		std::string path;
+		Directory dir;
+		unsigned int entryCount;
+
+		if (!readString(stream, path) || !readLong(stream, dir.mtime) || !readLong(stream, dir.mtimeNs) || !readUInt(stream, entryCount))
+		{
+			LOG(LogWarning) << "RomDirectoryIndex::load() - Corrupted index \"" << getIndexPath() << "\", rescanning everything";
+			mDirectories.clear();
+			return;
+		}
+
+		dir.entries.resize(entryCount);
+		for (auto& entry : dir.entries)
+		{
+			if (!stream.read((char*)&entry.flags, 1) || !readString(stream, entry.name))
+			{
+				LOG(LogWarning) << "RomDirectoryIndex::load() - Corrupted index \"" << getIndexPath() << "\", rescanning everything";
+				mDirectories.clear();
+				return;
+			}
+		}
+
+		mDirectories[path] = dir;
+	}
+}
+
+Utils::FileSystem::fileList RomDirectoryIndex::getDirInfo(const std::string& path)
+{
+	if (!mEnabled)
+		return Utils::FileSystem::getDirInfo(path);
+
+	// Watched before the stat, so a change after it is reported to the file cache
+	unsigned int generation = Utils::FileSystem::beginDirInfoCache(path);
+
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+		return Utils::FileSystem::fileList();
+
+	auto it = mDirectories.find(path);
+	if (it != mDirectories.cend() && it->second.mtime == (long long)info.st_mtim.tv_sec && it->second.mtimeNs == (long long)info.st_mtim.tv_nsec)
+	{
+		Utils::FileSystem::fileList content;
+
+		for (auto& entry : it->second.entries)
+		{
+			Utils::FileSystem::FileInfo fi;
+			fi.path = path + "/" + entry.name;
+			fi.hidden = entry.name[0] == '.';
+			fi.directory = (entry.flags & ENTRY_DIRECTORY) != 0;
+			fi.symlink = (entry.flags & ENTRY_SYMLINK) != 0;
+			content.push_back(fi);
+		}
+
+		Utils::FileSystem::setDirInfoCache(path, content, generation);
+
+		mScanned[path] = it->second;
+		return content;
+	}
+
+	Utils::FileSystem::fileList content = Utils::FileSystem::getDirInfo(path);
+
+	Directory dir;
+	dir.mtime = (long long)info.st_mtim.tv_sec;
+	dir.mtimeNs = (long long)info.st_mtim.tv_nsec;
+
+	if (dir.mtime + ROM_INDEX_MTIME_GUARD >= (long long)time(NULL))
+		dir.mtime = -1;
+
+	dir.entries.reserve(content.size());
+	for (auto& fi : content)
+	{
+		Entry entry;
+		entry.name = Utils::FileSystem::getFileName(fi.path);
+		entry.flags = (fi.directory ? ENTRY_DIRECTORY : 0) | (fi.symlink ? ENTRY_SYMLINK : 0);
+		dir.entries.push_back(entry);
+	}
+
+	mScanned[path] = dir;
+	mChanged = true;
+
+	return content;
+}
+
+void RomDirectoryIndex::save()
+{
+	// Directories which were not visited anymore (deleted, or now ignored) are dropped from the index
+	if (!mEnabled || (!mChanged && mScanned.size() == mDirectories.size()))
+		return;
+
+	std::string path = getIndexPath();
+	std::string folder = Utils::FileSystem::getParent(path);
+	if (!Utils::FileSystem::exists(folder))
+		Utils::FileSystem::createDirectory(folder);
+
+	std::string tmpFile = path + ".tmp";
+
+	{
+		std::ofstream stream(tmpFile.c_str(), std::ios::binary | std::ios::trunc);
+		if (!stream.is_open())
+		{
+			LOG(LogError) << "RomDirectoryIndex::save() - Unable to create \"" << tmpFile << "\"";
+			return;
+		}
+
+		writeUInt(stream, ROM_INDEX_MAGIC);
+		writeUInt(stream, ROM_INDEX_VERSION);
+		writeUInt(stream, (unsigned int)mScanned.size());
+
+		for (auto& dir : mScanned)
+		{
+			writeString(stream, dir.first);
+			writeLong(stream, dir.second.mtime);
+			writeLong(stream, dir.second.mtimeNs);
+			writeUInt(stream, (unsigned int)dir.second.entries.size());
+
+			for (auto& entry : dir.second.entries)
+			{
+				stream.write((const char*)&entry.flags, 1);
+				writeString(stream, entry.name);
+			}
+		}
+
+		if (!stream.good())
+		{
+			LOG(LogError) << "RomDirectoryIndex::save() - Error writing \"" << tmpFile << "\"";
+			stream.close();
+			Utils::FileSystem::removeFile(tmpFile);
+			return;
+		}
+	}
+
+	if (std::rename(tmpFile.c_str(), path.c_str()) != 0)
+	{
+		LOG(LogError) << "RomDirectoryIndex::save() - Unable to rename \"" << tmpFile << "\" to \"" << path << "\"";
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef ES_APP_ROM_DIRECTORY_INDEX_H
+#define ES_APP_ROM_DIRECTORY_INDEX_H
+
+#include "utils/FileSystemUtil.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SystemData;
+
+// Persisted listing of every ROM directory of a system, stored in [ES config path]/cache/scan/[system].idx
+//
+// On startup a directory is only listed again if its modification time changed since the previous scan
+// (a directory's mtime changes whenever an entry is added, removed or renamed in it). Unchanged
+// listings are rebuilt from the index and seeded into the FileCache, so the exists()/isDirectory()
+// checks done while loading the gamelist don't hit the disk either.
+class RomDirectoryIndex
+{
+public:
+	RomDirectoryIndex(SystemData* system);
+
+	Utils::FileSystem::fileList getDirInfo(const std::string& path);
+	void save();
+
+private:
+	enum EntryFlags : unsigned char
+	{
+		ENTRY_DIRECTORY = 1,
+		ENTRY_SYMLINK = 2
+	};
+
+	struct Entry
+	{
+		std::string name;
+		unsigned char flags;
+	};
+
+	struct Directory
+	{
+		long long mtime;
+		long long mtimeNs;
+		std::vector<Entry> entries;
+	};
+
+	void load();
+	std::string getIndexPath() const;
+
+	SystemData* mSystem;
+	bool mEnabled;
+	bool mChanged;
+
+	std::unordered_map<std::string, Directory> mDirectories; // from the previous scan
+	std::unordered_map<std::string, Directory> mScanned;     // directories visited by this scan
+};
+
+#endif // ES_APP_ROM_DIRECTORY_INDEX_H
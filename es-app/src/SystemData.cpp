@@ -5,12 +5,16 @@
 #include "FileFilterIndex.h"
 #include "FileSorts.h"
 #include "Gamelist.h"
+#include "GamelistCache.h"
 #include "Log.h"
+#include "RomDirectoryIndex.h"
 #include "platform.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "ThemeData.h"
 #include "views/UIModeController.h"
 #include <fstream>
+#include <sstream>
 #include "utils/StringUtil.h"
 #include "utils/ThreadPool.h"
 #include "GuiComponent.h"
@@ -43,13 +47,21 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, Sys
 		
 		if (!Settings::getInstance()->getBool("ParseGamelistOnly"))
 		{			
-			populateFolder(mRootFolder, fileMap);
+			PROFILE_SCOPE("SystemData::populateFolder");
+
+			RomDirectoryIndex index(this);
+			populateFolder(mRootFolder, fileMap, index);
 			if (mRootFolder->getChildren().size() == 0)
 				return;
+
+			index.save();
 		}
 
 		if (!Settings::getInstance()->getBool("IgnoreGamelist") && mName != "imageviewer")
+		{
+			PROFILE_SCOPE("SystemData::parseGamelist");
 			parseGamelist(this, fileMap);
+		}
 	}
 	else
 	{
@@ -107,7 +119,7 @@ void SystemData::setIsGameSystemStatus()
 	mIsGameSystem = (mName != "retropie");
 }
 
-void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap)
+void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap, RomDirectoryIndex& index)
 {
 	const std::string& folderPath = folder->getPath();
 	if(!Utils::FileSystem::isDirectory(folderPath))
@@ -132,7 +144,7 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 	bool isGame;
 	bool showHidden = Settings::getInstance()->getBool("ShowHiddenFiles");
 	
-	Utils::FileSystem::fileList dirContent = Utils::FileSystem::getDirInfo(folderPath);
+	Utils::FileSystem::fileList dirContent = index.getDirInfo(folderPath);
 
 	for(Utils::FileSystem::fileList::const_iterator it = dirContent.cbegin(); it != dirContent.cend(); ++it)
 	{
@@ -178,7 +190,7 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 				continue;
 
 			FolderData* newFolder = new FolderData(fileInfo.path, this);
-			populateFolder(newFolder, fileMap);
+			populateFolder(newFolder, fileMap, index);
 
 			if (newFolder->getChildren().size() == 0)
 				delete newFolder;
@@ -240,6 +252,8 @@ std::vector<std::string> readList(const std::string& str, const char* delims = "
 
 SystemData* SystemData::loadSystem(pugi::xml_node system)
 {
+	PROFILE_SCOPE("SystemData::loadSystem");
+
 	std::vector<EmulatorData> emulatorList;
 
 	std::string name, fullname, path, cmd, themeFolder, defaultCore;
@@ -350,6 +364,10 @@ SystemData* SystemData::loadSystem(pugi::xml_node system)
 	envData->mEmulators = emulatorList;
 	envData->mGroup = system.child("group").text().get();
 
+	std::ostringstream config;
+	system.print(config, "", pugi::format_raw);
+	envData->mConfigHash = GamelistCache::hashString(config.str());
+
 	SystemData* newSys = new SystemData(name, fullname, envData, themeFolder);
 	if (newSys->getRootFolder()->getChildren().size() == 0)
 	{
@@ -476,12 +494,12 @@ bool SystemData::loadConfig(Window* window)
 
 	typedef SystemData* SystemDataPtr;
 
-	ThreadPool* pThreadPool = NULL;
+	TaskGroup* pThreadPool = NULL;
 	SystemDataPtr* systems = NULL;
 	
 	if (std::thread::hardware_concurrency() > 2 && Settings::getInstance()->getBool("ThreadedLoading"))
 	{
-		pThreadPool = new ThreadPool();
+		pThreadPool = new TaskGroup();
 
 		systems = new SystemDataPtr[systemCount];
 		for (int i = 0; i < systemCount; i++)
@@ -649,6 +667,9 @@ void SystemData::deleteSystems()
 	}
 
 	sSystemVector.clear();
+
+	// Before a reload : don't keep the values of games which may be gone
+	MetaDataList::releaseUnusedValues();
 }
 
 std::string SystemData::getConfigPath(bool forWrite)
@@ -823,6 +844,8 @@ void SystemData::updateDisplayedGameCount()
 
 void SystemData::loadTheme()
 {
+	PROFILE_SCOPE("SystemData::loadTheme");
+
 	//StopWatch watch("SystemData::loadTheme " + getName());
 
 	mTheme = std::make_shared<ThemeData>();
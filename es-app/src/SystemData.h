@@ -18,6 +18,7 @@
 
 class FileData;
 class FolderData;
+class RomDirectoryIndex;
 class ThemeData;
 class Window;
 
@@ -30,7 +31,10 @@ struct EmulatorData
 
 struct SystemEnvironmentData
 {
+	SystemEnvironmentData() : mConfigHash(0) { }
+
 	std::string mSystemName;
+	unsigned int mConfigHash; // hash of the es_systems.cfg <system> entry, 0 for collections
 
 	std::string mStartPath;
 	std::unordered_set<std::string> mSearchExtensions;
@@ -216,7 +220,7 @@ private:
 
 	unsigned int mSortId;
 
-	void populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap);
+	void populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap, RomDirectoryIndex& index);
 	void indexAllGameFilters(const FolderData* folder);
 	void setIsGameSystemStatus();
 
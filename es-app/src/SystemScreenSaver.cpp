@@ -67,7 +67,7 @@ void SystemScreenSaver::startScreenSaver()
 
 	stopScreenSaver();
 
-	std::string screensaver_behavior = Settings::getInstance()->getString("ScreenSaverBehavior");
+	std::string screensaver_behavior = Settings::getInstance()->getString(SettingKey::ScreenSaverBehavior);
 	if (screensaver_behavior == "random video")
 	{
 		if (!loadingNext && Settings::getInstance()->getBool("VideoAudio"))
@@ -229,7 +229,7 @@ void SystemScreenSaver::renderScreenSaver()
 	}
 	else if (mState != STATE_INACTIVE)
 	{
-		std::string screensaver_behavior = Settings::getInstance()->getString("ScreenSaverBehavior");
+		std::string screensaver_behavior = Settings::getInstance()->getString(SettingKey::ScreenSaverBehavior);
 
 		Renderer::setMatrix(Transform4x4f::Identity());
 		unsigned char color = screensaver_behavior == "dim" ? 0x000000A0 : 0x000000FF;
@@ -456,7 +456,7 @@ void SystemScreenSaver::launchGame()
 		if (view != nullptr)
 			view->setCursor(mCurrentGame);
 
-		if (Settings::getInstance()->getBool("ScreenSaverControls"))
+		if (Settings::getInstance()->getBool(SettingKey::ScreenSaverControls))
 			mCurrentGame->launchGame(mWindow);
 		else
 			ViewController::get()->goToGameList(mCurrentGame->getSystem());
@@ -0,0 +1,151 @@
+#include "benchmark/BenchmarkRunner.h"
+
+#include "renderers/Renderer.h"
+#include "InputManager.h"
+#include "InputConfig.h"
+#include "Log.h"
+#include "Window.h"
+#include <SDL_events.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+std::atomic<unsigned long long> BenchmarkRunner::sAllocations(0);
+
+float BenchmarkRunner::Result::getPercentile(float percentile) const
+{
+	if (frameTimes.empty())
+		return 0.0f;
+
+	std::vector<float> sorted = frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	size_t index = (size_t)(percentile / 100.0f * sorted.size());
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+float BenchmarkRunner::Result::getAverage() const
+{
+	if (frameTimes.empty())
+		return 0.0f;
+
+	float total = 0.0f;
+	for (auto time : frameTimes)
+		total += time;
+
+	return total / frameTimes.size();
+}
+
+BenchmarkRunner::BenchmarkRunner(Window* window, int frameDelta) : mWindow(window), mFrameDelta(frameDelta), mCurrent(-1)
+{
+}
+
+void BenchmarkRunner::beginScenario(const std::string& name)
+{
+	LOG(LogInfo) << "BenchmarkRunner - Scenario " << name;
+
+	mResults.push_back(Result(name));
+	mCurrent = (int)mResults.size() - 1;
+}
+
+void BenchmarkRunner::endScenario()
+{
+	mCurrent = -1;
+}
+
+void BenchmarkRunner::runFrame()
+{
+	// Nobody reads the SDL queue : drop what piled up (joysticks, wake up events...)
+	SDL_Event event;
+	while (SDL_PollEvent(&event))
+		;
+
+	unsigned long long allocations = sAllocations;
+	auto start = std::chrono::steady_clock::now();
+
+	mWindow->update(mFrameDelta);
+	mWindow->render();
+	Renderer::swapBuffers();
+
+	float time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	if (mCurrent < 0)
+		return;
+
+	Result& result = mResults[mCurrent];
+	const Renderer::FrameStats& stats = Renderer::getFrameStats();
+
+	result.frameTimes.push_back(time);
+	result.drawCalls += stats.drawCalls;
+	result.primitives += stats.primitives;
+	result.vertices += stats.vertices;
+	result.textureUploads += stats.textureUploads;
+	result.uploadedBytes += stats.uploadedBytes;
+	result.allocations += sAllocations - allocations;
+}
+
+void BenchmarkRunner::runFrames(int count)
+{
+	for (int i = 0; i < count; i++)
+		runFrame();
+}
+
+void BenchmarkRunner::sendInput(const std::string& name, bool pressed)
+{
+	InputConfig* config = InputManager::getInstance()->getInputConfigByDevice(DEVICE_KEYBOARD);
+
+	Input input;
+	if (!config->getInputByName(name, &input))
+	{
+		LOG(LogWarning) << "BenchmarkRunner - No key mapped to " << name;
+		return;
+	}
+
+	input.value = pressed ? 1 : 0;
+	input.configured = false;
+	mWindow->input(config, input);
+}
+
+void BenchmarkRunner::press(const std::string& name, int holdFrames, int waitFrames)
+{
+	sendInput(name, true);
+	runFrames(holdFrames);
+	sendInput(name, false);
+	runFrames(waitFrames);
+}
+
+void BenchmarkRunner::printReport(std::ostream& out) const
+{
+	out << std::left << std::setw(12) << "scenario" << std::right
+		<< std::setw(8) << "frames"
+		<< std::setw(9) << "avg ms"
+		<< std::setw(9) << "p50 ms"
+		<< std::setw(9) << "p90 ms"
+		<< std::setw(9) << "p99 ms"
+		<< std::setw(9) << "max ms"
+		<< std::setw(10) << "draws/f"
+		<< std::setw(10) << "prims/f"
+		<< std::setw(9) << "uploads"
+		<< std::setw(11) << "upload KB"
+		<< std::setw(10) << "allocs/f" << "\n";
+
+	out << std::fixed << std::setprecision(2);
+
+	for (auto& result : mResults)
+	{
+		size_t frames = std::max((size_t)1, result.frameTimes.size());
+
+		out << std::left << std::setw(12) << result.name << std::right
+			<< std::setw(8) << result.frameTimes.size()
+			<< std::setw(9) << result.getAverage()
+			<< std::setw(9) << result.getPercentile(50)
+			<< std::setw(9) << result.getPercentile(90)
+			<< std::setw(9) << result.getPercentile(99)
+			<< std::setw(9) << result.getPercentile(100)
+			<< std::setw(10) << (float)result.drawCalls / frames
+			<< std::setw(10) << (float)result.primitives / frames
+			<< std::setw(9) << result.textureUploads
+			<< std::setw(11) << result.uploadedBytes / 1024
+			<< std::setw(10) << (float)result.allocations / frames << "\n";
+	}
+}
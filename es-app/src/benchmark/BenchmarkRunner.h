@@ -0,0 +1,62 @@
+#pragma once
+#ifndef ES_APP_BENCHMARK_BENCHMARK_RUNNER_H
+#define ES_APP_BENCHMARK_BENCHMARK_RUNNER_H
+
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Window;
+
+// Drives the window frame by frame with a fixed time step, sends scripted inputs, and records per scenario
+// the frame times and the renderer stats. Frames run outside of a scenario (warm up) aren't recorded.
+class BenchmarkRunner
+{
+public:
+	struct Result
+	{
+		Result(const std::string& _name) : name(_name), drawCalls(0), primitives(0), vertices(0), textureUploads(0), uploadedBytes(0), allocations(0) { }
+
+		std::string			name;
+		std::vector<float>	frameTimes; // ms
+
+		unsigned long long	drawCalls;
+		unsigned long long	primitives;
+		unsigned long long	vertices;
+		unsigned long long	textureUploads;
+		unsigned long long	uploadedBytes;
+		unsigned long long	allocations;
+
+		float getPercentile(float percentile) const;
+		float getAverage() const;
+	};
+
+	BenchmarkRunner(Window* window, int frameDelta = 16);
+
+	void beginScenario(const std::string& name);
+	void endScenario();
+
+	void runFrames(int count);
+
+	// Presses an input by its name in the keyboard config (up, down, a, b, start...),
+	// holds it for holdFrames frames, then runs waitFrames more frames
+	void press(const std::string& name, int holdFrames = 1, int waitFrames = 10);
+
+	const std::vector<Result>& getResults() const { return mResults; }
+	void printReport(std::ostream& out) const;
+
+	// Incremented by the executable's operator new
+	static std::atomic<unsigned long long> sAllocations;
+
+private:
+	void runFrame();
+	void sendInput(const std::string& name, bool pressed);
+
+	Window*				mWindow;
+	int					mFrameDelta;
+	int					mCurrent;
+	std::vector<Result>	mResults;
+};
+
+#endif // ES_APP_BENCHMARK_BENCHMARK_RUNNER_H
@@ -0,0 +1,188 @@
+#include "benchmark/LibraryGenerator.h"
+
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include <fstream>
+
+static const char* SYSTEM_NAMES[] = { "nes", "snes", "megadrive", "gba", "gb", "gbc", "n64", "psx", "mastersystem", "gamegear", "pcengine", "atari2600" };
+static const char* TITLE_WORDS[] = { "Super", "Dragon", "Quest", "Legend", "Star", "Racing", "Ninja", "Castle", "Space", "Soccer", "Shadow", "Metal", "Puzzle", "Island", "Fighter", "Kart" };
+static const char* GENRES[] = { "Action", "Platform", "RPG", "Racing", "Sports", "Puzzle", "Shooter", "Fighting" };
+static const char* DEVELOPERS[] = { "Konami", "Capcom", "Sega", "Namco", "Hudson Soft", "Taito", "Irem", "SNK" };
+
+#define SYSTEM_NAME_COUNT	(sizeof(SYSTEM_NAMES) / sizeof(SYSTEM_NAMES[0]))
+#define TITLE_WORD_COUNT	(sizeof(TITLE_WORDS) / sizeof(TITLE_WORDS[0]))
+#define GENRE_COUNT			(sizeof(GENRES) / sizeof(GENRES[0]))
+#define DEVELOPER_COUNT		(sizeof(DEVELOPERS) / sizeof(DEVELOPERS[0]))
+#define FOLDERS_PER_LEVEL	4
+
+// 1x1 opaque PNG, enough for the image loaders
+static const unsigned char PNG_STUB[] =
+{
+	0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+	0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x02, 0x00, 0x00, 0x00, 0x90, 0x77, 0x53,
+	0xDE, 0x00, 0x00, 0x00, 0x0C, 0x49, 0x44, 0x41, 0x54, 0x08, 0xD7, 0x63, 0xF8, 0xCF, 0xC0, 0x00,
+	0x00, 0x03, 0x01, 0x01, 0x00, 0x18, 0xDD, 0x8D, 0xB0, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E,
+	0x44, 0xAE, 0x42, 0x60, 0x82
+};
+
+// Deterministic, so runs can be compared
+static unsigned int nextRandom(unsigned int& seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0x7FFF;
+}
+
+static std::string getSystemName(int index)
+{
+	std::string name = SYSTEM_NAMES[index % SYSTEM_NAME_COUNT];
+	if (index >= (int)SYSTEM_NAME_COUNT)
+		name += std::to_string(index / SYSTEM_NAME_COUNT);
+
+	return name;
+}
+
+// Folder of the game, relative to the system folder : spreads the games evenly over the leaf folders
+static std::string getGameFolder(int game, int depth)
+{
+	std::string folder;
+
+	int index = game;
+	for (int level = 0; level < depth; level++)
+	{
+		folder += "folder" + std::to_string(index % FOLDERS_PER_LEVEL) + "/";
+		index /= FOLDERS_PER_LEVEL;
+	}
+
+	return folder;
+}
+
+static void writeStub(const std::string& path, const unsigned char* data, size_t size)
+{
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (data != nullptr)
+		file.write((const char*)data, size);
+}
+
+static bool writeSystem(const std::string& path, const std::string& name, int index, const LibraryGenerator::Options& options)
+{
+	Utils::FileSystem::createDirectory(path);
+
+	bool full = options.metadata == LibraryGenerator::METADATA_FULL;
+	if (full && options.imagePercent > 0)
+		Utils::FileSystem::createDirectory(path + "/images");
+	if (full && options.videoPercent > 0)
+		Utils::FileSystem::createDirectory(path + "/videos");
+
+	// create the folder tree first
+	int leaves = 1;
+	for (int level = 0; level < options.depth; level++)
+		leaves *= FOLDERS_PER_LEVEL;
+
+	for (int i = 0; i < leaves && options.depth > 0; i++)
+	{
+		std::string folder = path;
+		for (auto part : Utils::FileSystem::getPathList(getGameFolder(i, options.depth)))
+		{
+			folder += "/" + part;
+			Utils::FileSystem::createDirectory(folder);
+		}
+	}
+
+	std::ofstream gamelist;
+	if (options.metadata != LibraryGenerator::METADATA_NONE)
+	{
+		gamelist.open(path + "/gamelist.xml", std::ios::out | std::ios::trunc);
+		if (!gamelist.is_open())
+			return false;
+
+		gamelist << "<?xml version=\"1.0\"?>\n<gameList>\n";
+	}
+
+	unsigned int seed = (unsigned int)index + 1;
+
+	for (int i = 0; i < options.games; i++)
+	{
+		std::string title = std::string(TITLE_WORDS[nextRandom(seed) % TITLE_WORD_COUNT]) + " " + TITLE_WORDS[nextRandom(seed) % TITLE_WORD_COUNT] + " " + std::to_string(i + 1);
+		std::string stem = name + "_" + std::to_string(i + 1);
+		std::string file = getGameFolder(i, options.depth) + stem + ".zip";
+
+		writeStub(path + "/" + file, nullptr, 0);
+
+		if (!gamelist.is_open())
+			continue;
+
+		gamelist << "\t<game>\n"
+			<< "\t\t<path>./" << file << "</path>\n"
+			<< "\t\t<name>" << title << "</name>\n";
+
+		if (full)
+		{
+			gamelist
+				<< "\t\t<desc>Synthetic game " << (i + 1) << " of " << name << ". Generated to measure how the library size affects loading and browsing.</desc>\n"
+				<< "\t\t<rating>" << (nextRandom(seed) % 11) / 10.0f << "</rating>\n"
+				<< "\t\t<releasedate>" << (1985 + nextRandom(seed) % 15) << "0101T000000</releasedate>\n"
+				<< "\t\t<developer>" << DEVELOPERS[nextRandom(seed) % DEVELOPER_COUNT] << "</developer>\n"
+				<< "\t\t<publisher>" << DEVELOPERS[nextRandom(seed) % DEVELOPER_COUNT] << "</publisher>\n"
+				<< "\t\t<genre>" << GENRES[nextRandom(seed) % GENRE_COUNT] << "</genre>\n"
+				<< "\t\t<players>" << (1 + nextRandom(seed) % 4) << "</players>\n";
+
+			if ((int)(nextRandom(seed) % 100) < options.imagePercent)
+			{
+				writeStub(path + "/images/" + stem + ".png", PNG_STUB, sizeof(PNG_STUB));
+				gamelist << "\t\t<image>./images/" << stem << ".png</image>\n";
+			}
+
+			if ((int)(nextRandom(seed) % 100) < options.videoPercent)
+			{
+				writeStub(path + "/videos/" + stem + ".mp4", nullptr, 0);
+				gamelist << "\t\t<video>./videos/" << stem << ".mp4</video>\n";
+			}
+		}
+
+		gamelist << "\t</game>\n";
+	}
+
+	if (!gamelist.is_open())
+		return true;
+
+	gamelist << "</gameList>\n";
+	return !gamelist.fail();
+}
+
+bool LibraryGenerator::generate(const std::string& romsPath, const Options& options)
+{
+	LOG(LogInfo) << "LibraryGenerator::generate() - " << options.systems << " systems of " << options.games << " games in " << romsPath;
+
+	Utils::FileSystem::createDirectory(romsPath);
+
+	std::ofstream systems(Utils::FileSystem::getEsConfigPath() + "/es_systems.cfg", std::ios::out | std::ios::trunc);
+	if (!systems.is_open())
+		return false;
+
+	systems << "<?xml version=\"1.0\"?>\n<systemList>\n";
+
+	for (int i = 0; i < options.systems; i++)
+	{
+		std::string name = getSystemName(i);
+		std::string path = romsPath + "/" + name;
+
+		if (!writeSystem(path, name, i, options))
+		{
+			LOG(LogError) << "LibraryGenerator::generate() - Unable to write " << path;
+			return false;
+		}
+
+		systems << "\t<system>\n"
+			<< "\t\t<name>" << name << "</name>\n"
+			<< "\t\t<fullname>" << name << "</fullname>\n"
+			<< "\t\t<path>" << path << "</path>\n"
+			<< "\t\t<extension>.zip</extension>\n"
+			<< "\t\t<command>true %ROM%</command>\n"
+			<< "\t\t<platform>" << SYSTEM_NAMES[i % SYSTEM_NAME_COUNT] << "</platform>\n"
+			<< "\t\t<theme>" << SYSTEM_NAMES[i % SYSTEM_NAME_COUNT] << "</theme>\n"
+			<< "\t</system>\n";
+	}
+
+	systems << "</systemList>\n";
+	return !systems.fail();
+}
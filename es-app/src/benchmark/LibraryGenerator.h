@@ -0,0 +1,34 @@
+#pragma once
+#ifndef ES_APP_BENCHMARK_LIBRARY_GENERATOR_H
+#define ES_APP_BENCHMARK_LIBRARY_GENERATOR_H
+
+#include <string>
+
+// Writes a synthetic library : es_systems.cfg in the ES config path, and under romsPath one folder per system
+// with empty rom files, media stubs and a gamelist.xml. The same options always give the same library.
+class LibraryGenerator
+{
+public:
+	enum Metadata
+	{
+		METADATA_NONE	= 0, // no gamelist.xml
+		METADATA_NAME	= 1, // path & name
+		METADATA_FULL	= 2  // + description, rating, date, developer, genre, players, media
+	};
+
+	struct Options
+	{
+		Options() : systems(4), games(500), depth(0), imagePercent(100), videoPercent(0), metadata(METADATA_FULL) { }
+
+		int systems;
+		int games;			// per system
+		int depth;			// folder levels, 4 subfolders per level. 0 = every rom in the system folder
+		int imagePercent;	// games with an image (written for METADATA_FULL)
+		int videoPercent;	// games with a video
+		Metadata metadata;
+	};
+
+	static bool generate(const std::string& romsPath, const Options& options);
+};
+
+#endif // ES_APP_BENCHMARK_LIBRARY_GENERATOR_H
@@ -0,0 +1,274 @@
+#include "benchmark/StartupBenchmark.h"
+
+#include "utils/FileSystemUtil.h"
+#include "views/ViewController.h"
+#include "CollectionSystemManager.h"
+#include "FileData.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include "Window.h"
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+static const char* PHASES[] =
+{
+	"SystemData::loadSystem",
+	"SystemData::populateFolder",
+	"SystemData::parseGamelist",
+	"SystemData::loadTheme",
+	"CollectionSystemManager::loadCollectionSystems",
+	"CollectionSystemManager::updateSystemsList",
+	"ViewController::preload",
+	"TextureLoader::load"
+};
+
+static unsigned long long getReadSyscalls()
+{
+	std::ifstream io("/proc/self/io");
+
+	std::string key;
+	unsigned long long value;
+	while (io >> key >> value)
+		if (key == "syscr:")
+			return value;
+
+	return 0;
+}
+
+static float getElapsed(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void removeCache()
+{
+	std::string path = Utils::FileSystem::getEsConfigPath() + "/cache";
+	if (!Utils::FileSystem::exists(path))
+		return;
+
+	for (auto file : Utils::FileSystem::getDirContent(path, true))
+		if (!Utils::FileSystem::isDirectory(file))
+			Utils::FileSystem::removeFile(file);
+}
+
+// One line per value, "name<tab>value", phases last
+static std::string serialize(const StartupBenchmark::Result& result)
+{
+	std::ostringstream out;
+	out << "loadConfig\t" << result.loadConfig << "\n"
+		<< "preload\t" << result.preload << "\n"
+		<< "peakRss\t" << result.peakRss << "\n"
+		<< "statCalls\t" << result.statCalls << "\n"
+		<< "dirReads\t" << result.dirReads << "\n"
+		<< "readCalls\t" << result.readCalls << "\n"
+		<< "games\t" << result.games << "\n";
+
+	for (auto& phase : result.phases)
+		out << "phase:" << phase.first << "\t" << phase.second << "\n";
+
+	return out.str();
+}
+
+static void deserialize(const std::string& data, StartupBenchmark::Result& result)
+{
+	std::istringstream in(data);
+	std::string line;
+
+	while (std::getline(in, line))
+	{
+		size_t tab = line.find('\t');
+		if (tab == std::string::npos)
+			continue;
+
+		std::string name = line.substr(0, tab);
+		std::istringstream value(line.substr(tab + 1));
+
+		if (name == "loadConfig") value >> result.loadConfig;
+		else if (name == "preload") value >> result.preload;
+		else if (name == "peakRss") value >> result.peakRss;
+		else if (name == "statCalls") value >> result.statCalls;
+		else if (name == "dirReads") value >> result.dirReads;
+		else if (name == "readCalls") value >> result.readCalls;
+		else if (name == "games") value >> result.games;
+		else if (name.find("phase:") == 0)
+		{
+			float time = 0;
+			value >> time;
+			result.phases.push_back(std::pair<std::string, float>(name.substr(6), time));
+		}
+	}
+}
+
+// Runs in the forked process
+static bool measure(StartupBenchmark::Result& result)
+{
+	Settings::getInstance()->setBool("ThreadedLoading", result.threaded);
+	Settings::getInstance()->setBool("ParseGamelistOnly", result.parseGamelistOnly);
+
+	Window window;
+	ViewController::init(&window);
+	CollectionSystemManager::init(&window);
+	window.pushGui(ViewController::get());
+
+	if (!window.init(true, true))
+		return false;
+
+	Profiler::setEnabled(true);
+	Profiler::clear();
+
+	Utils::FileSystem::FileCacheStats fileStats = Utils::FileSystem::getFileCacheStats();
+	unsigned long long readCalls = getReadSyscalls();
+
+	auto start = std::chrono::steady_clock::now();
+	if (!SystemData::loadConfig(&window) || SystemData::sSystemVector.size() == 0)
+		return false;
+
+	result.loadConfig = getElapsed(start);
+
+	start = std::chrono::steady_clock::now();
+	ViewController::get()->preload();
+	result.preload = getElapsed(start);
+
+	Utils::FileSystem::FileCacheStats endStats = Utils::FileSystem::getFileCacheStats();
+	result.statCalls = endStats.statCalls - fileStats.statCalls;
+	result.dirReads = endStats.dirReads - fileStats.dirReads;
+	result.readCalls = getReadSyscalls() - readCalls;
+
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		result.peakRss = usage.ru_maxrss;
+
+	for (auto system : SystemData::sSystemVector)
+		if (system->isGameSystem() && !system->isCollection())
+			result.games += system->getGameCount();
+
+	auto totals = Profiler::getTotals();
+	for (auto phase : PHASES)
+	{
+		auto it = totals.find(phase);
+		if (it != totals.cend())
+			result.phases.push_back(std::pair<std::string, float>(phase, it->second / 1000.0f));
+	}
+
+	return true;
+}
+
+bool StartupBenchmark::runChild(bool threaded, bool parseGamelistOnly, Result& result)
+{
+	result.threaded = threaded;
+	result.parseGamelistOnly = parseGamelistOnly;
+
+	if (mCold)
+		removeCache();
+
+	int fds[2];
+	if (pipe(fds) != 0)
+		return false;
+
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if (pid == 0)
+	{
+		close(fds[0]);
+
+		// The parent owns the exit path : skip the destructors, they'd only add noise to the log
+		if (!measure(result))
+			_exit(1);
+
+		std::string data = serialize(result);
+		if (write(fds[1], data.c_str(), data.size()) != (ssize_t)data.size())
+			_exit(1);
+
+		close(fds[1]);
+		_exit(0);
+	}
+
+	close(fds[1]);
+
+	std::string data;
+	char buffer[1024];
+	ssize_t size;
+	while ((size = read(fds[0], buffer, sizeof(buffer))) > 0)
+		data.append(buffer, size);
+
+	close(fds[0]);
+
+	int status = 0;
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	{
+		LOG(LogError) << "StartupBenchmark - Run failed (ThreadedLoading " << threaded << ", ParseGamelistOnly " << parseGamelistOnly << ")";
+		return false;
+	}
+
+	deserialize(data, result);
+	return true;
+}
+
+bool StartupBenchmark::run()
+{
+	// Fills the page cache and, unless cold, the ES caches
+	Result warmUp;
+	if (!runChild(true, false, warmUp))
+		return false;
+
+	for (int threaded = 0; threaded < 2; threaded++)
+	{
+		for (int parseGamelistOnly = 0; parseGamelistOnly < 2; parseGamelistOnly++)
+		{
+			Result result;
+			if (!runChild(threaded != 0, parseGamelistOnly != 0, result))
+				return false;
+
+			mResults.push_back(result);
+		}
+	}
+
+	return true;
+}
+
+void StartupBenchmark::printReport(std::ostream& out) const
+{
+	out << std::left << std::setw(10) << "threaded" << std::setw(12) << "gamelist" << std::right
+		<< std::setw(8) << "games"
+		<< std::setw(11) << "config ms"
+		<< std::setw(12) << "preload ms"
+		<< std::setw(11) << "peak KB"
+		<< std::setw(8) << "stat"
+		<< std::setw(9) << "opendir"
+		<< std::setw(8) << "read" << "\n";
+
+	out << std::fixed << std::setprecision(2);
+
+	for (auto& result : mResults)
+	{
+		out << std::left << std::setw(10) << (result.threaded ? "yes" : "no") << std::setw(12) << (result.parseGamelistOnly ? "only" : "and scan") << std::right
+			<< std::setw(8) << result.games
+			<< std::setw(11) << result.loadConfig
+			<< std::setw(12) << result.preload
+			<< std::setw(11) << result.peakRss
+			<< std::setw(8) << result.statCalls
+			<< std::setw(9) << result.dirReads
+			<< std::setw(8) << result.readCalls << "\n";
+	}
+
+	for (auto& result : mResults)
+	{
+		out << "\nThreadedLoading " << (result.threaded ? "on" : "off") << ", ParseGamelistOnly " << (result.parseGamelistOnly ? "on" : "off") << " (ms, summed over threads)\n";
+
+		for (auto& phase : result.phases)
+			out << "  " << std::left << std::setw(50) << phase.first << std::right << std::setw(10) << phase.second << "\n";
+	}
+}
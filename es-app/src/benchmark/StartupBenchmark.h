@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ES_APP_BENCHMARK_STARTUP_BENCHMARK_H
+#define ES_APP_BENCHMARK_STARTUP_BENCHMARK_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Measures the startup (loadConfig, collections included, then ViewController::preload) once per loading
+// configuration. Each run is a forked process, so it starts with empty caches, and its peak RSS is its own.
+class StartupBenchmark
+{
+public:
+	struct Result
+	{
+		Result() : threaded(false), parseGamelistOnly(false), loadConfig(0), preload(0), peakRss(0), statCalls(0), dirReads(0), readCalls(0), games(0) { }
+
+		bool				threaded;
+		bool				parseGamelistOnly;
+
+		float				loadConfig;	// ms
+		float				preload;	// ms
+		long				peakRss;	// KB
+		unsigned long long	statCalls;	// Utils::FileSystem stat / lstat
+		unsigned long long	dirReads;	// Utils::FileSystem opendir
+		unsigned long long	readCalls;	// read syscalls, from /proc/self/io
+		int					games;
+
+		std::vector<std::pair<std::string, float>> phases; // profiler scopes, ms summed over threads
+	};
+
+	// cold : removes [config]/cache before each run
+	StartupBenchmark(bool cold) : mCold(cold) { }
+
+	// Runs every ThreadedLoading x ParseGamelistOnly combination, after a discarded warm up run. False if a run failed
+	bool run();
+	void printReport(std::ostream& out) const;
+
+private:
+	bool runChild(bool threaded, bool parseGamelistOnly, Result& result);
+
+	bool				mCold;
+	std::vector<Result>	mResults;
+};
+
+#endif // ES_APP_BENCHMARK_STARTUP_BENCHMARK_H
@@ -0,0 +1,307 @@
+// es-benchmark : runs the views against a synthetic library with the headless renderer (HEADLESS=ON builds),
+// scripting inputs and reporting frame times, draw calls, texture uploads and allocations per scenario.
+// With --startup, measures the library loading instead, for each ThreadedLoading / ParseGamelistOnly combination.
+
+#include "benchmark/BenchmarkRunner.h"
+#include "benchmark/LibraryGenerator.h"
+#include "benchmark/StartupBenchmark.h"
+#include "renderers/Renderer.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "views/ViewController.h"
+#include "CollectionSystemManager.h"
+#include "InputConfig.h"
+#include "InputManager.h"
+#include "Log.h"
+#include "MameNames.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include "Window.h"
+#include <SDL.h>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+void* operator new(size_t size)
+{
+	BenchmarkRunner::sAllocations++;
+
+	void* ptr = malloc(size == 0 ? 1 : size);
+	if (ptr == nullptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+struct BenchmarkOptions
+{
+	BenchmarkOptions() : home("/tmp/es-benchmark"), scenarios("systems,gamelist,grid,menu"), generate(true), generateOnly(false), startup(false), cold(false), maxP99(0.0f) { }
+
+	std::string home;
+	std::string scenarios;
+	std::string theme;
+	bool generate;
+	bool generateOnly;
+	bool startup;
+	bool cold;
+	float maxP99; // ms, 0 = no limit
+
+	LibraryGenerator::Options library;
+};
+
+static void printUsage()
+{
+	std::cout <<
+		"es-benchmark [options]\n"
+		"  --home PATH          home folder, default /tmp/es-benchmark. Themes are read from PATH/.emulationstation/themes\n"
+		"  --systems N          systems to generate (4)\n"
+		"  --games N            games per system (500)\n"
+		"  --depth N            folder levels in each system, 4 subfolders per level (0)\n"
+		"  --images PERCENT     games with an image (100)\n"
+		"  --videos PERCENT     games with a video (0)\n"
+		"  --metadata LEVEL     gamelist.xml content : 0 none, 1 names, 2 full (2)\n"
+		"  --no-generate        keep the library already in PATH\n"
+		"  --generate-only      write the library and exit\n"
+		"  --startup            measure the startup instead of the scenarios\n"
+		"  --cold               with --startup, remove PATH/.emulationstation/cache before each run\n"
+		"  --resolution W H     screen size (640 480)\n"
+		"  --theme NAME         theme set\n"
+		"  --scenarios LIST     comma separated : systems, gamelist, grid, menu (all)\n"
+		"  --max-p99 MS         exit with 2 if a scenario's 99th percentile frame time is above MS\n";
+}
+
+static bool parseArgs(int argc, char* argv[], BenchmarkOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i < argc - 1;
+
+		if (strcmp(argv[i], "--home") == 0 && hasValue)
+			options.home = argv[++i];
+		else if (strcmp(argv[i], "--systems") == 0 && hasValue)
+			options.library.systems = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--games") == 0 && hasValue)
+			options.library.games = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--depth") == 0 && hasValue)
+			options.library.depth = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--images") == 0 && hasValue)
+			options.library.imagePercent = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--videos") == 0 && hasValue)
+			options.library.videoPercent = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--metadata") == 0 && hasValue)
+		{
+			int level = atoi(argv[++i]);
+			options.library.metadata = level <= 0 ? LibraryGenerator::METADATA_NONE : level == 1 ? LibraryGenerator::METADATA_NAME : LibraryGenerator::METADATA_FULL;
+		}
+		else if (strcmp(argv[i], "--no-generate") == 0)
+			options.generate = false;
+		else if (strcmp(argv[i], "--generate-only") == 0)
+			options.generateOnly = true;
+		else if (strcmp(argv[i], "--startup") == 0)
+			options.startup = true;
+		else if (strcmp(argv[i], "--cold") == 0)
+			options.cold = true;
+		else if (strcmp(argv[i], "--resolution") == 0 && i < argc - 2)
+		{
+			Settings::getInstance()->setInt("WindowWidth", atoi(argv[++i]));
+			Settings::getInstance()->setInt("WindowHeight", atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--theme") == 0 && hasValue)
+			options.theme = argv[++i];
+		else if (strcmp(argv[i], "--scenarios") == 0 && hasValue)
+			options.scenarios = argv[++i];
+		else if (strcmp(argv[i], "--max-p99") == 0 && hasValue)
+			options.maxP99 = (float)atof(argv[++i]);
+		else
+		{
+			printUsage();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// The benchmark home has no es_input.cfg
+static void mapKeyboard()
+{
+	InputConfig* config = InputManager::getInstance()->getInputConfigByDevice(DEVICE_KEYBOARD);
+	config->clear();
+
+	config->mapInput("up", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_UP, 1, true));
+	config->mapInput("down", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_DOWN, 1, true));
+	config->mapInput("left", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_LEFT, 1, true));
+	config->mapInput("right", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_RIGHT, 1, true));
+	config->mapInput("a", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_RETURN, 1, true));
+	config->mapInput("b", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_ESCAPE, 1, true));
+	config->mapInput("start", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_F1, 1, true));
+	config->mapInput("select", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_F2, 1, true));
+	config->mapInput("pageup", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_RIGHTBRACKET, 1, true));
+	config->mapInput("pagedown", Input(DEVICE_KEYBOARD, TYPE_KEY, SDLK_LEFTBRACKET, 1, true));
+}
+
+static void scrollGameList(BenchmarkRunner& runner, const char* direction)
+{
+	runner.press(BUTTON_OK, 1, 60);
+	runner.press(direction, 180, 30);
+
+	for (int i = 0; i < 20; i++)
+		runner.press("up", 1, 5);
+
+	runner.press(BUTTON_BACK, 1, 60);
+}
+
+static void runScenario(BenchmarkRunner& runner, Window* window, const std::string& name)
+{
+	if (name == "systems")
+	{
+		for (unsigned int i = 0; i < SystemData::sSystemVector.size() * 2; i++)
+			runner.press("right", 1, 20);
+	}
+	else if (name == "gamelist")
+		scrollGameList(runner, "down");
+	else if (name == "grid")
+	{
+		std::string style = Settings::getInstance()->getString("GamelistViewStyle");
+
+		Settings::getInstance()->setString("GamelistViewStyle", "grid");
+		ViewController::get()->reloadAll(window);
+		runner.runFrames(30);
+
+		scrollGameList(runner, "right");
+
+		Settings::getInstance()->setString("GamelistViewStyle", style);
+		ViewController::get()->reloadAll(window);
+		return;
+	}
+	else if (name == "menu")
+	{
+		runner.press("start", 1, 60);
+
+		for (int i = 0; i < 20; i++)
+			runner.press("down", 1, 8);
+
+		runner.press(BUTTON_BACK, 1, 30);
+	}
+	else
+		std::cerr << "Unknown scenario " << name << "\n";
+}
+
+int main(int argc, char* argv[])
+{
+	std::locale::global(std::locale("C"));
+	Utils::FileSystem::setExePath(argv[0]);
+
+	// --home must be set before the settings are loaded
+	BenchmarkOptions options;
+	for (int i = 1; i < argc - 1; i++)
+		if (strcmp(argv[i], "--home") == 0)
+			options.home = argv[i + 1];
+
+	Utils::FileSystem::setHomePath(options.home);
+	Utils::FileSystem::createDirectory(options.home);
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getEsConfigPath());
+
+	if (!parseArgs(argc, argv, options))
+		return 1;
+
+	Log::setupReportingLevel();
+	Log::init();
+
+	Settings::getInstance()->setBool("SplashScreen", false);
+	if (!options.theme.empty())
+		Settings::getInstance()->setString("ThemeSet", options.theme);
+
+	if (options.generate && !LibraryGenerator::generate(options.home + "/roms", options.library))
+	{
+		std::cerr << "Unable to generate the library in " << options.home << "\n";
+		return 1;
+	}
+
+	if (options.generateOnly)
+		return 0;
+
+	if (options.startup)
+	{
+		StartupBenchmark startup(options.cold);
+		if (!startup.run())
+		{
+			std::cerr << "Startup benchmark failed, see " << Utils::FileSystem::getEsConfigPath() << "/es_log.txt\n";
+			return 1;
+		}
+
+		startup.printReport(std::cout);
+		return 0;
+	}
+
+	Window window;
+	ViewController::init(&window);
+	CollectionSystemManager::init(&window);
+	MameNames::init();
+	window.pushGui(ViewController::get());
+
+	if (!window.init(true, true))
+	{
+		std::cerr << "Renderer failed to initialize\n";
+		return 1;
+	}
+
+	mapKeyboard();
+	InputConfig::AssignActionButtons();
+
+	if (!SystemData::loadConfig(&window) || SystemData::sSystemVector.size() == 0)
+	{
+		std::cerr << "No systems loaded from " << SystemData::getConfigPath(false) << "\n";
+		return 1;
+	}
+
+	ViewController::get()->preload();
+	ViewController::get()->goToStart(true);
+	window.endRenderLoadingScreen();
+
+	BenchmarkRunner runner(&window);
+	runner.runFrames(60);
+
+	for (auto name : Utils::String::split(options.scenarios, ','))
+	{
+		runner.beginScenario(name);
+		runScenario(runner, &window, name);
+		runner.endScenario();
+
+		// let the transitions end
+		runner.runFrames(30);
+	}
+
+	std::cout << SystemData::sSystemVector.size() << " systems, " << Renderer::getScreenWidth() << "x" << Renderer::getScreenHeight() << "\n";
+
+	runner.printReport(std::cout);
+
+	int exitCode = 0;
+	if (options.maxP99 > 0)
+	{
+		for (auto& result : runner.getResults())
+		{
+			if (result.getPercentile(99) > options.maxP99)
+			{
+				std::cerr << result.name << " : 99th percentile " << result.getPercentile(99) << " ms is above " << options.maxP99 << " ms\n";
+				exitCode = 2;
+			}
+		}
+	}
+
+	while (window.peekGui() != ViewController::get())
+		delete window.peekGui();
+
+	MameNames::deinit();
+	CollectionSystemManager::deinit();
+	SystemData::deleteSystems();
+	window.deinit(true);
+
+	return exitCode;
+}
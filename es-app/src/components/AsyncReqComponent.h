@@ -34,6 +34,7 @@ public:
 
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
+	bool isAnimating() override { return true; } // spinner
 	void render(const Transform4x4f& parentTrans) override;
 
 	virtual std::vector<HelpPrompt> getHelpPrompts() override;
@@ -114,7 +114,7 @@ void RatingComponent::render(const Transform4x4f& parentTrans)
 	if (mFilledTexture == nullptr || mUnfilledTexture == nullptr)
 		return;
 
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 	
 
 	Vector2f clipPos(trans.translation().x(), trans.translation().y());
@@ -123,7 +123,7 @@ void RatingComponent::render(const Transform4x4f& parentTrans)
 
 	Renderer::setMatrix(trans);
 
-	if (Settings::getInstance()->getBool("DebugImage"))
+	if (Settings::getInstance()->getBool(SettingKey::DebugImage))
 		Renderer::drawRect(0.0f, 0.0f, mSize.x(), mSize.y(), 0xFFFF0033, 0xFFFF0033);
 
 	if (mUnfilledTexture->bind())
@@ -361,7 +361,7 @@ bool ScraperSearchComponent::input(InputConfig* config, Input input)
 
 void ScraperSearchComponent::render(const Transform4x4f& parentTrans)
 {
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 
 	renderChildren(trans);
 
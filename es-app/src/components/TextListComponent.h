@@ -41,6 +41,7 @@ public:
 	
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
+	bool isAnimating() override { return mMarqueeOffset != 0 || mMarqueeOffset2 != 0 || IList<TextListData, T>::isAnimating(); }
 	void render(const Transform4x4f& parentTrans) override;
 	void applyTheme(const std::shared_ptr<ThemeData>& theme, const std::string& view, const std::string& element, unsigned int properties) override;
 
@@ -137,7 +138,7 @@ TextListComponent<T>::TextListComponent(Window* window) :
 template <typename T>
 void TextListComponent<T>::render(const Transform4x4f& parentTrans)
 {
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = GuiComponent::getWorldTransform(parentTrans);
 	
 	std::shared_ptr<Font>& font = mFont;
 
@@ -1567,6 +1567,12 @@ void GuiMenu::openAdvancedSettings()
 		PowerSaver::init();
 	});
 
+	// don't render frames while nothing moves on screen
+	auto skip_idle_frames = std::make_shared<SwitchComponent>(mWindow);
+	skip_idle_frames->setState(Settings::getInstance()->getBool("SkipIdleFrames"));
+	s->addWithLabel(_("SKIP IDLE FRAMES"), skip_idle_frames);
+	s->addSaveFunc([skip_idle_frames] { Settings::getInstance()->setBool("SkipIdleFrames", skip_idle_frames->getState()); });
+
 
 	// maximum vram
 	auto max_vram = std::make_shared<SliderComponent>(mWindow, 40.f, 1000.f, 10.f, "Mb");
@@ -1607,6 +1613,24 @@ void GuiMenu::openAdvancedSettings()
 		Settings::getInstance()->setBool("OptimizeVRAM", optimizeVram->getState());
 	});
 
+	// game art texture compression
+	auto textureCompression = std::make_shared< OptionListComponent<std::string> >(mWindow, _("GAME ART TEXTURE FORMAT"), false);
+	bool etc1Supported = Renderer::isTextureTypeSupported(Renderer::Texture::ETC1);
+	std::string currentCompression = Settings::getInstance()->getString("TextureCompression");
+	if (currentCompression == "etc1" && !etc1Supported)
+		currentCompression = "none";
+
+	textureCompression->add(_("FULL QUALITY"), "none", currentCompression != "16bit" && currentCompression != "etc1");
+	textureCompression->add(_("16 BIT"), "16bit", currentCompression == "16bit");
+	if (etc1Supported)
+		textureCompression->add(_("ETC1 COMPRESSED"), "etc1", currentCompression == "etc1");
+	s->addWithLabel(_("GAME ART TEXTURE FORMAT"), textureCompression);
+	s->addSaveFunc([textureCompression]
+	{
+		if (Settings::getInstance()->setString("TextureCompression", textureCompression->getSelected()))
+			TextureData::COMPRESSION = TextureData::parseCompression(textureCompression->getSelected());
+	});
+
 	// framerate
 	auto framerate = std::make_shared<SwitchComponent>(mWindow);
 	framerate->setState(Settings::getInstance()->getBool("DrawFramerate"));
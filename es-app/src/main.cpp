@@ -4,6 +4,7 @@
 #include "guis/GuiDetectDevice.h"
 #include "guis/GuiMsgBox.h"
 #include "utils/FileSystemUtil.h"
+#include "utils/PixelUtil.h"
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
 #include "EmulationStation.h"
@@ -12,6 +13,8 @@
 #include "MameNames.h"
 #include "platform.h"
 #include "PowerSaver.h"
+#include "Profiler.h"
+#include "SensorService.h"
 #include "ScraperCmdLine.h"
 #include "Settings.h"
 #include "SystemData.h"
@@ -20,11 +23,13 @@
 #include <SDL_main.h>
 #include <SDL_timer.h>
 #include <iostream>
+#include <signal.h>
 #include <time.h>
 
 #include <unistd.h>
 
 #include "resources/TextureData.h"
+#include "resources/ThumbnailCache.h"
 #include <FreeImage.h>
 #include "AudioManager.h"
 #include "NetworkThread.h"
@@ -262,6 +267,11 @@ bool parseArgs(int argc, char* argv[])
 		{
 			Settings::getInstance()->setBool("ForceDisableFilters", true);
 		}
+		else if (strcmp(argv[i], "--benchmark-pixels") == 0)
+		{
+			std::cout << Utils::Pixel::benchmark();
+			return false; //exit after printing the results
+		}
 		else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
 		{
 			std::cout <<
@@ -286,6 +296,7 @@ bool parseArgs(int argc, char* argv[])
 				"--fullscreen		use fullscreen  mode\n"
 				"--config-path		set config directory path\n"
 				"--userdata-path		set userdata directory path, default '/roms'\n"
+				"--benchmark-pixels		time the pixel conversion kernels and exit\n"
 				"--help, -h			summon a sentient, angry tuba\n\n"
 				"More information available in README.md.\n";
 			return false; //exit after printing help
@@ -354,6 +365,12 @@ void onExit()
 	Log::close();
 }
 
+// SIGUSR2 writes the profiler trace
+static void onProfilerSignal(int)
+{
+	Profiler::requestDump();
+}
+
 void processAudioTitles(Window* window)
 {
 	if (Settings::getInstance()->getBool("MusicTitles"))
@@ -408,6 +425,8 @@ Log::flush();
 	//always close the log on exit
 	atexit(&onExit);
 
+	signal(SIGUSR2, &onProfilerSignal);
+
 	Window window;
 	SystemScreenSaver screensaver(&window);
 	PowerSaver::init();
@@ -417,8 +436,12 @@ Log::flush();
 	window.pushGui(ViewController::get());
 
 	TextureData::OPTIMIZEVRAM = Settings::getInstance()->getBool("OptimizeVRAM");
+	TextureData::COMPRESSION = TextureData::parseCompression(Settings::getInstance()->getString("TextureCompression"));
 	GuiComponent::ALLOWANIMATIONS = Settings::getInstance()->getString("TransitionStyle") != "instant";
 
+	if (Settings::getInstance()->getBool("PersistentFileCache"))
+		Utils::FileSystem::enablePersistentFileCache();
+
 	bool splashScreen = Settings::getInstance()->getBool("SplashScreen");
 	bool splashScreenProgress = Settings::getInstance()->getBool("SplashScreenProgress");
 
@@ -430,6 +453,8 @@ Log::flush();
 			return 1;
 		}
 
+		SensorService::getInstance()->start();
+
 		if (splashScreen)
 			window.renderLoadingScreen(_("Loading..."));
 	}
@@ -517,6 +542,7 @@ Log::flush();
 	int exitMode = 0;
 
 	bool running = true;
+	bool idle = false; // nothing was rendered on the last iteration
 
 	while(running)
 	{
@@ -525,7 +551,20 @@ Log::flush();
 		SDL_Event event;
 		bool ps_standby = PowerSaver::getState() && (int) SDL_GetTicks() - ps_time > PowerSaver::getMode();
 
-		if (ps_standby ? SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) : SDL_PollEvent(&event))
+		// idle frames : block until an event or the next periodic refresh
+		int idleTimeout = idle ? window.getIdleTimeout() : 0;
+
+		bool hasEvent;
+		if (ps_standby)
+			hasEvent = SDL_WaitEventTimeout(&event, PowerSaver::getTimeout());
+		else if (idleTimeout > 0)
+			hasEvent = SDL_WaitEventTimeout(&event, idleTimeout);
+		else
+			hasEvent = SDL_PollEvent(&event);
+
+		Profiler::beginFrame();
+
+		if (hasEvent)
 		{
 			do
 			{
@@ -537,12 +576,13 @@ Log::flush();
 			while(SDL_PollEvent(&event));
 
 			// triggered if exiting from SDL_WaitEvent due to event
-			if (ps_standby)
+			if (ps_standby || idleTimeout > 0)
 				// show as if continuing from last event
 				lastTime = SDL_GetTicks();
 
 			// reset counter
 			ps_time = SDL_GetTicks();
+			window.requestRedraw();
 		}
 		else if (ps_standby)
 		{
@@ -569,13 +609,28 @@ Log::flush();
 		processAudioTitles(&window);
 
 		window.update(deltaTime);
+
+		idle = !window.needsRedraw();
+		if (idle)
+		{
+			window.skipFrame();
+			Log::flush();
+			Profiler::endFrame();
+			continue;
+		}
+
 		window.render();
 		
 		Log::flush();
 
 		int processDuration = SDL_GetTicks() - processStart;
 		
-		Renderer::swapBuffers();
+		{
+			PROFILE_SCOPE("Renderer::swapBuffers");
+			Renderer::swapBuffers();
+		}
+
+		Profiler::endFrame();
 	}
 
 	ThreadedScraper::stop();
@@ -587,6 +642,7 @@ Log::flush();
 		window.renderLoadingScreen(_("SAVING DATA. PLEASE WAIT..."));
 
 	ImageIO::saveImageCache();
+	ThumbnailCache::getInstance()->flush();
 	MameNames::deinit();
 	CollectionSystemManager::deinit();
 	SystemData::deleteSystems();
@@ -597,6 +653,8 @@ Log::flush();
 #endif
 
 	window.deinit(true);
+	SensorService::getInstance()->stop();
+	Utils::FileSystem::disablePersistentFileCache();
 
 	processQuitMode();
 
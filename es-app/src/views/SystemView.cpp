@@ -5,6 +5,7 @@
 #include "views/UIModeController.h"
 #include "views/ViewController.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "EsLocale.h"
@@ -332,7 +333,7 @@ bool SystemView::input(InputConfig* config, Input input)
 {
 	if(input.value != 0)
 	{
-		if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_r && SDL_GetModState() & KMOD_LCTRL && Settings::getInstance()->getBool("Debug"))
+		if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_r && SDL_GetModState() & KMOD_LCTRL && Settings::getInstance()->getBool(SettingKey::Debug))
 		{
 			LOG(LogInfo) << "SystemView::input() - Reloading all";
 			ViewController::get()->reloadAll();
@@ -447,7 +448,7 @@ bool SystemView::input(InputConfig* config, Input input)
 			config->isMappedTo(BUTTON_PD, input) ||
 			config->isMappedTo(BUTTON_PU, input))
 			listInput(0);
-		if(!UIModeController::getInstance()->isUIModeKid() && config->isMappedTo("select", input) && Settings::getInstance()->getBool("ScreenSaverControls"))
+		if(!UIModeController::getInstance()->isUIModeKid() && config->isMappedTo("select", input) && Settings::getInstance()->getBool(SettingKey::ScreenSaverControls))
 		{
 			mWindow->startScreenSaver();
 			mWindow->renderScreenSaver();
@@ -465,6 +466,20 @@ void SystemView::update(int deltaTime)
 	GuiComponent::update(deltaTime);
 }
 
+bool SystemView::isAnimating()
+{
+	if (IList<SystemViewData, SystemData*>::isAnimating())
+		return true;
+
+	// only the extras of the selected system are on screen when the carousel doesn't move
+	if (mCursor >= 0 && mCursor < (int)mEntries.size())
+		for (auto extra : mEntries.at(mCursor).data.backgroundExtras)
+			if (extra->isVisible() && extra->isAnimating())
+				return true;
+
+	return false;
+}
+
 void SystemView::onCursorChanged(const CursorState& /*state*/)
 {
 	if (mLastSystem != getSelected()) {
@@ -496,7 +511,7 @@ void SystemView::onCursorChanged(const CursorState& /*state*/)
 	cancelAnimation(1);
 	cancelAnimation(2);
 
-	std::string transition_style = Settings::getInstance()->getString("TransitionStyle");
+	std::string transition_style = Settings::getInstance()->getString(SettingKey::TransitionStyle);
 	if (transition_style == "auto")
 	{
 		if (mCarousel.defaultTransition == "instant" || mCarousel.defaultTransition == "fade" || mCarousel.defaultTransition == "slide")
@@ -696,7 +711,7 @@ std::vector<HelpPrompt> SystemView::getHelpPrompts()
 	prompts.push_back(HelpPrompt(BUTTON_OK, _("SELECT")));
 	prompts.push_back(HelpPrompt("x", _("RANDOM")));
 
-	if (!UIModeController::getInstance()->isUIModeKid() && Settings::getInstance()->getBool("ScreenSaverControls"))
+	if (!UIModeController::getInstance()->isUIModeKid() && Settings::getInstance()->getBool(SettingKey::ScreenSaverControls))
 		prompts.push_back(HelpPrompt("select", _("LAUNCH SCREENSAVER")));
 
 	return prompts;
@@ -772,6 +787,8 @@ void  SystemView::getViewElements(const std::shared_ptr<ThemeData>& theme)
 //  Render system carousel
 void SystemView::renderCarousel(const Transform4x4f& trans)
 {
+	PROFILE_SCOPE("SystemView::renderCarousel");
+
 	// background box behind logos
 	Transform4x4f carouselTrans = trans;
 	carouselTrans.translate(Vector3f(mCarousel.pos.x(), mCarousel.pos.y(), 0.0));
@@ -63,6 +63,7 @@ public:
 
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
+	bool isAnimating() override;
 	void render(const Transform4x4f& parentTrans) override;
 
 	void onThemeChanged(const std::shared_ptr<ThemeData>& theme);
@@ -19,12 +19,12 @@ UIModeController::UIModeController()
 	:mPassKeyCounter(0)
 {
 	mPassKeySequence = Settings::getInstance()->getString("UIMode_passkey");
-	mCurrentUIMode = Settings::getInstance()->getString("UIMode");
+	mCurrentUIMode = Settings::getInstance()->getString(SettingKey::UIMode);
 }
 
 void UIModeController::monitorUIMode()
 {
-	std::string uimode = Settings::getInstance()->getString("UIMode");
+	std::string uimode = Settings::getInstance()->getString(SettingKey::UIMode);
 	if (uimode != mCurrentUIMode) // UIMODE HAS CHANGED
 	{
 		mCurrentUIMode = uimode;
@@ -36,12 +36,12 @@ bool UIModeController::listen(InputConfig * config, Input input)
 {
 	// Reads the current input to listen for the passkey
 	// sequence to unlock the UI mode. The progress is saved in mPassKeyCounter
-	if (Settings::getInstance()->getBool("Debug"))
+	if (Settings::getInstance()->getBool(SettingKey::Debug))
 	{
 		logInput(config, input);
 	}
 
-	if ((Settings::getInstance()->getString("UIMode") == "Full") || !isValidInput(config, input))
+	if ((Settings::getInstance()->getString(SettingKey::UIMode) == "Full") || !isValidInput(config, input))
 	{
 		return false; // Already unlocked, or invalid input, nothing to do here.
 	}
@@ -85,19 +85,19 @@ void UIModeController::unlockUIMode()
 
 bool UIModeController::isUIModeFull()
 {
-	return ((mCurrentUIMode == "Full") && !Settings::getInstance()->getBool("ForceKiosk"));
+	return ((mCurrentUIMode == "Full") && !Settings::getInstance()->getBool(SettingKey::ForceKiosk));
 }
 
 bool UIModeController::isUIModeKid()
 {
-	return (Settings::getInstance()->getBool("ForceKid") ||
-		((mCurrentUIMode == "Kid") && !Settings::getInstance()->getBool("ForceKiosk")));
+	return (Settings::getInstance()->getBool(SettingKey::ForceKid) ||
+		((mCurrentUIMode == "Kid") && !Settings::getInstance()->getBool(SettingKey::ForceKiosk)));
 }
 
 bool UIModeController::isUIModeKiosk()
 {
-	return (Settings::getInstance()->getBool("ForceKiosk") ||
-		((mCurrentUIMode == "Kiosk") && !Settings::getInstance()->getBool("ForceKid")));
+	return (Settings::getInstance()->getBool(SettingKey::ForceKiosk) ||
+		((mCurrentUIMode == "Kiosk") && !Settings::getInstance()->getBool(SettingKey::ForceKid)));
 }
 
 std::string UIModeController::getFormattedPassKeyStr()
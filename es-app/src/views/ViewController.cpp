@@ -14,6 +14,7 @@
 #include "FileFilterIndex.h"
 #include "CollectionSystemManager.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "Window.h"
@@ -191,7 +192,7 @@ void ViewController::playViewTransition(bool forceImmediate)
 	if(target == -mCamera.translation() && !isAnimationPlaying(0))
 		return;
 
-	std::string transition_style = Settings::getInstance()->getString("TransitionStyle");
+	std::string transition_style = Settings::getInstance()->getString(SettingKey::TransitionStyle);
 	if (!forceImmediate && transition_style == "fade")
 	{
 		// fade
@@ -540,8 +541,21 @@ void ViewController::update(int deltaTime)
 	updateSelf(deltaTime);
 }
 
+bool ViewController::isAnimating()
+{
+	// camera moves & fades
+	for (unsigned char i = 0; i < MAX_ANIMATIONS; i++)
+		if (isAnimationPlaying(i))
+			return true;
+
+	// the other views are off screen
+	return mCurrentView && mCurrentView->isAnimating();
+}
+
 void ViewController::render(const Transform4x4f& parentTrans)
 {
+	PROFILE_SCOPE("ViewController::render");
+
 	Transform4x4f trans = mCamera * parentTrans;
 	Transform4x4f transInverse;
 	transInverse.invert(trans);
@@ -590,6 +604,8 @@ void ViewController::render(const Transform4x4f& parentTrans)
 
 void ViewController::preload()
 {
+	PROFILE_SCOPE("ViewController::preload");
+
 	bool preloadUI = Settings::getInstance()->getBool("PreloadUI");
 	if (!preloadUI)
 		return;
@@ -707,7 +723,7 @@ void ViewController::reloadAll(Window* window, bool reloadTheme)
 		int processedSystem = 0;
 		int systemCount = cursorMap.size();
 
-		Utils::ThreadPool pool;
+		Utils::TaskGroup pool;
 
 		for (auto it = cursorMap.cbegin(); it != cursorMap.cend(); it++)
 		{
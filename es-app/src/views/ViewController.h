@@ -56,6 +56,7 @@ public:
 
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
+	bool isAnimating() override;
 	void render(const Transform4x4f& parentTrans) override;
 
 	enum GameListViewType
@@ -1,4 +1,5 @@
 #include "views/gamelist/GridGameListView.h"
+#include "resources/ThumbnailCache.h"
 
 #include "animations/LambdaAnimation.h"
 #include "views/UIModeController.h"
@@ -309,8 +310,15 @@ void GridGameListView::populateList(const std::vector<FileData*>& files)
 			}
 		}
 
+		std::vector<std::string> warmupPaths;
+		warmupPaths.reserve(files.size());
+
 		for (auto file : files)
 		{
+			std::string path = getImagePath(file);
+			if (!path.empty())
+				warmupPaths.push_back(path);
+
 			if (file->getFavorite())
 			{
 				if (favoritesFirst)
@@ -318,17 +326,20 @@ void GridGameListView::populateList(const std::vector<FileData*>& files)
 
 				if (showFavoriteIcon)
 				{
-					mGrid.add(_U("\uF006 ") + file->getName(), getImagePath(file), file->getVideoPath(), file->getMarqueePath(), true, file->getType() != GAME, isVirtualFolder(file), file);
+					mGrid.add(_U("\uF006 ") + file->getName(), path, file->getVideoPath(), file->getMarqueePath(), true, file->getType() != GAME, isVirtualFolder(file), file);
 					continue;
 				}
 			}
 
-			if (file->getType() == FOLDER && Utils::FileSystem::exists(getImagePath(file)))
-				mGrid.add(_U("\uF114 ") + file->getName(), getImagePath(file), file->getVideoPath(), file->getMarqueePath(), file->getFavorite(), file->getType() != GAME, isVirtualFolder(file), file);
+			if (file->getType() == FOLDER && Utils::FileSystem::exists(path))
+				mGrid.add(_U("\uF114 ") + file->getName(), path, file->getVideoPath(), file->getMarqueePath(), file->getFavorite(), file->getType() != GAME, isVirtualFolder(file), file);
 			else
-				mGrid.add(file->getName(), getImagePath(file), file->getVideoPath(), file->getMarqueePath(), file->getFavorite(), file->getType() != GAME, isVirtualFolder(file), file);
+				mGrid.add(file->getName(), path, file->getVideoPath(), file->getMarqueePath(), file->getFavorite(), file->getType() != GAME, isVirtualFolder(file), file);
 		}
 
+		// Prepare the downscaled pictures of the tiles that are not visible yet
+		ThumbnailCache::getInstance()->warmup(warmupPaths);
+
 		// if we have the ".." PLACEHOLDER, then select the first game instead of the placeholder
 		if (mCursorStack.size() && mGrid.size() > 1 && mGrid.getCursorIndex() == 0)
 			mGrid.setCursorIndex(1);
@@ -21,7 +21,7 @@ bool IGameListView::input(InputConfig* config, Input input)
 		return true;
 
 	// Ctrl-R to reload a view when debugging
-	}else if(Settings::getInstance()->getBool("Debug") && config->getDeviceId() == DEVICE_KEYBOARD &&
+	}else if(Settings::getInstance()->getBool(SettingKey::Debug) && config->getDeviceId() == DEVICE_KEYBOARD &&
 		(SDL_GetModState() & (KMOD_LCTRL | KMOD_RCTRL)) && input.id == SDLK_r && input.value != 0)
 	{
 		LOG(LogDebug) << "IGameListView::input() - reloading view";
@@ -47,7 +47,7 @@ HelpStyle IGameListView::getHelpStyle()
 
 void IGameListView::render(const Transform4x4f& parentTrans)
 {
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 
 	float scaleX = trans.r0().x();
 	float scaleY = trans.r1().y();
@@ -8,6 +8,7 @@
 #include "ThemeData.h"
 #include "Window.h"
 #include <algorithm>
+#include <string.h>
 //#include <SDL_timer.h>
 
 bool GuiComponent::ALLOWANIMATIONS = true;
@@ -15,7 +16,7 @@ bool GuiComponent::ALLOWANIMATIONS = true;
 GuiComponent::GuiComponent(Window* window) : mWindow(window), mParent(NULL), mOpacity(255),
 	mPosition(Vector3f::Zero()), mOrigin(Vector2f::Zero()), mRotationOrigin(0.5, 0.5),
 	mSize(Vector2f::Zero()), mTransform(Transform4x4f::Identity()), mIsProcessing(false), mVisible(true),
-	mStaticExtra(false)
+	mStaticExtra(false), mTransformValid(false), mTransformVersion(0), mWorldVersion(0), mWorldTransformValid(false), mScreenBounds(0.0f)
 {
 	for(unsigned char i = 0; i < MAX_ANIMATIONS; i++)
 		mAnimationMap[i] = NULL;
@@ -84,12 +85,25 @@ void GuiComponent::update(int deltaTime)
 
 }
 
+bool GuiComponent::isAnimating()
+{
+	for (unsigned char i = 0; i < MAX_ANIMATIONS; i++)
+		if (mAnimationMap[i] != nullptr)
+			return true;
+
+	for (auto child : mChildren)
+		if (child->isVisible() && child->isAnimating())
+			return true;
+
+	return false;
+}
+
 void GuiComponent::render(const Transform4x4f& parentTrans)
 {
 	if (!isVisible())
 		return;
 
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 	renderChildren(trans);
 }
 
@@ -287,8 +301,30 @@ void GuiComponent::setOpacity(unsigned char opacity)
 	}
 }
 
+bool GuiComponent::TransformState::operator==(const TransformState& other) const
+{
+	return position == other.position && scale == other.scale && origin == other.origin && rotationOrigin == other.rotationOrigin &&
+		size == other.size && rotationSize == other.rotationSize && rotation == other.rotation;
+}
+
 const Transform4x4f& GuiComponent::getTransform()
 {
+	TransformState state;
+	state.position = mPosition;
+	state.scale = mScale;
+	state.origin = mOrigin;
+	state.rotationOrigin = mRotationOrigin;
+	state.size = mSize;
+	state.rotation = mRotation;
+	state.rotationSize = (mRotation != 0.0 ? getRotationSize() : Vector2f::Zero());
+
+	if (mTransformValid && state == mTransformState)
+		return mTransform;
+
+	mTransformState = state;
+	mTransformValid = true;
+	mTransformVersion++;
+
 	mTransform = Transform4x4f::Identity();
 	mTransform.translate(mPosition);
 	if (mScale != 1.0)
@@ -298,7 +334,7 @@ const Transform4x4f& GuiComponent::getTransform()
 	if (mRotation != 0.0)
 	{
 		// Calculate offset as difference between origin and rotation origin
-		Vector2f rotationSize = getRotationSize();
+		Vector2f rotationSize = state.rotationSize;
 		float xOff = (mOrigin.x() - mRotationOrigin.x()) * rotationSize.x();
 		float yOff = (mOrigin.y() - mRotationOrigin.y()) * rotationSize.y();
 
@@ -317,6 +353,47 @@ const Transform4x4f& GuiComponent::getTransform()
 	return mTransform;
 }
 
+const Transform4x4f& GuiComponent::getWorldTransform(const Transform4x4f& parentTrans)
+{
+	const Transform4x4f& local = getTransform();
+
+	if (mWorldTransformValid && mWorldVersion == mTransformVersion && memcmp(&mWorldParent, &parentTrans, sizeof(Transform4x4f)) == 0)
+		return mWorldTransform;
+
+	mWorldParent = parentTrans;
+	mWorldVersion = mTransformVersion;
+	mWorldTransformValid = true;
+	mWorldTransform = parentTrans * local;
+
+	// bounding box of the transformed corners
+	Vector3f corners[4] = 
+	{
+		mWorldTransform * Vector3f(0, 0, 0),
+		mWorldTransform * Vector3f(mSize.x(), 0, 0),
+		mWorldTransform * Vector3f(0, mSize.y(), 0),
+		mWorldTransform * Vector3f(mSize.x(), mSize.y(), 0)
+	};
+
+	float minX = corners[0].x(), maxX = corners[0].x();
+	float minY = corners[0].y(), maxY = corners[0].y();
+
+	for (int i = 1; i < 4; i++)
+	{
+		minX = Math::min(minX, corners[i].x());
+		maxX = Math::max(maxX, corners[i].x());
+		minY = Math::min(minY, corners[i].y());
+		maxY = Math::max(maxY, corners[i].y());
+	}
+
+	mScreenBounds = Vector4f(minX, minY, maxX - minX, maxY - minY);
+	return mWorldTransform;
+}
+
+bool GuiComponent::isOnScreen() const
+{
+	return Renderer::isVisibleOnScreen(mScreenBounds.x(), mScreenBounds.y(), mScreenBounds.z(), mScreenBounds.w());
+}
+
 void GuiComponent::setValue(const std::string& /*value*/)
 {
 }
@@ -560,7 +637,7 @@ void GuiComponent::animateTo(Vector2f from, Vector2f to, unsigned int  flags, in
 	float y1 = from.y();
 	float y2 = to.y();
 
-	if (Settings::getInstance()->getString("PowerSaverMode") == "instant" || Settings::getInstance()->getString("TransitionStyle") == "instant")
+	if (Settings::getInstance()->getString(SettingKey::PowerSaverMode) == "instant" || Settings::getInstance()->getString(SettingKey::TransitionStyle) == "instant")
 		setPosition(x2, y2);
 	else
 	{
@@ -51,9 +51,14 @@ public:
 	//Called when time passes.  Default implementation calls updateSelf(deltaTime) and updateChildren(deltaTime) - so you should probably call GuiComponent::update(deltaTime) at some point (or at least updateSelf so animations work).
 	virtual void update(int deltaTime);
 
-	//Called when it's time to render.  By default, just calls renderChildren(parentTrans * getTransform()).
+	//Returns true while the component changes on screen without any input (animations, videos, scrolling texts...).
+	//The main loop stops rendering frames while nothing on screen is animating.
+	//Default implementation checks running animations and visible children.
+	virtual bool isAnimating();
+
+	//Called when it's time to render.  By default, just calls renderChildren(getWorldTransform(parentTrans)).
 	//You probably want to override this like so:
-	//1. Calculate the new transform that your control will draw at with Transform4x4f t = parentTrans * getTransform().
+	//1. Calculate the new transform that your control will draw at with Transform4x4f t = getWorldTransform(parentTrans).
 	//2. Set the renderer to use that new transform as the model matrix - Renderer::setMatrix(t);
 	//3. Draw your component.
 	//4. Tell your children to render, based on your component's transform - renderChildren(t).
@@ -131,6 +136,12 @@ public:
 
 	const Transform4x4f& getTransform();
 
+	// parentTrans * getTransform(), only recomputed when one of them changed. Also updates the screen bounds
+	const Transform4x4f& getWorldTransform(const Transform4x4f& parentTrans);
+	// Screen-space bounding box (x, y, w, h) of the component, as of the last getWorldTransform() call
+	inline const Vector4f& getScreenBounds() const { return mScreenBounds; }
+	bool isOnScreen() const; // culling against the screen & clip rect, using the screen bounds
+
 	virtual std::string getValue() const;
 	virtual void setValue(const std::string& value);
 
@@ -242,6 +253,31 @@ private:
 	}
 */
 	Transform4x4f mTransform; //Don't access this directly! Use getTransform()!
+
+	// Values mTransform was built from : members are often changed directly by subclasses, so they are compared instead of using dirty flags
+	struct TransformState
+	{
+		Vector3f position;
+		Vector3f scale;
+		Vector2f origin;
+		Vector2f rotationOrigin;
+		Vector2f size;
+		Vector2f rotationSize;
+		float rotation;
+
+		bool operator==(const TransformState& other) const;
+	};
+
+	TransformState mTransformState;
+	bool mTransformValid;
+	unsigned int mTransformVersion;
+
+	Transform4x4f mWorldTransform;
+	Transform4x4f mWorldParent;
+	unsigned int mWorldVersion;
+	bool mWorldTransformValid;
+	Vector4f mScreenBounds;
+
 	AnimationController* mAnimationMap[MAX_ANIMATIONS];
 /*
 	bool mAutoUpdated = false;
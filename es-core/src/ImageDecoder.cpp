@@ -0,0 +1,225 @@
+#include "ImageDecoder.h"
+
+#include "ImageIO.h"
+#include "Log.h"
+#include "utils/PixelUtil.h"
+#include <FreeImage.h>
+#include <algorithm>
+#include <mutex>
+
+#if defined(HAVE_TURBOJPEG)
+#include <turbojpeg.h>
+#endif
+
+// Fallback for every format FreeImage reads
+class FreeImageDecoder : public ImageDecoder
+{
+public:
+	const char* getName() const override { return "FreeImage"; }
+	int getSpeed() const override { return 0; }
+
+	bool canDecode(const unsigned char* data, size_t size) const override { return data != nullptr && size > 0; }
+
+	unsigned char* decode(const unsigned char* data, size_t size, int maxWidth, int maxHeight, bool externZoom, size_t& width, size_t& height, Vector2i& baseSize) override
+	{
+		unsigned char* pixels = nullptr;
+
+		FIMEMORY* fiMemory = FreeImage_OpenMemory((BYTE*)data, (DWORD)size);
+		if (fiMemory == nullptr)
+			return nullptr;
+
+		//detect the filetype from data
+		FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromMemory(fiMemory);
+		if (format != FIF_UNKNOWN && FreeImage_FIFSupportsReading(format))
+		{
+			//file type is supported. load image
+			FIBITMAP* fiBitmap = FreeImage_LoadFromMemory(format, fiMemory);
+			if (fiBitmap != nullptr)
+			{
+				//loaded. convert to 32bit if necessary
+				if (FreeImage_GetBPP(fiBitmap) != 32)
+				{
+					FIBITMAP* fiConverted = FreeImage_ConvertTo32Bits(fiBitmap);
+					if (fiConverted != nullptr)
+					{
+						//free original bitmap data
+						FreeImage_Unload(fiBitmap);
+						fiBitmap = fiConverted;
+					}
+				}
+
+				width = FreeImage_GetWidth(fiBitmap);
+				height = FreeImage_GetHeight(fiBitmap);
+				baseSize = Vector2i(width, height);
+
+				if (maxWidth > 0 && maxHeight > 0 && (width > (size_t)maxWidth || height > (size_t)maxHeight))
+				{
+					Vector2i sz = ImageIO::adjustPictureSize(Vector2i(width, height), Vector2i(maxWidth, maxHeight), externZoom);
+					if ((size_t)sz.x() != width || (size_t)sz.y() != height)
+					{
+						FIBITMAP* imageRescaled = FreeImage_Rescale(fiBitmap, sz.x(), sz.y(), FILTER_BOX);
+						if (imageRescaled != nullptr)
+						{
+							FreeImage_Unload(fiBitmap);
+							fiBitmap = imageRescaled;
+
+							width = FreeImage_GetWidth(fiBitmap);
+							height = FreeImage_GetHeight(fiBitmap);
+						}
+					}
+				}
+
+				//convert from BGRA to RGBA in a single pass
+				//rows are read with the bitmap pitch, because width*height*bpp might not be == pitch
+				pixels = new unsigned char[width * height * 4];
+				Utils::Pixel::convert(pixels, FreeImage_GetBits(fiBitmap), width, height, FreeImage_GetPitch(fiBitmap), Utils::Pixel::SWAP_RED_BLUE);
+
+				FreeImage_Unload(fiBitmap);
+			}
+			else
+				LOG(LogError) << "ImageDecoder::FreeImage - Error - Failed to load image from memory!";
+		}
+		else
+			LOG(LogError) << "ImageDecoder::FreeImage - Error - File type " << (format == FIF_UNKNOWN ? "unknown" : "unsupported") << "!";
+
+		//free FIMEMORY again
+		FreeImage_CloseMemory(fiMemory);
+		return pixels;
+	}
+};
+
+#if defined(HAVE_TURBOJPEG)
+
+// libjpeg-turbo : SIMD decoding, and scaling in the DCT domain (1/2, 1/4, 1/8...) when the picture is displayed much smaller
+class TurboJpegDecoder : public ImageDecoder
+{
+public:
+	const char* getName() const override { return "libjpeg-turbo"; }
+	int getSpeed() const override { return 100; }
+
+	bool canDecode(const unsigned char* data, size_t size) const override
+	{
+		return size > 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+	}
+
+	unsigned char* decode(const unsigned char* data, size_t size, int maxWidth, int maxHeight, bool externZoom, size_t& width, size_t& height, Vector2i& baseSize) override
+	{
+		tjhandle handle = tjInitDecompress();
+		if (handle == nullptr)
+			return nullptr;
+
+		unsigned char* pixels = nullptr;
+		int jpegWidth, jpegHeight, subsampling, colorspace;
+
+		// CMYK pictures are left to FreeImage
+		if (tjDecompressHeader3(handle, (unsigned char*)data, (unsigned long)size, &jpegWidth, &jpegHeight, &subsampling, &colorspace) == 0 && colorspace != TJCS_CMYK && colorspace != TJCS_YCCK)
+		{
+			int scaledWidth = jpegWidth;
+			int scaledHeight = jpegHeight;
+
+			if (maxWidth > 0 && maxHeight > 0 && (jpegWidth > maxWidth || jpegHeight > maxHeight))
+			{
+				// The smallest scale still at least as big as the displayed size
+				Vector2i target = ImageIO::adjustPictureSize(Vector2i(jpegWidth, jpegHeight), Vector2i(maxWidth, maxHeight), externZoom);
+
+				int count = 0;
+				tjscalingfactor* factors = tjGetScalingFactors(&count);
+
+				for (int i = 0; i < count && factors != nullptr; i++)
+				{
+					if (factors[i].num > factors[i].denom)
+						continue;
+
+					int w = TJSCALED(jpegWidth, factors[i]);
+					int h = TJSCALED(jpegHeight, factors[i]);
+
+					if (w >= target.x() && h >= target.y() && w * h < scaledWidth * scaledHeight)
+					{
+						scaledWidth = w;
+						scaledHeight = h;
+					}
+				}
+			}
+
+			pixels = new unsigned char[scaledWidth * scaledHeight * 4];
+
+			if (tjDecompress2(handle, (unsigned char*)data, (unsigned long)size, pixels, scaledWidth, 0, scaledHeight, TJPF_RGBA, TJFLAG_BOTTOMUP | TJFLAG_FASTDCT) == 0)
+			{
+				width = scaledWidth;
+				height = scaledHeight;
+				baseSize = Vector2i(jpegWidth, jpegHeight);
+			}
+			else
+			{
+				LOG(LogDebug) << "ImageDecoder::libjpeg-turbo - " << tjGetErrorStr();
+
+				delete[] pixels;
+				pixels = nullptr;
+			}
+		}
+
+		tjDestroy(handle);
+		return pixels;
+	}
+};
+
+#endif
+
+static std::mutex sDecodersLock;
+static std::vector<ImageDecoder*> sDecoders;
+static bool sDecodersInitialized = false;
+
+static void initDecoders()
+{
+	if (sDecodersInitialized)
+		return;
+
+	sDecodersInitialized = true;
+	sDecoders.push_back(new FreeImageDecoder());
+
+#if defined(HAVE_TURBOJPEG)
+	sDecoders.push_back(new TurboJpegDecoder());
+#endif
+
+	std::stable_sort(sDecoders.begin(), sDecoders.end(), [](ImageDecoder* a, ImageDecoder* b) { return a->getSpeed() > b->getSpeed(); });
+}
+
+void ImageDecoder::registerDecoder(ImageDecoder* decoder)
+{
+	std::unique_lock<std::mutex> lock(sDecodersLock);
+	initDecoders();
+
+	sDecoders.push_back(decoder);
+	std::stable_sort(sDecoders.begin(), sDecoders.end(), [](ImageDecoder* a, ImageDecoder* b) { return a->getSpeed() > b->getSpeed(); });
+
+	LOG(LogInfo) << "ImageDecoder : registered " << decoder->getName();
+}
+
+std::vector<ImageDecoder*> ImageDecoder::getDecoders()
+{
+	std::unique_lock<std::mutex> lock(sDecodersLock);
+	initDecoders();
+	return sDecoders;
+}
+
+unsigned char* ImageDecoder::decodeImage(const unsigned char* data, size_t size, int maxWidth, int maxHeight, bool externZoom, size_t& width, size_t& height, Vector2i& baseSize)
+{
+	width = 0;
+	height = 0;
+	baseSize = Vector2i(0, 0);
+
+	if (data == nullptr || size == 0)
+		return nullptr;
+
+	for (auto decoder : getDecoders())
+	{
+		if (!decoder->canDecode(data, size))
+			continue;
+
+		unsigned char* pixels = decoder->decode(data, size, maxWidth, maxHeight, externZoom, width, height, baseSize);
+		if (pixels != nullptr)
+			return pixels;
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef ES_CORE_IMAGE_DECODER_H
+#define ES_CORE_IMAGE_DECODER_H
+
+#include <stdlib.h>
+#include <vector>
+
+#include "math/Vector2i.h"
+
+// A picture decoder. Several can be registered : for each picture, the fastest one recognizing the data is used,
+// and the next ones are tried if it fails. FreeImage reads everything and comes last.
+class ImageDecoder
+{
+public:
+	virtual ~ImageDecoder() { }
+
+	virtual const char* getName() const = 0;
+
+	// Ranking, higher is faster
+	virtual int getSpeed() const = 0;
+
+	// Looks at the signature of the data
+	virtual bool canDecode(const unsigned char* data, size_t size) const = 0;
+
+	// Decodes to RGBA pixels (allocated with new[]), rows from bottom to top.
+	// When maxWidth x maxHeight is smaller than the picture, the decoder may return it at any size between the source size
+	// and the size ImageIO::adjustPictureSize gives, so the caller has less to resize. baseSize receives the source size
+	virtual unsigned char* decode(const unsigned char* data, size_t size, int maxWidth, int maxHeight, bool externZoom, size_t& width, size_t& height, Vector2i& baseSize) = 0;
+
+	// Takes ownership of the decoder
+	static void registerDecoder(ImageDecoder* decoder);
+	static std::vector<ImageDecoder*> getDecoders();
+
+	static unsigned char* decodeImage(const unsigned char* data, size_t size, int maxWidth, int maxHeight, bool externZoom, size_t& width, size_t& height, Vector2i& baseSize);
+};
+
+#endif // ES_CORE_IMAGE_DECODER_H
@@ -1,194 +1,57 @@
 #include "ImageIO.h"
 
+#include "ImageDecoder.h"
 #include "Log.h"
-#include <FreeImage.h>
 #include <string.h>
 
 #include <fstream>
 #include <iostream>
 #include "math/Vector2i.h"
 #include "utils/FileSystemUtil.h"
+#include "utils/PixelUtil.h"
 #include "utils/StringUtil.h"
+#include "resources/ImageHeaderCache.h"
 #include "resources/ResourceManager.h"
 
-#include <map>
 #include <mutex>
-
-struct CachedFileInfo
-{
-	CachedFileInfo(int sz, int sx, int sy)
-	{
-		size = sz;
-		x = sx;
-		y = sy;
-	};
-
-	CachedFileInfo()
-	{
-		size = 0;
-		x = 0;
-		y = 0;
-	};
-
-	int size;
-	int x;
-	int y;	
-};
-
-static std::map<std::string, CachedFileInfo> sizeCache;
-static bool sizeCacheDirty = false;
-
-
-#include <sstream>
-#include <fstream>
-
-std::string getImageCacheDir()
-{
-	return Utils::FileSystem::getEsConfigPath();
-}
-
-std::string getImageCacheFilename()
-{
-	return getImageCacheDir() + "/imagecache.db";
-}
-
-void ImageIO::clearImageCache()
-{
-	std::string fname = getImageCacheFilename();
-	Utils::FileSystem::removeFile(fname);
-	sizeCache.clear();
-}
+#include <sys/stat.h>
 
 void ImageIO::clearImageCache()
 {
-	std::string fname = getImageCacheFilename();
-	Utils::FileSystem::removeFile(fname);
-	sizeCache.clear();
+	ImageHeaderCache::getInstance()->clear();
 }
 
 void ImageIO::loadImageCache()
-{	
-	std::string fname = getImageCacheFilename();
-
-	std::ifstream f(fname.c_str());
-	if (f.fail())
-		return;
-
-	std::string relativeTo = getImageCacheDir();
-
-	std::string line;
-	while (std::getline(f, line))
-	{
-		auto splits = Utils::String::split(line, '|');
-		if (splits.size() == 4)
-		{
-			std::string file = splits[0];
-			file = Utils::FileSystem::resolveRelativePath(splits[0], relativeTo, true);
-
-			CachedFileInfo fi;
-			fi.size = atoi(splits[1].c_str());
-			fi.x = atoi(splits[2].c_str());
-			fi.y = atoi(splits[3].c_str());
-
-			sizeCache[file] = fi;
-		}
-	}
-
-	f.close();
+{
+	ImageHeaderCache::getInstance()->load();
 }
 
 void ImageIO::saveImageCache()
 {
-	if (!sizeCacheDirty)
-		return;
-
-	std::string fname = getImageCacheFilename();
-	std::ofstream f(fname.c_str(), std::ios::binary);
-	if (f.fail()) 
-		return;
-
-	std::string relativeTo = getImageCacheDir();
-
-	for (auto it : sizeCache)
-	{
-		if (it.second.size < 0)
-			continue;
-		
-		if (it.first.find("/themes/") != std::string::npos)
-			continue;
-
-		std::string path = Utils::FileSystem::createRelativePath(it.first, "_path_", true);
-		if (path[0] != '~')
-			path = Utils::FileSystem::createRelativePath(it.first, relativeTo, false);
-
-		f << path;
-		f << "|";
-		f << std::to_string(it.second.size);
-		f << "|";
-		f << std::to_string(it.second.x);
-		f << "|";
-		f << std::to_string(it.second.y);
-		f << "\n";
-	}
-
-	f.close();
+	ImageHeaderCache::getInstance()->save();
 }
 
-static std::mutex sizeCacheLock;
-
 void ImageIO::removeImageCache(const std::string fn)
 {
-	std::unique_lock<std::mutex> lock(sizeCacheLock);
-
-	auto it = sizeCache.find(fn);
-	if (it != sizeCache.cend())
-		sizeCache.erase(fn);
+	ImageHeaderCache::getInstance()->remove(fn);
 }
 
 void ImageIO::updateImageCache(const std::string fn, int sz, int x, int y)
 {
-	std::unique_lock<std::mutex> lock(sizeCacheLock);
-
-	auto it = sizeCache.find(fn);
-	if (it != sizeCache.cend())
-	{
-		if (x != it->second.x || y != it->second.y || sz != it->second.size)
-		{
-			auto& item = it->second;
-
-			item.x = x;
-			item.y = y;
-			item.size = sz;			
-
-			if (sz > 0 && x > 0 && fn.find("/themes/") == std::string::npos)
-				sizeCacheDirty = true;
-		}
-	}
-	else
-	{
-		sizeCache[fn] = CachedFileInfo(sz, x, y);
-
-		if (sz > 0 && x > 0 && fn.find("/themes/") == std::string::npos)
-			sizeCacheDirty = true;
-	}
+	ImageHeaderCache::getInstance()->update(fn, ImageHeaderCache::Info(sz, x, y));
 }
 
-
 bool ImageIO::getImageSize(const char *fn, unsigned int *x, unsigned int *y)
 {
+	ImageHeaderCache::Info cached;
+	if (ImageHeaderCache::getInstance()->get(fn, cached))
 	{
-		std::unique_lock<std::mutex> lock(sizeCacheLock);
-
-		auto it = sizeCache.find(fn);
-		if (it != sizeCache.cend())
-		{
-			if (it->second.size < 0)
-				return false;
+		if (cached.size < 0)
+			return false;
 
-			*x = it->second.x;
-			*y = it->second.y;
-			return true;			
-		}
+		*x = cached.width;
+		*y = cached.height;
+		return true;
 	}
 
 	LOG(LogDebug) << "ImageIO::getImageSize " << fn;
@@ -201,9 +64,10 @@ bool ImageIO::getImageSize(const char *fn, unsigned int *x, unsigned int *y)
 	}
 
 	std::unique_lock<std::mutex> lock(ResourceManager::FileSystemLock);
-	auto size = Utils::FileSystem::getFileSize(fn);
 
-	FILE *f = fopen(fn, "rb");
+	// The modification time lets the cache detect the file was replaced
+	struct stat info;
+	FILE *f = stat(fn, &info) == 0 ? fopen(fn, "rb") : nullptr;
 	if (f == 0)
 	{
 		LOG(LogWarning) << "ImageIO::getImageSize\tUnable to open file";
@@ -211,6 +75,8 @@ bool ImageIO::getImageSize(const char *fn, unsigned int *x, unsigned int *y)
 		return false;
 	}
 
+	ImageHeaderCache::Info found((int)info.st_size, 0, 0, (long long)info.st_mtime);
+
 	// Strategy:
 	// reading GIF dimensions requires the first 10 bytes of the file
 	// reading PNG dimensions requires the first 24 bytes of the file
@@ -219,6 +85,7 @@ bool ImageIO::getImageSize(const char *fn, unsigned int *x, unsigned int *y)
 	unsigned char buf[24];
 	if (fread(buf, 1, 24, f) != 24)
 	{
+		fclose(f);
 		updateImageCache(fn, -1, -1, -1);
 		return false;
 	}
@@ -264,7 +131,9 @@ bool ImageIO::getImageSize(const char *fn, unsigned int *x, unsigned int *y)
 			return false;
 		}
 
-		updateImageCache(fn, size, *x, *y);
+		found.width = *x;
+		found.height = *y;
+		ImageHeaderCache::getInstance()->update(fn, found);
 		return true;
 	}
 
@@ -276,7 +145,9 @@ bool ImageIO::getImageSize(const char *fn, unsigned int *x, unsigned int *y)
 
 		LOG(LogDebug) << "ImageIO::getImageSize\tGIF size " << std::string(std::to_string(*x) + "x" + std::to_string(*y)).c_str();
 
-		updateImageCache(fn, size, *x, *y);
+		found.width = *x;
+		found.height = *y;
+		ImageHeaderCache::getInstance()->update(fn, found);
 		return true;
 	}
 
@@ -288,7 +159,9 @@ bool ImageIO::getImageSize(const char *fn, unsigned int *x, unsigned int *y)
 
 		LOG(LogDebug) << "ImageIO::getImageSize\tPNG size " << std::string(std::to_string(*x) + "x" + std::to_string(*y)).c_str();
 
-		updateImageCache(fn, size, *x, *y);
+		found.width = *x;
+		found.height = *y;
+		ImageHeaderCache::getInstance()->update(fn, found);
 		return true;
 	}
 
@@ -300,78 +173,15 @@ bool ImageIO::getImageSize(const char *fn, unsigned int *x, unsigned int *y)
 std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height)
 {
 	std::vector<unsigned char> rawData;
-	width = 0;
-	height = 0;
-	FIMEMORY * fiMemory = FreeImage_OpenMemory((BYTE *)data, (DWORD)size);
-	if (fiMemory != nullptr) 
+
+	Vector2i baseSize;
+	unsigned char* pixels = ImageDecoder::decodeImage(data, size, 0, 0, false, width, height, baseSize);
+	if (pixels != nullptr)
 	{
-		//detect the filetype from data
-		FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromMemory(fiMemory);
-		if (format != FIF_UNKNOWN && FreeImage_FIFSupportsReading(format))
-		{
-			//file type is supported. load image
-			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory);
-			if (fiBitmap != nullptr)
-			{
-				//loaded. convert to 32bit if necessary
-				if (FreeImage_GetBPP(fiBitmap) != 32)
-				{
-					FIBITMAP * fiConverted = FreeImage_ConvertTo32Bits(fiBitmap);
-					if (fiConverted != nullptr)
-					{
-						//free original bitmap data
-						FreeImage_Unload(fiBitmap);
-						fiBitmap = fiConverted;
-					}
-				}
-				if (fiBitmap != nullptr)
-				{					
-					width = FreeImage_GetWidth(fiBitmap);
-					height = FreeImage_GetHeight(fiBitmap);
-
-					//loop through scanlines and add all pixel data to the return vector
-					//this is necessary, because width*height*bpp might not be == pitch
-
-					unsigned char * tempData = new unsigned char[width * height * 4];
-					unsigned char * bytes = FreeImage_GetBits(fiBitmap);
-
-				//	memcpy(tempData, bytes, width * height * 4);
-/*
-					for (size_t i = 0; i < height; i++)
-					{
-						const BYTE * scanLine = FreeImage_GetScanLine(fiBitmap, (int)i);
-						memcpy(tempData + (i * width * 4), scanLine, width * 4);
-					}*/
-					//convert from BGRA to RGBA
-					for(size_t i = 0; i < width*height; i++)
-					{
-						RGBQUAD bgra = ((RGBQUAD *)bytes)[i];
-						RGBQUAD rgba;
-						rgba.rgbBlue = bgra.rgbRed;
-						rgba.rgbGreen = bgra.rgbGreen;
-						rgba.rgbRed = bgra.rgbBlue;
-						rgba.rgbReserved = bgra.rgbReserved;
-						((RGBQUAD *)tempData)[i] = rgba;
-					}
-					
-					rawData = std::vector<unsigned char>(tempData, tempData + width * height * 4);
-					//free bitmap data
-					FreeImage_Unload(fiBitmap);
-					delete[] tempData;
-				}
-			}
-			else
-			{
-				LOG(LogError) << "ImageIO::loadFromMemoryRGBA32 - Error - Failed to load image from memory!";
-			}
-		}
-		else
-		{
-			LOG(LogError) << "ImageIO::loadFromMemoryRGBA32 - Error - File type " << (format == FIF_UNKNOWN ? "unknown" : "unsupported") << "!";
-		}
-		//free FIMEMORY again
-		FreeImage_CloseMemory(fiMemory);
+		rawData.assign(pixels, pixels + width * height * 4);
+		delete[] pixels;
 	}
+
 	return rawData;
 }
 
@@ -427,109 +237,38 @@ Vector2f ImageIO::adjustExternPictureSizef(Vector2f imageSize, Vector2f maxSize)
 
 unsigned char* ImageIO::loadFromMemoryRGBA32Ex(const unsigned char * data, const size_t size, size_t & width, size_t & height, int maxWidth, int maxHeight, bool externZoom, Vector2i& baseSize, Vector2i& packedSize)
 {
-	baseSize = Vector2i(0, 0);
 	packedSize = Vector2i(0, 0);
 
-	width = 0;
-	height = 0;
+	// The decoder may already have scaled the picture down, partly or completely
+	unsigned char* pixels = ImageDecoder::decodeImage(data, size, maxWidth, maxHeight, externZoom, width, height, baseSize);
+	if (pixels == nullptr)
+		return NULL;
 
-	FIMEMORY * fiMemory = FreeImage_OpenMemory((BYTE *)data, (DWORD)size);
-	if (fiMemory != nullptr)
+	if (maxWidth > 0 && maxHeight > 0 && (baseSize.x() > maxWidth || baseSize.y() > maxHeight))
 	{
-		//detect the filetype from data
-		FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromMemory(fiMemory);
-		if (format != FIF_UNKNOWN && FreeImage_FIFSupportsReading(format))
+		Vector2i sz = adjustPictureSize(baseSize, Vector2i(maxWidth, maxHeight), externZoom);
+		if (sz != baseSize)
 		{
-			//file type is supported. load image
-			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory);
-			if (fiBitmap != nullptr)
-			{
-				//loaded. convert to 32bit if necessary
-				if (FreeImage_GetBPP(fiBitmap) != 32)
-				{
-					FIBITMAP * fiConverted = FreeImage_ConvertTo32Bits(fiBitmap);
-					if (fiConverted != nullptr)
-					{
-						//free original bitmap data
-						FreeImage_Unload(fiBitmap);
-						fiBitmap = fiConverted;
-					}
-				}
-
-				if (fiBitmap != nullptr)
-				{
-					width = FreeImage_GetWidth(fiBitmap);
-					height = FreeImage_GetHeight(fiBitmap);
-
-					baseSize = Vector2i(width, height);
-					
-					if (maxWidth > 0 && maxHeight > 0 && (width > maxWidth || height > maxHeight))
-					{
-						Vector2i sz = adjustPictureSize(Vector2i(width, height), Vector2i(maxWidth, maxHeight), externZoom);
-						if (sz.x() != width || sz.y() != height)
-						{							
-							FIBITMAP* imageRescaled = FreeImage_Rescale(fiBitmap, sz.x(), sz.y(), FILTER_BOX);
-							FreeImage_Unload(fiBitmap);
-							fiBitmap = imageRescaled;
-
-							width = FreeImage_GetWidth(fiBitmap);
-							height = FreeImage_GetHeight(fiBitmap);
-							
-							packedSize = Vector2i(width, height);
-						}
-					}
-					
-					//loop through scanlines and add all pixel data to the return vector
-					//this is necessary, because width*height*bpp might not be == pitch
-
-					unsigned char* tempData = new unsigned char[width * height * 4];
-
-					int w = (int)width;
-
-					for (int y = (int)height; --y >= 0; )
-					{
-						unsigned int* argb = (unsigned int*)FreeImage_GetScanLine(fiBitmap, y);
-						unsigned int* abgr = (unsigned int*)(tempData + (y * width * 4));
-						for (int x = w; --x >= 0;)
-						{
-							unsigned int c = argb[x];
-							abgr[x] = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
-						}
-					}
-				
-					FreeImage_Unload(fiBitmap);
-					FreeImage_CloseMemory(fiMemory);
-
-					return tempData;
-				}
-			}
-			else
+			if (sz.x() != width || sz.y() != height)
 			{
-				LOG(LogError) << "ImageIO::loadFromMemoryRGBA32Ex - Error - Failed to load image from memory!";
+				unsigned char* resized = new unsigned char[sz.x() * sz.y() * 4];
+				Utils::Pixel::resize(resized, sz.x(), sz.y(), pixels, width, height);
+
+				delete[] pixels;
+				pixels = resized;
+
+				width = sz.x();
+				height = sz.y();
 			}
+
+			packedSize = Vector2i(width, height);
 		}
-		else
-		{
-			LOG(LogError) << "ImageIO::loadFromMemoryRGBA32Ex - Error - File type " << (format == FIF_UNKNOWN ? "unknown" : "unsupported") << "!";
-		}
-		//free FIMEMORY again
-		FreeImage_CloseMemory(fiMemory);
 	}
 
-	return NULL;
+	return pixels;
 }
 
 void ImageIO::flipPixelsVert(unsigned char* imagePx, const size_t& width, const size_t& height)
 {
-	unsigned int temp;
-	unsigned int* arr = (unsigned int*)imagePx;
-	for(size_t y = 0; y < height / 2; y++)
-	{
-		for(size_t x = 0; x < width; x++)
-		{
-			temp = arr[x + (y * width)];
-			arr[x + (y * width)] = arr[x + (height * width) - ((y + 1) * width)];
-			arr[x + (height * width) - ((y + 1) * width)] = temp;
-		}
-	}
+	Utils::Pixel::flipVertical(imagePx, width, height);
 }
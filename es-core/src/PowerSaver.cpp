@@ -4,6 +4,7 @@
 #include "Settings.h"
 
 bool PowerSaver::mState = false;
+bool PowerSaver::mPaused = false;
 bool PowerSaver::mRunningScreenSaver = false;
 
 int PowerSaver::mWakeupTimeout = -1;
@@ -28,7 +29,7 @@ int PowerSaver::getTimeout()
 void PowerSaver::loadWakeupTime()
 {
 	// TODO : Move this to Screensaver Class
-	std::string behaviour = Settings::getInstance()->getString("ScreenSaverBehavior");
+	std::string behaviour = Settings::getInstance()->getString(SettingKey::ScreenSaverBehavior);
 	if (behaviour == "random video")
 		mWakeupTimeout = Settings::getInstance()->getInt("ScreenSaverSwapVideoTimeout") - getMode();
 	else if (behaviour == "slideshow")
@@ -39,7 +40,7 @@ void PowerSaver::loadWakeupTime()
 
 void PowerSaver::updateTimeouts()
 {
-	mScreenSaverTimeout = (unsigned int) Settings::getInstance()->getInt("ScreenSaverTime");
+	mScreenSaverTimeout = (unsigned int) Settings::getInstance()->getInt(SettingKey::ScreenSaverTime);
 	mScreenSaverTimeout = mScreenSaverTimeout > 0 ? mScreenSaverTimeout - getMode() : -1;
 	loadWakeupTime();
 }
@@ -51,7 +52,7 @@ PowerSaver::mode PowerSaver::getMode()
 
 void PowerSaver::updateMode()
 {
-	std::string mode = Settings::getInstance()->getString("PowerSaverMode");
+	std::string mode = Settings::getInstance()->getString(SettingKey::PowerSaverMode);
 
 	if (mode == "disabled") {
 		mMode = DISABLED;
@@ -73,8 +74,9 @@ bool PowerSaver::getState()
 
 void PowerSaver::setState(bool state)
 {
-	bool ps_enabled = Settings::getInstance()->getString("PowerSaverMode") != "disabled";
+	bool ps_enabled = Settings::getInstance()->getString(SettingKey::PowerSaverMode) != "disabled";
 	mState = ps_enabled && state;
+	mPaused = !state;
 }
 
 void PowerSaver::runningScreenSaver(bool state)
@@ -30,12 +30,17 @@ public:
 	static void pause() { setState(false); }
 	static void resume() { setState(true); }
 
+	// True while a component asked to pause PS, even if PS is disabled.
+	// The main loop doesn't skip idle frames meanwhile
+	static bool isPaused() { return mPaused; }
+
 	// This is used by ScreenSaver to let PS know when to switch to SS timeouts
 	static void runningScreenSaver(bool state);
 	static bool isScreenSaverActive();
 
 private:
 	static bool mState;
+	static bool mPaused;
 	static bool mRunningScreenSaver;
 
 	static mode mMode;
@@ -0,0 +1,422 @@
+#include "Profiler.h"
+
+#include "math/Transform4x4f.h"
+#include "renderers/Renderer.h"
+#include "resources/Font.h"
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+
+#define PROFILER_EVENTS			65536
+#define PROFILER_FRAMES			120
+#define PROFILER_FRAME_SCOPES	8
+#define PROFILER_FLAME_DEPTH	8
+#define PROFILER_LEGEND_LINES	8
+
+std::atomic<bool> Profiler::sEnabled(false);
+
+namespace
+{
+	struct Event
+	{
+		const char*		name;
+		long long		start;		// us
+		int				duration;	// us
+		unsigned short	thread;
+		unsigned short	depth;
+	};
+
+	// Top level scopes of the main thread, for the frame bars
+	struct FrameSample
+	{
+		long long	start;
+		int			duration;
+		int			scopeCount;
+		const char*	scopes[PROFILER_FRAME_SCOPES];
+		int			durations[PROFILER_FRAME_SCOPES];
+	};
+
+	std::mutex			sLock;
+	std::vector<Event>	sEvents; // ring buffer, events are written when their scope ends
+	unsigned long long	sEventCount = 0;
+
+	FrameSample			sFrames[PROFILER_FRAMES];
+	unsigned int		sFrameCount = 0;
+	bool				sFrameOpen = false;
+	long long			sFrameStart = 0;
+	unsigned long long	sFrameFirstEvent = 0;
+
+	// Events of the last complete frame, for the flame graph
+	unsigned long long	sLastFrameFirstEvent = 0;
+	unsigned long long	sLastFrameEndEvent = 0;
+
+	std::atomic<bool>	sDumpRequested(false);
+	unsigned int		sDumpAtFrame = 0;
+	bool				sDisableAfterDump = false;
+
+	std::atomic<int>	sNextThreadId(0);
+	thread_local int	tThreadId = -1;
+	thread_local int	tDepth = 0;
+	int					sMainThreadId = -1;
+
+	std::shared_ptr<Font>		sLegendFont;
+	std::unique_ptr<TextCache>	sLegend;
+	unsigned int				sLegendFrame = 0;
+}
+
+static long long getMicroseconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int getThreadId()
+{
+	if (tThreadId < 0)
+		tThreadId = sNextThreadId++;
+
+	return tThreadId;
+}
+
+static unsigned int getScopeColor(const char* name)
+{
+	static const unsigned int palette[] = { 0x4E79A7FF, 0xF28E2BFF, 0xE15759FF, 0x76B7B2FF, 0x59A14FFF, 0xEDC948FF, 0xB07AA1FF, 0xFF9DA7FF };
+
+	unsigned int hash = 5381;
+	for (const char* c = name; *c != 0; c++)
+		hash = hash * 33 + (unsigned char)*c;
+
+	return palette[hash % (sizeof(palette) / sizeof(palette[0]))];
+}
+
+void Profiler::Scope::begin(const char* name)
+{
+	mName = name;
+	mDepth = tDepth++;
+	mStart = getMicroseconds();
+}
+
+void Profiler::Scope::end()
+{
+	long long now = getMicroseconds();
+	tDepth--;
+
+	Event event;
+	event.name = mName;
+	event.start = mStart;
+	event.duration = (int)(now - mStart);
+	event.thread = (unsigned short)getThreadId();
+	event.depth = (unsigned short)mDepth;
+
+	std::unique_lock<std::mutex> lock(sLock);
+	if (sEvents.empty())
+		return;
+
+	sEvents[sEventCount % PROFILER_EVENTS] = event;
+	sEventCount++;
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	std::unique_lock<std::mutex> lock(sLock);
+
+	if (enabled && sEvents.empty())
+		sEvents.resize(PROFILER_EVENTS);
+
+	if (!enabled)
+	{
+		sFrameOpen = false;
+		sLegend.reset();
+		sLegendFont.reset();
+	}
+
+	sEnabled = enabled;
+	LOG(LogInfo) << "Profiler " << (enabled ? "started" : "stopped");
+}
+
+void Profiler::beginFrame()
+{
+	if (sMainThreadId < 0)
+		sMainThreadId = getThreadId();
+
+	if (!isEnabled())
+		return;
+
+	std::unique_lock<std::mutex> lock(sLock);
+	sFrameOpen = true;
+	sFrameStart = getMicroseconds();
+	sFrameFirstEvent = sEventCount;
+}
+
+static void dumpToConfigPath()
+{
+	std::string path = Utils::FileSystem::getEsConfigPath() + "/profiler.json";
+	if (Profiler::dump(path))
+		LOG(LogInfo) << "Profiler : trace written to " << path;
+	else
+		LOG(LogError) << "Profiler : unable to write " << path;
+}
+
+void Profiler::endFrame()
+{
+	if (sDumpRequested.exchange(false))
+	{
+		if (isEnabled())
+			dumpToConfigPath();
+		else
+		{
+			// capture a full buffer of frames first
+			setEnabled(true);
+			sDisableAfterDump = true;
+			sDumpAtFrame = sFrameCount + PROFILER_FRAMES;
+		}
+	}
+
+	if (!isEnabled())
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(sLock);
+		if (!sFrameOpen)
+			return;
+
+		sFrameOpen = false;
+
+		FrameSample& frame = sFrames[sFrameCount % PROFILER_FRAMES];
+		frame.start = sFrameStart;
+		frame.duration = (int)(getMicroseconds() - sFrameStart);
+		frame.scopeCount = 0;
+
+		unsigned long long first = std::max(sFrameFirstEvent, sEventCount > PROFILER_EVENTS ? sEventCount - PROFILER_EVENTS : 0);
+		for (unsigned long long i = first; i < sEventCount; i++)
+		{
+			const Event& event = sEvents[i % PROFILER_EVENTS];
+			if (event.thread != sMainThreadId || event.depth != 0)
+				continue;
+
+			int index = 0;
+			while (index < frame.scopeCount && frame.scopes[index] != event.name)
+				index++;
+
+			if (index == frame.scopeCount)
+			{
+				if (frame.scopeCount == PROFILER_FRAME_SCOPES)
+					continue;
+
+				frame.scopes[index] = event.name;
+				frame.durations[index] = 0;
+				frame.scopeCount++;
+			}
+
+			frame.durations[index] += event.duration;
+		}
+
+		sLastFrameFirstEvent = first;
+		sLastFrameEndEvent = sEventCount;
+		sFrameCount++;
+	}
+
+	if (sDumpAtFrame != 0 && sFrameCount >= sDumpAtFrame)
+	{
+		sDumpAtFrame = 0;
+		dumpToConfigPath();
+
+		if (sDisableAfterDump)
+			setEnabled(false);
+
+		sDisableAfterDump = false;
+	}
+}
+
+void Profiler::requestDump()
+{
+	sDumpRequested = true;
+}
+
+bool Profiler::dump(const std::string& path)
+{
+	std::vector<Event> events;
+	std::vector<FrameSample> frames;
+
+	{
+		std::unique_lock<std::mutex> lock(sLock);
+
+		unsigned long long first = sEventCount > PROFILER_EVENTS ? sEventCount - PROFILER_EVENTS : 0;
+		for (unsigned long long i = first; i < sEventCount; i++)
+			events.push_back(sEvents[i % PROFILER_EVENTS]);
+
+		unsigned int frameCount = std::min(sFrameCount, (unsigned int)PROFILER_FRAMES);
+		for (unsigned int i = sFrameCount - frameCount; i < sFrameCount; i++)
+			frames.push_back(sFrames[i % PROFILER_FRAMES]);
+	}
+
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	const int framesThread = 1000;
+
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << framesThread << ",\"args\":{\"name\":\"frames\"}}";
+
+	int threadCount = sNextThreadId;
+	for (int i = 0; i < threadCount; i++)
+		file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":\"" << (i == sMainThreadId ? std::string("main") : "thread " + std::to_string(i)) << "\"}}";
+
+	for (auto& frame : frames)
+		file << ",\n{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":" << framesThread << ",\"ts\":" << frame.start << ",\"dur\":" << frame.duration << "}";
+
+	for (auto& event : events)
+		file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+
+	file << "\n]}\n";
+	return !file.fail();
+}
+
+std::map<std::string, long long> Profiler::getTotals()
+{
+	std::map<std::string, long long> totals;
+
+	std::unique_lock<std::mutex> lock(sLock);
+
+	unsigned long long first = sEventCount > PROFILER_EVENTS ? sEventCount - PROFILER_EVENTS : 0;
+	for (unsigned long long i = first; i < sEventCount; i++)
+		totals[sEvents[i % PROFILER_EVENTS].name] += sEvents[i % PROFILER_EVENTS].duration;
+
+	return totals;
+}
+
+void Profiler::clear()
+{
+	std::unique_lock<std::mutex> lock(sLock);
+	sEventCount = 0;
+	sFrameCount = 0;
+	sFrameOpen = false;
+	sLastFrameFirstEvent = 0;
+	sLastFrameEndEvent = 0;
+}
+
+void Profiler::render()
+{
+	if (!isEnabled())
+		return;
+
+	// Copy what's needed : drawing the legend records events
+	std::vector<FrameSample> frames;
+	std::vector<Event> lastFrameEvents;
+	FrameSample lastFrame;
+	unsigned int frameCount;
+
+	{
+		std::unique_lock<std::mutex> lock(sLock);
+
+		frameCount = sFrameCount;
+		if (frameCount == 0)
+			return;
+
+		unsigned int count = std::min(sFrameCount, (unsigned int)PROFILER_FRAMES);
+		for (unsigned int i = sFrameCount - count; i < sFrameCount; i++)
+			frames.push_back(sFrames[i % PROFILER_FRAMES]);
+
+		lastFrame = frames.back();
+
+		unsigned long long first = std::max(sLastFrameFirstEvent, sEventCount > PROFILER_EVENTS ? sEventCount - PROFILER_EVENTS : 0);
+		for (unsigned long long i = first; i < sLastFrameEndEvent; i++)
+			if (sEvents[i % PROFILER_EVENTS].thread == sMainThreadId)
+				lastFrameEvents.push_back(sEvents[i % PROFILER_EVENTS]);
+	}
+
+	Renderer::setMatrix(Transform4x4f::Identity());
+
+	const float width = (float)Renderer::getScreenWidth();
+	const float height = (float)Renderer::getScreenHeight();
+
+	// Frame bars, full height is 2 frames at 60 fps
+	const float graphHeight = height * 0.2f;
+	const float graphTop = height - graphHeight;
+	const float msScale = graphHeight / 33.3f;
+	const float barWidth = width / PROFILER_FRAMES;
+
+	Renderer::drawRect(0.0f, graphTop, width, graphHeight, 0x000000A0);
+
+	for (unsigned int i = 0; i < frames.size(); i++)
+	{
+		const FrameSample& frame = frames[i];
+
+		float x = i * barWidth;
+		float y = height;
+		int tracked = 0;
+
+		for (int s = 0; s < frame.scopeCount; s++)
+		{
+			float h = Math::min(frame.durations[s] / 1000.0f * msScale, y - graphTop);
+			y -= h;
+			Renderer::drawRect(x, y, Math::max(1.0f, barWidth - 1.0f), h, getScopeColor(frame.scopes[s]));
+			tracked += frame.durations[s];
+		}
+
+		// time spent outside of the top level scopes
+		if (frame.duration > tracked)
+		{
+			float h = Math::min((frame.duration - tracked) / 1000.0f * msScale, y - graphTop);
+			Renderer::drawRect(x, y - h, Math::max(1.0f, barWidth - 1.0f), h, 0x808080FF);
+		}
+	}
+
+	// 16.6 ms budget
+	Renderer::drawRect(0.0f, height - 16.67f * msScale, width, 1.0f, 0xFF0000FF);
+
+	// Flame graph of the last frame
+	const float rowHeight = Math::max(4.0f, height * 0.015f);
+	const float flameTop = graphTop - rowHeight * PROFILER_FLAME_DEPTH;
+
+	Renderer::drawRect(0.0f, flameTop, width, rowHeight * PROFILER_FLAME_DEPTH, 0x00000080);
+
+	if (lastFrame.duration > 0)
+	{
+		for (auto& event : lastFrameEvents)
+		{
+			if (event.depth >= PROFILER_FLAME_DEPTH)
+				continue;
+
+			float x = Math::max(0.0f, (event.start - lastFrame.start) * width / lastFrame.duration);
+			float w = Math::max(1.0f, event.duration * width / lastFrame.duration);
+			Renderer::drawRect(x, flameTop + event.depth * rowHeight, w, rowHeight - 1.0f, getScopeColor(event.name));
+		}
+	}
+
+	// Legend : most expensive scopes of the last frame, rebuilt every half second
+	if (sLegend == nullptr || frameCount - sLegendFrame >= 30)
+	{
+		std::vector<std::pair<const char*, int>> totals;
+		for (auto& event : lastFrameEvents)
+		{
+			auto it = std::find_if(totals.begin(), totals.end(), [&event](const std::pair<const char*, int>& t) { return t.first == event.name; });
+			if (it == totals.end())
+				totals.push_back(std::pair<const char*, int>(event.name, event.duration));
+			else
+				it->second += event.duration;
+		}
+
+		std::sort(totals.begin(), totals.end(), [](const std::pair<const char*, int>& a, const std::pair<const char*, int>& b) { return a.second > b.second; });
+
+		std::stringstream ss;
+		ss << std::fixed << std::setprecision(2) << "Frame " << lastFrame.duration / 1000.0f << " ms";
+		for (unsigned int i = 0; i < totals.size() && i < PROFILER_LEGEND_LINES; i++)
+			ss << "\n" << totals[i].first << " " << totals[i].second / 1000.0f << " ms";
+
+		if (sLegendFont == nullptr)
+			sLegendFont = Font::get(FONT_SIZE_MINI);
+
+		sLegend = std::unique_ptr<TextCache>(sLegendFont->buildTextCache(ss.str(), width * 0.01f, flameTop - sLegendFont->getHeight() * (Math::min((int)totals.size(), PROFILER_LEGEND_LINES) + 1), 0xFFFFFFFF));
+		sLegendFrame = frameCount;
+	}
+
+	Renderer::setMatrix(Transform4x4f::Identity());
+	sLegendFont->renderTextCache(sLegend.get());
+}
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef ES_CORE_PROFILER_H
+#define ES_CORE_PROFILER_H
+
+#include <atomic>
+#include <map>
+#include <string>
+
+// Frame profiler. Scopes are timed on any thread into a ring buffer, and grouped by frame for the main thread.
+// Ctrl-P toggles it with its overlay : one bar per frame split by top level scope, and a flame graph of the last frame.
+// Ctrl-O or SIGUSR2 writes the buffer as a Chrome trace (chrome://tracing, Perfetto) to [ES config path]/profiler.json.
+// If the profiler isn't running, the trace is written after capturing PROFILER_FRAMES frames.
+// When disabled, a scope costs an atomic load.
+class Profiler
+{
+public:
+	class Scope
+	{
+	public:
+		Scope(const char* name) : mName(nullptr) { if (Profiler::isEnabled()) begin(name); }
+		~Scope() { if (mName != nullptr) end(); }
+
+	private:
+		void begin(const char* name);
+		void end();
+
+		const char* mName; // must be a literal
+		long long mStart;
+		int mDepth;
+	};
+
+	static inline bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+	static void setEnabled(bool enabled);
+
+	// Called by the main loop
+	static void beginFrame();
+	static void endFrame();
+
+	// Async-signal-safe
+	static void requestDump();
+	static bool dump(const std::string& path);
+
+	// Time spent in each scope (us, summed over threads) among the buffered events. clear() empties the buffer
+	static std::map<std::string, long long> getTotals();
+	static void clear();
+
+	static void render();
+
+private:
+	static std::atomic<bool> sEnabled;
+};
+
+#define PROFILE_SCOPE_CONCAT_(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_SCOPE_CONCAT(profilerScope, __LINE__)(name)
+
+#endif // ES_CORE_PROFILER_H
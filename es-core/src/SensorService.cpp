@@ -0,0 +1,190 @@
+#include "SensorService.h"
+
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "platform.h"
+#include "Settings.h"
+
+#include <algorithm>
+#if !defined(USE_NULL_RENDERER)
+#include <go2/audio.h>
+#include <go2/display.h>
+#endif
+
+// Packed layout : 7 bits battery level | 7 bits volume | 7 bits brightness | flags
+#define PACK_BATTERY_SHIFT		0
+#define PACK_VOLUME_SHIFT		7
+#define PACK_BRIGHTNESS_SHIFT	14
+#define PACK_LEVEL_MASK			0x7F
+
+#define PACK_HAS_BATTERY		(1u << 21)
+#define PACK_CHARGING			(1u << 22)
+#define PACK_AC_ONLINE			(1u << 23)
+#define PACK_WIFI				(1u << 24)
+
+static int clampLevel(int value)
+{
+	return std::max(0, std::min(100, value));
+}
+
+static std::string readSysFile(const std::string& path)
+{
+	if (!Utils::FileSystem::exists(path))
+		return "";
+
+	return Utils::FileSystem::readAllText(path);
+}
+
+SensorService* SensorService::getInstance()
+{
+	// Never destroyed : a joinable std::thread must not be destructed at exit if stop() wasn't called
+	static SensorService* sInstance = new SensorService();
+	return sInstance;
+}
+
+SensorService::SensorService() : mPacked(0), mRunning(false)
+{
+}
+
+void SensorService::start()
+{
+	if (mRunning)
+		return;
+
+	// Take a first sample synchronously, so the first frames don't show empty values
+	SensorSnapshot snapshot;
+	sampleBattery(snapshot);
+	sampleNetwork(snapshot);
+	sampleAudio(snapshot);
+	publish(snapshot);
+
+	mRunning = true;
+	mThread = std::thread(&SensorService::threadProc, this);
+}
+
+void SensorService::stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		if (!mRunning)
+			return;
+
+		mRunning = false;
+	}
+
+	mEvent.notify_all();
+
+	if (mThread.joinable())
+		mThread.join();
+}
+
+SensorSnapshot SensorService::getSnapshot() const
+{
+	unsigned int packed = mPacked.load(std::memory_order_acquire);
+
+	SensorSnapshot snapshot;
+	snapshot.batteryLevel = (packed >> PACK_BATTERY_SHIFT) & PACK_LEVEL_MASK;
+	snapshot.volume = (packed >> PACK_VOLUME_SHIFT) & PACK_LEVEL_MASK;
+	snapshot.brightness = (packed >> PACK_BRIGHTNESS_SHIFT) & PACK_LEVEL_MASK;
+	snapshot.hasBattery = (packed & PACK_HAS_BATTERY) != 0;
+	snapshot.isCharging = (packed & PACK_CHARGING) != 0;
+	snapshot.acOnline = (packed & PACK_AC_ONLINE) != 0;
+	snapshot.wifiConnected = (packed & PACK_WIFI) != 0;
+	return snapshot;
+}
+
+void SensorService::publish(const SensorSnapshot& snapshot)
+{
+	unsigned int packed =
+		((unsigned int)clampLevel(snapshot.batteryLevel) << PACK_BATTERY_SHIFT) |
+		((unsigned int)clampLevel(snapshot.volume) << PACK_VOLUME_SHIFT) |
+		((unsigned int)clampLevel(snapshot.brightness) << PACK_BRIGHTNESS_SHIFT) |
+		(snapshot.hasBattery ? PACK_HAS_BATTERY : 0) |
+		(snapshot.isCharging ? PACK_CHARGING : 0) |
+		(snapshot.acOnline ? PACK_AC_ONLINE : 0) |
+		(snapshot.wifiConnected ? PACK_WIFI : 0);
+
+	mPacked.store(packed, std::memory_order_release);
+}
+
+void SensorService::sampleBattery(SensorSnapshot& snapshot)
+{
+	snapshot.hasBattery = !queryBatteryRootPath().empty();
+	snapshot.batteryLevel = snapshot.hasBattery ? queryBatteryLevel() : 0;
+	snapshot.isCharging = snapshot.hasBattery && queryBatteryCharging();
+	snapshot.acOnline = readSysFile("/sys/class/power_supply/ac/online").find("1") != std::string::npos;
+}
+
+void SensorService::sampleNetwork(SensorSnapshot& snapshot)
+{
+	snapshot.wifiConnected = readSysFile("/sys/class/net/wlan0/operstate").find("up") != std::string::npos;
+}
+
+void SensorService::sampleAudio(SensorSnapshot& snapshot)
+{
+#if defined(USE_NULL_RENDERER)
+	// headless builds have no go2 device
+	snapshot.volume = 50;
+	snapshot.brightness = 50;
+#else
+	snapshot.volume = (int)go2_audio_volume_get(NULL);
+
+	try
+	{
+		snapshot.brightness = (int)go2_display_backlight_get(NULL);
+	}
+	catch (...)
+	{
+		snapshot.brightness = 50;
+	}
+#endif
+}
+
+void SensorService::threadProc()
+{
+	int batteryInterval = std::max(100, Settings::getInstance()->getInt("SensorBatteryInterval"));
+	int networkInterval = std::max(100, Settings::getInstance()->getInt("SensorNetworkInterval"));
+	int audioInterval = std::max(50, Settings::getInstance()->getInt("SensorAudioInterval"));
+
+	auto now = std::chrono::steady_clock::now();
+	auto nextBattery = now + std::chrono::milliseconds(batteryInterval);
+	auto nextNetwork = now + std::chrono::milliseconds(networkInterval);
+	auto nextAudio = now + std::chrono::milliseconds(audioInterval);
+
+	SensorSnapshot snapshot = getSnapshot();
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	while (mRunning)
+	{
+		auto wakeUp = std::min(nextBattery, std::min(nextNetwork, nextAudio));
+		if (mEvent.wait_until(lock, wakeUp, [this] { return !mRunning; }))
+			break;
+
+		lock.unlock();
+
+		now = std::chrono::steady_clock::now();
+
+		if (now >= nextBattery)
+		{
+			sampleBattery(snapshot);
+			nextBattery = now + std::chrono::milliseconds(batteryInterval);
+		}
+
+		if (now >= nextNetwork)
+		{
+			sampleNetwork(snapshot);
+			nextNetwork = now + std::chrono::milliseconds(networkInterval);
+		}
+
+		if (now >= nextAudio)
+		{
+			sampleAudio(snapshot);
+			nextAudio = now + std::chrono::milliseconds(audioInterval);
+		}
+
+		publish(snapshot);
+
+		lock.lock();
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef ES_CORE_SENSOR_SERVICE_H
+#define ES_CORE_SENSOR_SERVICE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct SensorSnapshot
+{
+	SensorSnapshot() : hasBattery(false), batteryLevel(0), isCharging(false), acOnline(false), wifiConnected(false), volume(0), brightness(0) { }
+
+	bool hasBattery;
+	int  batteryLevel;  // 0-100
+	bool isCharging;
+	bool acOnline;
+	bool wifiConnected;
+	int  volume;        // 0-100
+	int  brightness;    // 0-100
+};
+
+// Samples battery, power, wifi, volume & brightness on a background thread, so the renderer & components never hit sysfs themselves.
+// Intervals come from the SensorBatteryInterval, SensorNetworkInterval & SensorAudioInterval settings (milliseconds).
+// The last values are packed in a single atomic word : reading them is lock-free and never blocks the frame.
+class SensorService
+{
+public:
+	static SensorService* getInstance();
+
+	void start();
+	void stop();
+	bool isRunning() const { return mRunning; }
+
+	SensorSnapshot getSnapshot() const;
+
+private:
+	SensorService();
+
+	void threadProc();
+	void sampleBattery(SensorSnapshot& snapshot);
+	void sampleNetwork(SensorSnapshot& snapshot);
+	void sampleAudio(SensorSnapshot& snapshot);
+	void publish(const SensorSnapshot& snapshot);
+
+	std::atomic<unsigned int> mPacked;
+
+	std::thread             mThread;
+	std::mutex              mLock;
+	std::condition_variable mEvent;
+	std::atomic<bool>       mRunning;
+};
+
+#endif // ES_CORE_SENSOR_SERVICE_H
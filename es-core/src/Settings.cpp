@@ -32,9 +32,21 @@ std::vector<const char*> settings_dont_save {
 	{ "ThemeRandomSet" }
 };
 
+static const char* internedKeyNames[SettingKey::COUNT] =
+{
+#define SETTINGS_KEY_NAME(name) #name,
+	SETTINGS_INTERNED_KEYS(SETTINGS_KEY_NAME)
+#undef SETTINGS_KEY_NAME
+};
+
 Settings::Settings()
 {
 	mHasConfigRoot = false;
+	mNextListenerId = 0;
+
+	for (int i = 0; i < SettingKey::COUNT; i++)
+		mInternedIds[internedKeyNames[i]] = i;
+
 	setDefaults();
 	loadFile();
 }
@@ -59,6 +71,9 @@ void Settings::setDefaults()
 	mBoolMap["InvertButtonsPU"] = false;
 	mBoolMap["InvertButtonsPD"] = false;
 	mBoolMap["ParseGamelistOnly"] = false;
+	mBoolMap["UseGamelistCache"] = true;
+	mBoolMap["IncrementalRomScan"] = true;
+	mBoolMap["PersistentFileCache"] = true;
 	mBoolMap["ShowHiddenFiles"] = false;
 	mBoolMap["DrawFramerate"] = false;
 	mBoolMap["ShowExit"] = true;
@@ -82,6 +97,9 @@ void Settings::setDefaults()
 	//mBoolMap["ShowControllerActivity"] = false;
 	mBoolMap["ShowBatteryIndicator"] = false;
 	mBoolMap["ShowNetworkIndicator"] = false;
+	mIntMap["SensorBatteryInterval"] = 5000; // milliseconds
+	mIntMap["SensorNetworkInterval"] = 5000;
+	mIntMap["SensorAudioInterval"] = 250;
 
 	mBoolMap["VSync"] = true;
 	mBoolMap["DrawClock"] = true;
@@ -96,6 +114,8 @@ void Settings::setDefaults()
 	mStringMap["ShowBattery"] = "text";
 	mBoolMap["OptimizeVRAM"] = true;	
 	mBoolMap["ThreadedLoading"] = true;
+	mIntMap["ThreadPoolSize"] = 0; // 0 = one worker per core
+	mIntMap["ThreadPoolAffinity"] = 0; // cpu mask, 0 = no pinning
 	mBoolMap["MusicTitles"] = true;
 	mBoolMap["AutoMenuWidth"] = false;
 
@@ -108,7 +128,15 @@ void Settings::setDefaults()
 	mIntMap["ScraperResizeWidth"] = 400;
 	mIntMap["ScraperResizeHeight"] = 0;
 
+	mIntMap["WindowWidth"] = 0; // headless renderer size, 0 = 640x480
+	mIntMap["WindowHeight"] = 0;
 	mIntMap["MaxVRAM"] = 100;
+	mIntMap["MaxVRAMTheme"] = 0; // per class budgets in MB, 0 = only MaxVRAM applies
+	mIntMap["MaxVRAMGameArt"] = 0;
+	mIntMap["MaxVRAMFont"] = 0;
+	mIntMap["MaxVRAMVideo"] = 0;
+	mIntMap["ThumbnailCacheSize"] = 128; // MB, 0 = disabled
+	mStringMap["TextureCompression"] = "none"; // none, 16bit, etc1 : GPU format of game art
 
 	mBoolMap["HideWindow"] = true;
 
@@ -133,6 +161,7 @@ void Settings::setDefaults()
 	mStringMap["ScreenSaverGameInfo"] = "never";
 	mBoolMap["StretchVideoOnScreenSaver"] = false;
 	mStringMap["PowerSaverMode"] = "disabled";
+	mBoolMap["SkipIdleFrames"] = true;
 
 	mIntMap["ScreenSaverSwapImageTimeout"] = 10000;
 	mBoolMap["SlideshowScreenSaverStretch"] = false;
@@ -202,6 +231,76 @@ void Settings::setDefaults()
 	mDefaultIntMap = mIntMap;
 	mDefaultFloatMap = mFloatMap;
 	mDefaultStringMap = mStringMap;
+
+	syncInterned();
+}
+
+void Settings::syncInterned()
+{
+	for (int i = 0; i < SettingKey::COUNT; i++)
+		mInterned[i] = InternedValue();
+
+	for (auto it : mBoolMap) updateInterned(it.first, it.second);
+	for (auto it : mIntMap) updateInterned(it.first, it.second);
+	for (auto it : mFloatMap) updateInterned(it.first, it.second);
+	for (auto it : mStringMap) updateInterned(it.first, it.second);
+}
+
+void Settings::updateInterned(const std::string& name, bool value)
+{
+	auto it = mInternedIds.find(name);
+	if (it != mInternedIds.cend())
+		mInterned[it->second].boolValue = value;
+}
+
+void Settings::updateInterned(const std::string& name, int value)
+{
+	auto it = mInternedIds.find(name);
+	if (it != mInternedIds.cend())
+		mInterned[it->second].intValue = value;
+}
+
+void Settings::updateInterned(const std::string& name, float value)
+{
+	auto it = mInternedIds.find(name);
+	if (it != mInternedIds.cend())
+		mInterned[it->second].floatValue = value;
+}
+
+void Settings::updateInterned(const std::string& name, const std::string& value)
+{
+	auto it = mInternedIds.find(name);
+	if (it != mInternedIds.cend())
+		mInterned[it->second].stringValue = value;
+}
+
+int Settings::addChangeListener(const std::string& name, const ChangeCallback& callback)
+{
+	int id = ++mNextListenerId;
+
+	ChangeListener listener;
+	listener.name = name;
+	listener.callback = callback;
+	mChangeListeners[id] = listener;
+
+	return id;
+}
+
+void Settings::removeChangeListener(int listenerId)
+{
+	mChangeListeners.erase(listenerId);
+}
+
+void Settings::notifyChanged(const std::string& name)
+{
+	if (mChangeListeners.size() == 0)
+		return;
+
+	// Copy : a callback may add or remove listeners
+	auto listeners = mChangeListeners;
+	for (auto& listener : listeners)
+		if (listener.second.name.empty() || listener.second.name == name)
+			listener.second.callback(name);
 }
 
 template <typename K, typename V>
@@ -327,10 +426,12 @@ bool Settings::setMethodName(const std::string& name, type value) \
 { \
 	if (mapName.count(name) == 0 || mapName[name] != value) { \
 		mapName[name] = value; \
+		updateInterned(name, mapName[name]); \
 \
 		if (std::find(settings_dont_save.cbegin(), settings_dont_save.cend(), name) == settings_dont_save.cend()) \
 			mWasChanged = true; \
 \
+		notifyChanged(name); \
 		return true; \
 	} \
 	return false; \
@@ -2,7 +2,50 @@
 #ifndef ES_CORE_SETTINGS_H
 #define ES_CORE_SETTINGS_H
 
+#include <functional>
 #include <map>
+#include <string>
+
+// Settings read on hot paths (every frame, every gamelist refresh) are interned once as an enum id.
+// Their value is mirrored in a flat array, so reading them neither builds a std::string nor walks a map.
+// Any other key, including dynamic ones like "<system>.sort", stays available through the string API.
+#define SETTINGS_INTERNED_KEYS(X) \
+	X(Debug) \
+	X(DebugText) \
+	X(DebugImage) \
+	X(DrawFramerate) \
+	X(DrawClock) \
+	X(ClockMode12) \
+	X(ShowBatteryIndicator) \
+	X(ShowNetworkIndicator) \
+	X(VolumePopup) \
+	X(BrightnessPopup) \
+	X(ScreenSaverTime) \
+	X(ScreenSaverControls) \
+	X(ScreenSaverBehavior) \
+	X(ShowHelpPrompts) \
+	X(UIMode) \
+	X(ForceKid) \
+	X(ForceKiosk) \
+	X(FolderViewMode) \
+	X(ShowHiddenFiles) \
+	X(ForceDisableFilters) \
+	X(LocalArt) \
+	X(PowerSaverMode) \
+	X(TransitionStyle) \
+	X(ScreenRotate) \
+	X(SkipIdleFrames)
+
+namespace SettingKey
+{
+	enum Id
+	{
+#define SETTINGS_KEY_ENUM(name) name,
+		SETTINGS_INTERNED_KEYS(SETTINGS_KEY_ENUM)
+#undef SETTINGS_KEY_ENUM
+		COUNT
+	};
+}
 
 //This is a singleton for storing settings.
 class Settings
@@ -24,6 +67,17 @@ public:
 	bool setFloat(const std::string& name, float value);
 	bool setString(const std::string& name, const std::string& value);
 
+	// Interned keys : O(1), no map lookup. Strings are returned by copy, setString may replace them meanwhile
+	inline bool getBool(SettingKey::Id id) const { return mInterned[id].boolValue; }
+	inline int getInt(SettingKey::Id id) const { return mInterned[id].intValue; }
+	inline float getFloat(SettingKey::Id id) const { return mInterned[id].floatValue; }
+	inline std::string getString(SettingKey::Id id) const { return mInterned[id].stringValue; }
+
+	// Called with the setting name after its value changed. An empty name listens to every setting
+	typedef std::function<void(const std::string& name)> ChangeCallback;
+	int addChangeListener(const std::string& name, const ChangeCallback& callback);
+	void removeChangeListener(int listenerId);
+
 	std::map<std::string, std::string>& getStringMap() { return mStringMap; }
 
 private:
@@ -34,6 +88,35 @@ private:
 	//Clear everything and load default values.
 	void setDefaults();
 
+	struct InternedValue
+	{
+		InternedValue() : boolValue(false), intValue(0), floatValue(0.0f) { }
+
+		bool        boolValue;
+		int         intValue;
+		float       floatValue;
+		std::string stringValue;
+	};
+
+	void updateInterned(const std::string& name, bool value);
+	void updateInterned(const std::string& name, int value);
+	void updateInterned(const std::string& name, float value);
+	void updateInterned(const std::string& name, const std::string& value);
+	void syncInterned();
+	void notifyChanged(const std::string& name);
+
+	InternedValue mInterned[SettingKey::COUNT];
+	std::map<std::string, int> mInternedIds;
+
+	struct ChangeListener
+	{
+		std::string    name;
+		ChangeCallback callback;
+	};
+
+	std::map<int, ChangeListener> mChangeListeners;
+	int mNextListenerId;
+
 	std::map<std::string, bool> mBoolMap;
 	std::map<std::string, int> mIntMap;
 	std::map<std::string, float> mFloatMap;
@@ -21,10 +21,13 @@
 #include "utils/TimeUtil.h"
 #include "components/VolumeInfoComponent.h"
 #include "components/BrightnessInfoComponent.h"
+#include "PowerSaver.h"
+#include "Profiler.h"
 
 
 Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10),
-  mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL), mClockElapsed(0) // batocera
+  mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL), mClockElapsed(0), // batocera
+  mNeedsRedraw(true), mWasAnimating(false), mLastRenderTime(0), mSkippedFrames(0), mSkippedFramesElapsed(0)
 {	
 	mHelp = new HelpComponent(this);
 	mBackgroundOverlay = new ImageComponent(this);	
@@ -46,8 +49,24 @@ Window::~Window()
 	delete mHelp;
 }
 
+static std::mutex mNotificationMessagesLock;
+
+// Wakes up the main loop when it waits for events during idle frames
+static void wakeUpMainLoop()
+{
+	static Uint32 wakeUpEvent = SDL_RegisterEvents(1);
+	if (wakeUpEvent == (Uint32)-1)
+		return;
+
+	SDL_Event event = {};
+	event.type = wakeUpEvent;
+	SDL_PushEvent(&event);
+}
+
 void Window::pushGui(GuiComponent* gui)
 {
+	mNeedsRedraw = true;
+
 	if (mGuiStack.size() > 0)
 	{
 		auto& top = mGuiStack.back();
@@ -59,6 +78,8 @@ void Window::pushGui(GuiComponent* gui)
 
 void Window::removeGui(GuiComponent* gui)
 {
+	mNeedsRedraw = true;
+
 	for(auto i = mGuiStack.cbegin(); i != mGuiStack.cend(); i++)
 	{
 		if(*i == gui)
@@ -190,16 +211,20 @@ void Window::deinit(bool deinitRenderer)
 
 void Window::textInput(const char* text)
 {
+	mNeedsRedraw = true;
+
 	if(peekGui())
 		peekGui()->textInput(text);
 }
 
 void Window::input(InputConfig* config, Input input)
 {
+	mNeedsRedraw = true;
+
 	if (mScreenSaver) {
-		if (mScreenSaver->isScreenSaverActive() && Settings::getInstance()->getBool("ScreenSaverControls") &&
-			((Settings::getInstance()->getString("ScreenSaverBehavior") == "slideshow") || 
-			(Settings::getInstance()->getString("ScreenSaverBehavior") == "random video")))
+		if (mScreenSaver->isScreenSaverActive() && Settings::getInstance()->getBool(SettingKey::ScreenSaverControls) &&
+			((Settings::getInstance()->getString(SettingKey::ScreenSaverBehavior) == "slideshow") || 
+			(Settings::getInstance()->getString(SettingKey::ScreenSaverBehavior) == "random video")))
 		{
 			if(mScreenSaver->getCurrentGame() != NULL && (config->isMappedLike("right", input) || config->isMappedTo("start", input) || config->isMappedTo("select", input)))
 			{
@@ -236,20 +261,31 @@ void Window::input(InputConfig* config, Input input)
 	if (cancelScreenSaver())
 		return;
 
-	if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_g && SDL_GetModState() & KMOD_LCTRL/* && Settings::getInstance()->getBool("Debug")*/)
+	if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_g && SDL_GetModState() & KMOD_LCTRL/* && Settings::getInstance()->getBool(SettingKey::Debug)*/)
 	{
 		// toggle debug grid with Ctrl-G
 		Settings::getInstance()->setBool("DebugGrid", !Settings::getInstance()->getBool("DebugGrid"));
 	}
-	else if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_t && SDL_GetModState() & KMOD_LCTRL/* && Settings::getInstance()->getBool("Debug")*/)
+	else if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_t && SDL_GetModState() & KMOD_LCTRL/* && Settings::getInstance()->getBool(SettingKey::Debug)*/)
 	{
 		// toggle TextComponent debug view with Ctrl-T
-		Settings::getInstance()->setBool("DebugText", !Settings::getInstance()->getBool("DebugText"));
+		Settings::getInstance()->setBool("DebugText", !Settings::getInstance()->getBool(SettingKey::DebugText));
 	}
-	else if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_i && SDL_GetModState() & KMOD_LCTRL/* && Settings::getInstance()->getBool("Debug")*/)
+	else if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_i && SDL_GetModState() & KMOD_LCTRL/* && Settings::getInstance()->getBool(SettingKey::Debug)*/)
 	{
 		// toggle TextComponent debug view with Ctrl-I
-		Settings::getInstance()->setBool("DebugImage", !Settings::getInstance()->getBool("DebugImage"));
+		Settings::getInstance()->setBool("DebugImage", !Settings::getInstance()->getBool(SettingKey::DebugImage));
+	}
+	else if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_p && SDL_GetModState() & KMOD_LCTRL)
+	{
+		// toggle the profiler and its overlay with Ctrl-P
+		Profiler::setEnabled(!Profiler::isEnabled());
+		requestRedraw();
+	}
+	else if(config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_o && SDL_GetModState() & KMOD_LCTRL)
+	{
+		// write the profiler trace with Ctrl-O
+		Profiler::requestDump();
 	}
 	else
 	{
@@ -265,6 +301,8 @@ void Window::input(InputConfig* config, Input input)
 
 void Window::update(int deltaTime)
 {	
+	PROFILE_SCOPE("Window::update");
+
 	processPostedFunctions();
 	processNotificationMessages();
 
@@ -275,10 +313,12 @@ void Window::update(int deltaTime)
 			deltaTime = mAverageDeltaTime;
 	}
 
-	if (Settings::getInstance()->getBool("VolumePopup") && (mVolumeInfo != nullptr))
+	TextureResource::update();
+
+	if (Settings::getInstance()->getBool(SettingKey::VolumePopup) && (mVolumeInfo != nullptr))
 		mVolumeInfo->update(deltaTime);
 
-	if (Settings::getInstance()->getBool("BrightnessPopup") && (mBrightnessInfo != nullptr))
+	if (Settings::getInstance()->getBool(SettingKey::BrightnessPopup) && (mBrightnessInfo != nullptr))
 		mBrightnessInfo->update(deltaTime);
 
 	mFrameTimeElapsed += deltaTime;
@@ -287,7 +327,7 @@ void Window::update(int deltaTime)
 	{
 		mAverageDeltaTime = mFrameTimeElapsed / mFrameCountElapsed;
 
-		if(Settings::getInstance()->getBool("DrawFramerate"))
+		if(Settings::getInstance()->getBool(SettingKey::DrawFramerate))
 		{
 			std::stringstream ss;
 
@@ -302,15 +342,37 @@ void Window::update(int deltaTime)
 
 			ss << "\nFont VRAM: " << fontVramUsageMb << " Tex VRAM: " << textureVramUsageMb <<
 				  " Tex Max: " << textureTotalUsageMb;
+
+			// texture budgets, per class : usage/budget in MB
+			TextureMemoryStats textureStats = TextureDataManager::getStats();
+			const char* classNames[TextureClass::COUNT] = { "Theme", "Art", "Font", "Video" };
+
+			ss << "\n";
+			for (int i = 0; i < TextureClass::COUNT; i++)
+			{
+				ss << classNames[i] << ": " << textureStats.usage[i] / 1000000.0f;
+				if (textureStats.budget[i] > 0)
+					ss << "/" << textureStats.budget[i] / 1000000.0f;
+				ss << " ";
+			}
+			ss << "Evictions: " << textureStats.evictions;
+
+			// batching
+			const Renderer::FrameStats& frameStats = Renderer::getFrameStats();
+			ss << "\nDraw calls: " << frameStats.drawCalls << " Primitives: " << frameStats.primitives << " Vertices: " << frameStats.vertices;
+			ss << "\nTexture uploads: " << frameStats.textureUploads << " (" << frameStats.uploadedBytes / 1024 << " KB)";
+			ss << " Skipped frames: " << (mSkippedFrames - mSkippedFramesElapsed);
 			mFrameDataText = std::unique_ptr<TextCache>(mDefaultFonts.at(1)->buildTextCache(ss.str(), 50.f, 50.f, 0xFF00FFFF));
 		}
 
 		mFrameTimeElapsed = 0;
 		mFrameCountElapsed = 0;
+		mSkippedFramesElapsed = mSkippedFrames;
+		mNeedsRedraw |= Settings::getInstance()->getBool(SettingKey::DrawFramerate);
 	}
 
 	/* draw the clock */ // batocera
-	if (Settings::getInstance()->getBool("DrawClock") && mClock) 
+	if (Settings::getInstance()->getBool(SettingKey::DrawClock) && mClock) 
 	{
 		mClockElapsed -= deltaTime;
 		if (mClockElapsed <= 0)
@@ -324,7 +386,7 @@ void Window::update(int deltaTime)
 				// Visit http://en.cppreference.com/w/cpp/chrono/c/strftime for more information about date/time format
 				
 				std::string clockBuf;
-				if (Settings::getInstance()->getBool("ClockMode12"))
+				if (Settings::getInstance()->getBool(SettingKey::ClockMode12))
 					clockBuf = Utils::Time::timeToString(clockNow, "%I:%M %p");
 				else
 					clockBuf = Utils::Time::timeToString(clockNow, "%H:%M");
@@ -350,7 +412,7 @@ void Window::update(int deltaTime)
 	//if (mControllerActivity)
 		//mControllerActivity->update(deltaTime);
 
-	if ((mBatteryIndicator != nullptr) && (Settings::getInstance()->getBool("ShowBatteryIndicator") || Settings::getInstance()->getBool("ShowNetworkIndicator")))
+	if ((mBatteryIndicator != nullptr) && (Settings::getInstance()->getBool(SettingKey::ShowBatteryIndicator) || Settings::getInstance()->getBool(SettingKey::ShowNetworkIndicator)))
 		mBatteryIndicator->update(deltaTime);
 
 	AudioManager::update(deltaTime);
@@ -358,9 +420,13 @@ void Window::update(int deltaTime)
 
 void Window::render()
 {
+	PROFILE_SCOPE("Window::render");
+
 	Transform4x4f transform = Transform4x4f::Identity();
 
 	mRenderedHelpPrompts = false;
+	mNeedsRedraw = false;
+	mLastRenderTime = SDL_GetTicks();
 
 	// draw only bottom and top of GuiStack (if they are different)
 	if(mGuiStack.size())
@@ -389,7 +455,7 @@ void Window::render()
 		if(!mRenderedHelpPrompts)
 			mHelp->render(transform);
 
-	if(Settings::getInstance()->getBool("DrawFramerate") && mFrameDataText)
+	if(Settings::getInstance()->getBool(SettingKey::DrawFramerate) && mFrameDataText)
 	{
 		Renderer::setMatrix(Transform4x4f::Identity());
 		mDefaultFonts.at(1)->renderTextCache(mFrameDataText.get());
@@ -397,20 +463,20 @@ void Window::render()
 
 
 	// clock // batocera
-	if (Settings::getInstance()->getBool("DrawClock") && (mClock != nullptr) && (mGuiStack.size() < 2 || !Renderer::isSmallScreen()))
+	if (Settings::getInstance()->getBool(SettingKey::DrawClock) && (mClock != nullptr) && (mGuiStack.size() < 2 || !Renderer::isSmallScreen()))
 		mClock->render(transform);
 
 	//if (Settings::getInstance()->getBool("ShowControllerActivity") && (mControllerActivity != nullptr) && (mGuiStack.size() < 2 || !Renderer::isSmallScreen()))ShowNetworkIndicator
 	//if ((mControllerActivity != nullptr) && (mGuiStack.size() < 2 || !Renderer::isSmallScreen()))
 		//mControllerActivity->render(transform);
 
-	if ((mBatteryIndicator != nullptr) && (Settings::getInstance()->getBool("ShowBatteryIndicator") || Settings::getInstance()->getBool("ShowNetworkIndicator")) && (mGuiStack.size() < 2 || !Renderer::isSmallScreen()))
+	if ((mBatteryIndicator != nullptr) && (Settings::getInstance()->getBool(SettingKey::ShowBatteryIndicator) || Settings::getInstance()->getBool(SettingKey::ShowNetworkIndicator)) && (mGuiStack.size() < 2 || !Renderer::isSmallScreen()))
 		mBatteryIndicator->render(transform);
 
 	// pads // batocera
 	Renderer::setMatrix(Transform4x4f::Identity());
 
-	unsigned int screensaverTime = (unsigned int)Settings::getInstance()->getInt("ScreenSaverTime");
+	unsigned int screensaverTime = (unsigned int)Settings::getInstance()->getInt(SettingKey::ScreenSaverTime);
 	if(mTimeSinceLastInput >= screensaverTime && screensaverTime != 0)
 		startScreenSaver();
 
@@ -427,12 +493,14 @@ void Window::render()
 	for (auto extra : mScreenExtras)
 		extra->render(transform);
 
-	if (Settings::getInstance()->getBool("VolumePopup") && mVolumeInfo)
+	if (Settings::getInstance()->getBool(SettingKey::VolumePopup) && mVolumeInfo)
 		mVolumeInfo->render(transform);
 
-	if (Settings::getInstance()->getBool("BrightnessPopup") && mBrightnessInfo)
+	if (Settings::getInstance()->getBool(SettingKey::BrightnessPopup) && mBrightnessInfo)
 		mBrightnessInfo->render(transform);
 
+	Profiler::render();
+
 	if(mTimeSinceLastInput >= screensaverTime && screensaverTime != 0)
 	{
 		if (!isProcessing() && mAllowSleep && (!mScreenSaver || mScreenSaver->allowSleep()))
@@ -451,6 +519,78 @@ void Window::normalizeNextUpdate()
 	mNormalizeNextUpdate = true;
 }
 
+// Refresh rate of a still screen : the clock, battery & network indicators, and components not reporting their state
+#define IDLE_REDRAW_INTERVAL 1000
+
+bool Window::isAnimating()
+{
+	if (mRenderScreenSaver || (mScreenSaver && mScreenSaver->isScreenSaverActive()))
+		return true;
+
+	// the screensaver starts at the next rendered frame
+	unsigned int screensaverTime = (unsigned int)Settings::getInstance()->getInt(SettingKey::ScreenSaverTime);
+	if (screensaverTime != 0 && mTimeSinceLastInput >= screensaverTime)
+		return true;
+
+	// components asking the power saver to wait (videos, scrolling lists, popups...)
+	if (PowerSaver::isPaused())
+		return true;
+
+	// the profiler overlay changes every frame
+	if (Profiler::isEnabled())
+		return true;
+
+	if (mInfoPopup && mInfoPopup->isRunning())
+		return true;
+
+	if ((mVolumeInfo && mVolumeInfo->isVisible()) || (mBrightnessInfo && mBrightnessInfo->isVisible()))
+		return true;
+
+	{
+		std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
+		if (!mAsyncNotificationComponent.empty() || !mNotificationMessages.empty() || !mFunctions.empty())
+			return true;
+	}
+
+	// same components as render()
+	if (mGuiStack.size())
+	{
+		if (mGuiStack.front()->isAnimating() || mGuiStack.back()->isAnimating())
+			return true;
+
+		if (mGuiStack.size() > 2 && mGuiStack.back()->isKindOf<GuiMsgBox>() && mGuiStack.at(mGuiStack.size() - 2)->isAnimating())
+			return true;
+	}
+
+	for (auto extra : mScreenExtras)
+		if (extra->isAnimating())
+			return true;
+
+	return false;
+}
+
+bool Window::needsRedraw()
+{
+	if (!Settings::getInstance()->getBool(SettingKey::SkipIdleFrames))
+		return true;
+
+	// the frame after an animation shows its final state
+	bool animating = isAnimating();
+	bool redraw = mNeedsRedraw || animating || mWasAnimating;
+	mWasAnimating = animating;
+
+	return redraw || getIdleTimeout() == 0;
+}
+
+int Window::getIdleTimeout()
+{
+	int elapsed = (int)(SDL_GetTicks() - mLastRenderTime);
+	if (elapsed >= IDLE_REDRAW_INTERVAL || elapsed < 0)
+		return 0;
+
+	return IDLE_REDRAW_INTERVAL - elapsed;
+}
+
 bool Window::getAllowSleep()
 {
 	return mAllowSleep;
@@ -716,7 +856,6 @@ void Window::renderScreenSaver()
 		mScreenSaver->renderScreenSaver();
 }
 
-static std::mutex mNotificationMessagesLock;
 
 void Window::displayNotificationMessage(std::string message, int duration)
 {
@@ -735,6 +874,7 @@ void Window::displayNotificationMessage(std::string message, int duration)
 	msg.first = message;
 	msg.second = duration;
 	mNotificationMessages.push_back(msg);
+	wakeUpMainLoop();
 }
 
 void Window::processNotificationMessages()
@@ -798,6 +938,7 @@ void Window::postToUiThread(const std::function<void(Window*)>& func)
 	std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
 
 	mFunctions.push_back(func);
+	wakeUpMainLoop();
 }
 
 void Window::processPostedFunctions()
@@ -862,10 +1003,10 @@ void Window::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
 	if (mBatteryIndicator != nullptr)
 		mBatteryIndicator->applyTheme(theme, "screen", "batteryIndicator", ThemeFlags::ALL);
 
-	if (Settings::getInstance()->getBool("VolumePopup") && (mVolumeInfo != nullptr))
+	if (Settings::getInstance()->getBool(SettingKey::VolumePopup) && (mVolumeInfo != nullptr))
 		mVolumeInfo = std::make_shared<VolumeInfoComponent>(this);
 
-	if (Settings::getInstance()->getBool("BrightnessPopup") && (mBrightnessInfo != nullptr))
+	if (Settings::getInstance()->getBool(SettingKey::BrightnessPopup) && (mBrightnessInfo != nullptr))
 		mBrightnessInfo = std::make_shared<BrightnessInfoComponent>(this);
 
 }
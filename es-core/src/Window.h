@@ -49,6 +49,7 @@ public:
 	public:
 		virtual void render(const Transform4x4f& parentTrans) = 0;
 		virtual void stop() = 0;
+		virtual bool isRunning() { return true; }
 		virtual ~InfoPopup() {};
 	};
 
@@ -70,6 +71,12 @@ public:
 
 	void normalizeNextUpdate();
 
+	// Idle frames : when nothing is animating and nothing changed, the main loop waits for events instead of rendering
+	bool needsRedraw();
+	inline void requestRedraw() { mNeedsRedraw = true; }
+	inline void skipFrame() { mSkippedFrames++; }
+	int getIdleTimeout(); // ms before the next periodic refresh
+
 	inline bool isSleeping() const { return mSleeping; }
 	bool getAllowSleep();
 	void setAllowSleep(bool sleep);
@@ -118,6 +125,9 @@ private:
 	// Returns true if at least one component on the stack is processing
 	bool isProcessing();
 
+	// Returns true if something on screen changes without input
+	bool isAnimating();
+
 	HelpComponent*  mHelp;
 	ImageComponent* mBackgroundOverlay;
 	ScreenSaver*    mScreenSaver;
@@ -154,6 +164,12 @@ private:
 	unsigned int mTimeSinceLastInput;
 
 	bool mRenderedHelpPrompts;
+
+	bool mNeedsRedraw;
+	bool mWasAnimating;
+	unsigned int mLastRenderTime;
+	unsigned int mSkippedFrames;
+	unsigned int mSkippedFramesElapsed;
 };
 
 #endif // ES_CORE_WINDOW_H
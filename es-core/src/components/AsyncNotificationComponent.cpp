@@ -95,7 +95,7 @@ void AsyncNotificationComponent::render(const Transform4x4f& parentTrans)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 
 	if (mGameName != nullptr && mNextGameName != mGameName->getText())
 		mGameName->setText(mNextGameName);
@@ -113,7 +113,7 @@ void ButtonComponent::updateImage()
 
 void ButtonComponent::render(const Transform4x4f& parentTrans)
 {
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 
 	if (mRenderNonFocusedBackground || mFocused)
 		mBox.render(trans);
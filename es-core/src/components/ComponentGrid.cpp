@@ -362,7 +362,7 @@ void ComponentGrid::update(int deltaTime)
 
 void ComponentGrid::render(const Transform4x4f& parentTrans)
 {
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 
 	renderChildren(trans);
 	
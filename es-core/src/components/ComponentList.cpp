@@ -186,7 +186,7 @@ void ComponentList::render(const Transform4x4f& parentTrans)
 	unsigned int textColor = menuTheme->Text.color;
 	bool selectorGradientHorz = menuTheme->Text.selectorGradientType;
 
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 
 	// clip everything to be inside our boundsz
 	Vector3f dim(mSize.x(), mSize.y(), 0);
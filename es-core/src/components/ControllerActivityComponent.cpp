@@ -5,6 +5,7 @@
 #include "ThemeData.h"
 #include "InputManager.h"
 #include "Settings.h"
+#include "SensorService.h"
 #include "platform.h"
 #include "Log.h"
 
@@ -155,13 +156,13 @@ void ControllerActivityComponent::render(const Transform4x4f& parentTrans)
 		return;
 	}
 
-	Transform4x4f trans = parentTrans * getTransform();
-	if (!Renderer::isVisibleOnScreen(trans.translation().x(), trans.translation().y(), mSize.x(), mSize.y()))
+	Transform4x4f trans = getWorldTransform(parentTrans);
+	if (!isOnScreen())
 		return;
 
 	Renderer::setMatrix(trans);
 
-	if (Settings::getInstance()->getBool("DebugImage"))
+	if (Settings::getInstance()->getBool(SettingKey::DebugImage))
 		Renderer::drawRect(0.0f, 0.0f, mSize.x(), mSize.y(), 0xFFFF0090, 0xFFFF0090);
 
 	float x = 0;
@@ -171,12 +172,12 @@ void ControllerActivityComponent::render(const Transform4x4f& parentTrans)
 	int itemsWidth = 0;
 	float batteryTextOffset = 0;
 
-	//bool showBatteryController = Settings::getInstance()->getBool("ShowBatteryIndicator");
-	//bool showNetworkController = Settings::getInstance()->getBool("ShowNetworkIndicator");
+	//bool showBatteryController = Settings::getInstance()->getBool(SettingKey::ShowBatteryIndicator);
+	//bool showNetworkController = Settings::getInstance()->getBool(SettingKey::ShowNetworkIndicator);
 
 /*
 	//bool showControllerActivity = Settings::getInstance()->getBool("ShowControllerActivity");
-	//bool showControllerBattery = showControllerActivity && Settings::getInstance()->getBool("ShowBatteryIndicator");
+	//bool showControllerBattery = showControllerActivity && Settings::getInstance()->getBool(SettingKey::ShowBatteryIndicator);
 
 /*
 	if ((mView & CONTROLLERS) && showControllerActivity)
@@ -401,18 +402,19 @@ void ControllerActivityComponent::applyTheme(const std::shared_ptr<ThemeData>& t
 
 void ControllerActivityComponent::updateNetworkInfo()
 {
-	mNetworkConnected = Settings::getInstance()->getBool("ShowNetworkIndicator") && queryNetworkConnected();
+	// Sampled in the background : queryNetworkConnected() runs nmcli
+	mNetworkConnected = Settings::getInstance()->getBool(SettingKey::ShowNetworkIndicator) && SensorService::getInstance()->getSnapshot().wifiConnected;
 }
 
 void ControllerActivityComponent::updateBatteryInfo()
 {
-	if (!Settings::getInstance()->getBool("ShowBatteryIndicator") || Settings::getInstance()->getString("ShowBattery").empty() || (mView & BATTERY) == 0)
+	if (!Settings::getInstance()->getBool(SettingKey::ShowBatteryIndicator) || Settings::getInstance()->getString("ShowBattery").empty() || (mView & BATTERY) == 0)
 	{
 		mBatteryInfo.hasBattery = false;
 		return;
 	}
 
-	BatteryInformation info = queryBatteryInformation(false);
+	BatteryInformation info = queryBatteryInformation(true);
 
 	if (info.hasBattery == mBatteryInfo.hasBattery && info.isCharging == mBatteryInfo.isCharging && info.level == mBatteryInfo.level)
 		return;
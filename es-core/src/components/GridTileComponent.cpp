@@ -343,22 +343,36 @@ void GridTileComponent::renderContent(const Transform4x4f& parentTrans)
 	if (!mLabelMerged && isMinSize)
 		Renderer::popClipRect();
 
-	std::vector<GuiComponent*> zOrdered;
+	GuiComponent* layers[3];
+	int count = 0;
 
 	if (mMarquee != nullptr && mMarquee->hasImage())
-		zOrdered.push_back(mMarquee);
+		layers[count++] = mMarquee;
 	else
-		zOrdered.push_back(&mLabel);
+		layers[count++] = &mLabel;
 
 	if (mFavorite != nullptr && mFavorite->hasImage() && mFavorite->isVisible())
-		zOrdered.push_back(mFavorite);
+		layers[count++] = mFavorite;
 
 	if (mImageOverlay != nullptr && mImageOverlay->hasImage() && mImageOverlay->isVisible())
-		zOrdered.push_back(mImageOverlay);
+		layers[count++] = mImageOverlay;
 
-	std::stable_sort(zOrdered.begin(), zOrdered.end(), [](GuiComponent* a, GuiComponent* b) { return b->getZIndex() > a->getZIndex(); });
+	// the sorted list is kept until a layer appears, disappears or changes its z-index
+	bool changed = (count != (int)mZOrdered.size());
 
-	for (auto comp : zOrdered)
+	for (int i = 0; !changed && i < count; i++)
+		changed = std::find(mZOrdered.cbegin(), mZOrdered.cend(), layers[i]) == mZOrdered.cend();
+
+	for (int i = 1; !changed && i < (int)mZOrdered.size(); i++)
+		changed = mZOrdered[i]->getZIndex() < mZOrdered[i - 1]->getZIndex();
+
+	if (changed)
+	{
+		mZOrdered.assign(layers, layers + count);
+		std::stable_sort(mZOrdered.begin(), mZOrdered.end(), [](GuiComponent* a, GuiComponent* b) { return b->getZIndex() > a->getZIndex(); });
+	}
+
+	for (auto comp : mZOrdered)
 		comp->render(trans);
 
 	if (mLabelMerged && isMinSize)
@@ -273,6 +273,8 @@ private:
 	ImageComponent* mFavorite;
 	ImageComponent* mImageOverlay;
 
+	std::vector<GuiComponent*> mZOrdered; // label/marquee, favorite & overlay, sorted by z-index
+
 	bool mVideoPlaying;
 	bool mShown;
 };
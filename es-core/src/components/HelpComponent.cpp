@@ -59,7 +59,7 @@ void HelpComponent::setStyle(const HelpStyle& style)
 
 void HelpComponent::updateGrid()
 {
-	if(!Settings::getInstance()->getBool("ShowHelpPrompts") || mPrompts.empty())
+	if(!Settings::getInstance()->getBool(SettingKey::ShowHelpPrompts) || mPrompts.empty())
 	{
 		mGrid.reset();
 		return;
@@ -146,7 +146,7 @@ void HelpComponent::setOpacity(unsigned char opacity)
 
 void HelpComponent::render(const Transform4x4f& parentTrans)
 {
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 
 	if(mGrid)
 		mGrid->render(trans);
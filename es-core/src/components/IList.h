@@ -99,6 +99,11 @@ public:
 		return (mScrollVelocity != 0 && mScrollTier > 0);
 	}
 
+	bool isAnimating() override
+	{
+		return mScrollVelocity != 0 || mTitleOverlayOpacity != 0 || GuiComponent::isAnimating();
+	}
+
 	int getScrollingVelocity()
 	{
 		return mScrollVelocity;
@@ -2,6 +2,7 @@
 
 #include "resources/TextureResource.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "renderers/Renderer.h"
 #include "Settings.h"
 #include "ThemeData.h"
@@ -363,6 +364,8 @@ void ImageComponent::updateVertices()
 
 void ImageComponent::render(const Transform4x4f& parentTrans)
 {
+	PROFILE_SCOPE("ImageComponent::render");
+
 	if (!mVisible)
 		return;
 
@@ -373,10 +376,10 @@ void ImageComponent::render(const Transform4x4f& parentTrans)
 		resize();
 	}
 
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 	
-	// Don't use soft clip if rotation applied : let renderer do the work
-	if (mRotation == 0 && !Renderer::isVisibleOnScreen(trans.translation().x(), trans.translation().y(), mSize.x(), mSize.y()))
+	// Screen bounds include rotation & scale
+	if (!isOnScreen())
 		return;
 		
 	Renderer::setMatrix(trans);
@@ -385,7 +388,7 @@ void ImageComponent::render(const Transform4x4f& parentTrans)
 	{
 		Vector2f targetSizePos = (mTargetSize - mSize) * mOrigin * -1;
 
-		if (Settings::getInstance()->getBool("DebugImage"))
+		if (Settings::getInstance()->getBool(SettingKey::DebugImage))
 		{
 			Renderer::drawRect(targetSizePos.x(), targetSizePos.y(), mTargetSize.x(), mTargetSize.y(), 0xFF000033);
 			Renderer::drawRect(0.0f, 0.0f, mSize.x(), mSize.y(), 0x00000033);
@@ -569,12 +572,12 @@ void ImageComponent::applyTheme(const std::shared_ptr<ThemeData>& theme, const s
 		if(elem->has("size"))
 		{
 			auto sz = elem->get<Vector2f>("size");
-			if (sz.x() == 0 && sz.y() != 0 && Settings::getInstance()->getInt("ScreenRotate") != 0)
+			if (sz.x() == 0 && sz.y() != 0 && Settings::getInstance()->getInt(SettingKey::ScreenRotate) != 0)
 			{
 				sz.x() = sz.y();
 				setMinSize(sz * scale);
 			}
-			else if (sz.y() == 0 && sz.x() != 0 && Settings::getInstance()->getInt("ScreenRotate") != 0)
+			else if (sz.y() == 0 && sz.x() != 0 && Settings::getInstance()->getInt(SettingKey::ScreenRotate) != 0)
 			{
 				sz.y() = sz.x();
 				setMinSize(sz * scale);
@@ -741,6 +744,16 @@ void ImageComponent::update(int deltaTime)
 	}
 }
 
+bool ImageComponent::isAnimating()
+{
+	// waiting for an asynchronous texture, or fading it in. Pictures that failed, or that aren't requested
+	// because they are off screen, don't keep the window redrawing
+	if (mFading || (mLoadingTexture != nullptr && mLoadingTexture->isLoading()) || (mTexture != nullptr && mTexture->isLoading()))
+		return true;
+
+	return GuiComponent::isAnimating();
+}
+
 bool ImageComponent::isTiled()
 { 
 	return mTexture != nullptr && mTexture->isTiled(); 
@@ -117,6 +117,7 @@ public:
 	virtual void onShow() override;
 	virtual void onHide() override;
 	virtual void update(int deltaTime);
+	bool isAnimating() override;
 
 	void setPlaylist(std::shared_ptr<IPlaylist> playList);
 
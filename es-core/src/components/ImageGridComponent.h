@@ -3,6 +3,7 @@
 #define ES_CORE_COMPONENTS_IMAGE_GRID_COMPONENT_H
 
 #include "Log.h"
+#include "Profiler.h"
 #include "components/IList.h"
 #include "resources/TextureResource.h"
 #include "GridTileComponent.h"
@@ -70,6 +71,7 @@ public:
 
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
+	bool isAnimating() override;
 	void render(const Transform4x4f& parentTrans) override;
 	virtual void applyTheme(const std::shared_ptr<ThemeData>& theme, const std::string& view, const std::string& element, unsigned int properties) override;
 
@@ -101,6 +103,7 @@ private:
 	void buildTiles();
 	void updateTiles(bool allowAnimation = true, bool updateSelectedState = true);
 	void updateTileAtPos(int tilePos, int imgPos, bool allowAnimation = true, bool updateSelectedState = true);
+	void updateLoadPriorities();
 	void calcGridDimension();
 	
 	bool isVertical() { return mScrollDirection == SCROLL_VERTICALLY; };
@@ -244,6 +247,19 @@ void ImageGridComponent<T>::update(int deltaTime)
 		(*it)->update(deltaTime);
 }
 
+template<typename T>
+bool ImageGridComponent<T>::isAnimating()
+{
+	if (IList<ImageGridData, T>::isAnimating())
+		return true;
+
+	for (auto it = mTiles.begin(); it != mTiles.end(); it++)
+		if ((*it)->isVisible() && (*it)->isAnimating())
+			return true;
+
+	return false;
+}
+
 template<typename T>
 void ImageGridComponent<T>::topWindow(bool isTop)
 {
@@ -333,6 +349,8 @@ void ImageGridComponent<T>::onHide()
 template<typename T>
 void ImageGridComponent<T>::render(const Transform4x4f& parentTrans)
 {
+	PROFILE_SCOPE("ImageGridComponent::render");
+
 	Transform4x4f trans = getTransform() * parentTrans;
 	Transform4x4f tileTrans = trans;
 
@@ -679,8 +697,12 @@ void ImageGridComponent<T>::onCursorChanged(const CursorState& state)
 			else
 				newTile->setSelected(true, true, oldPos == Vector3f(0, 0) ? nullptr : &oldPos, true);
 		}
+
+		// The newly selected tile must load before anything else, even if the tiles are only updated once the camera has moved.
+		// Without animations, updateTiles() selects the tile and ranks the loads below
+		updateLoadPriorities();
 	}
-	
+
 	int firstVisibleCol = mStartPosition / dimOpposite;
 
 	if (mCenterSelection == CenterSelection::NEVER)
@@ -807,16 +829,20 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 		newTextures.push_back(mTiles.at(ti)->getTexture(false));
 	}
 
-	// Compare old texture with new textures -> Remove missing from async queue if existing
+	// Compare old texture with new textures -> Remove missing from async queue if existing, as a single batch
+	std::vector<std::shared_ptr<TextureResource>> staleTextures;
 	for (auto tex : previousTextures)
 	{
 		if (tex == nullptr)
 			continue;
 
 		if (std::find(newTextures.cbegin(), newTextures.cend(), tex) == newTextures.cend())
-			TextureResource::cancelAsync(tex);
+			staleTextures.push_back(tex);
 	}
 
+	TextureResource::cancelAsync(staleTextures);
+	updateLoadPriorities();
+
 	if (updateSelectedState)
 		mLastCursor = mCursor;
 
@@ -933,6 +959,35 @@ void ImageGridComponent<T>::updateTileAtPos(int tilePos, int imgPos, bool allowA
 }
 
 
+template<typename T>
+void ImageGridComponent<T>::updateLoadPriorities()
+{
+	// The EXTRAITEMS rows (or columns) on each side of the grid are not on screen yet
+	int bufferTiles = EXTRAITEMS * (isVertical() ? mGridDimension.x() : mGridDimension.y());
+
+	std::vector<std::shared_ptr<TextureResource>> textures[TexturePriority::COUNT];
+
+	for (int ti = 0; ti < (int)mTiles.size(); ti++)
+	{
+		std::shared_ptr<GridTileComponent> tile = mTiles.at(ti);
+		if (!tile->isVisible())
+			continue;
+
+		TexturePriority::Level priority = TexturePriority::Visible;
+		if (tile->isSelected())
+			priority = TexturePriority::Selected;
+		else if (ti < bufferTiles || ti >= (int)mTiles.size() - bufferTiles)
+			priority = TexturePriority::Prefetch;
+
+		textures[priority].push_back(tile->getTexture(false));
+		textures[priority].push_back(tile->getTexture(true));
+	}
+
+	for (int i = 0; i < TexturePriority::COUNT; i++)
+		if (textures[i].size())
+			TextureResource::setLoadPriority(textures[i], (TexturePriority::Level)i);
+}
+
 // Create and position tiles (mTiles)
 template<typename T>
 void ImageGridComponent<T>::buildTiles()
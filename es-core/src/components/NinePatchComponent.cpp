@@ -137,8 +137,8 @@ void NinePatchComponent::render(const Transform4x4f& parentTrans)
 	if (!isVisible() || mTexture == nullptr || mVertices == nullptr)
 		return;
 
-	Transform4x4f trans = parentTrans * getTransform();
-	if (!Renderer::isVisibleOnScreen(trans.translation().x(), trans.translation().y(), mSize.x(), mSize.y()))
+	Transform4x4f trans = getWorldTransform(parentTrans);
+	if (!isOnScreen())
 		return;
 
 	if (mCornerSize.x() <= 1 && mCornerSize.y() <= 1 && mCornerSize.x() == mCornerSize.y())
@@ -17,7 +17,7 @@ void ScrollableContainer::render(const Transform4x4f& parentTrans)
 	if (!isVisible())
 		return;
 
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 
 	Vector2i clipPos((int)trans.translation().x(), (int)trans.translation().y());
 
@@ -107,6 +107,14 @@ void ScrollableContainer::update(int deltaTime)
 	GuiComponent::update(deltaTime);
 }
 
+bool ScrollableContainer::isAnimating()
+{
+	if (mAutoScrollSpeed != 0 && getContentSize().y() > getSize().y())
+		return true;
+
+	return GuiComponent::isAnimating();
+}
+
 //this should probably return a box to allow for when controls don't start at 0,0
 Vector2f ScrollableContainer::getContentSize()
 {
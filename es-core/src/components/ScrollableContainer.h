@@ -15,6 +15,7 @@ public:
 	void reset();
 
 	void update(int deltaTime) override;
+	bool isAnimating() override;
 	void render(const Transform4x4f& parentTrans) override;
 
 private:
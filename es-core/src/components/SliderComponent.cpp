@@ -69,7 +69,7 @@ void SliderComponent::update(int deltaTime)
 
 void SliderComponent::render(const Transform4x4f& parentTrans)
 {
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 	Renderer::setMatrix(trans);
 
 	// render suffix
@@ -2,6 +2,7 @@
 
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "Settings.h"
 
 TextComponent::TextComponent(Window* window) : GuiComponent(window),
@@ -125,7 +126,7 @@ void TextComponent::setUppercase(bool uppercase)
 void TextComponent::renderSingleGlow(const Transform4x4f& parentTrans, float yOff, float x, float y)
 {
 	Vector3f off = Vector3f(mPadding.x() + x + mGlowOffset.x(), mPadding.y() + yOff + y + mGlowOffset.y(), 0);
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 
 	trans.translate(off);
 	trans.round();
@@ -164,12 +165,14 @@ void TextComponent::renderGlow(const Transform4x4f& parentTrans, float yOff, flo
 
 void TextComponent::render(const Transform4x4f& parentTrans)
 {
+	PROFILE_SCOPE("TextComponent::render");
+
 	if (!isVisible())
 		return;
 
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 
-	if (!Renderer::isVisibleOnScreen(trans.translation().x(), trans.translation().y(), mSize.x(), mSize.y()))
+	if (!isOnScreen())
 		return;
 
 	if (mRenderBackground)
@@ -201,7 +204,7 @@ void TextComponent::render(const Transform4x4f& parentTrans)
 		}
 		Vector3f off(mPadding.x(), mPadding.y() + yOff, 0);
 
-		if (Settings::getInstance()->getBool("DebugText"))
+		if (Settings::getInstance()->getBool(SettingKey::DebugText))
 		{
 			// draw the "textbox" area, what we are aligned within
 			Renderer::setMatrix(trans);
@@ -225,7 +228,7 @@ void TextComponent::render(const Transform4x4f& parentTrans)
 		Renderer::setMatrix(trans);
 
 		// draw the text area, where the text actually is going
-		if (Settings::getInstance()->getBool("DebugText"))
+		if (Settings::getInstance()->getBool(SettingKey::DebugText))
 		{
 			switch (mHorizontalAlignment)
 			{
@@ -410,6 +413,12 @@ void TextComponent::update(int deltaTime)
 	}
 }
 
+bool TextComponent::isAnimating()
+{
+	// the marquee only moves after its delay
+	return mMarqueeOffset != 0 || mMarqueeOffset2 != 0 || GuiComponent::isAnimating();
+}
+
 void TextComponent::onColorChanged()
 {
 	if (mTextCache)
@@ -49,6 +49,7 @@ public:
 	void setPadding(const Vector4f padding) { mPadding = padding; }
 
 	virtual void update(int deltaTime);
+	bool isAnimating() override;
 
 	bool getAutoScroll() { return mAutoScroll; }
 	void setAutoScroll(bool value);
@@ -163,14 +163,14 @@ void VideoComponent::render(const Transform4x4f& parentTrans)
 	if (!isVisible())
 		return;
 
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 	GuiComponent::renderChildren(trans);
 	
 	VideoComponent::renderSnapshot(parentTrans);
 
 	Renderer::setMatrix(trans);
 
-	if (Settings::getInstance()->getBool("DebugImage"))
+	if (Settings::getInstance()->getBool(SettingKey::DebugImage))
 	{
 		Vector2f targetSizePos = (mTargetSize - mSize) * mOrigin * -1;
 		Renderer::drawRect(targetSizePos.x(), targetSizePos.y(), mTargetSize.x(), mTargetSize.y(), 0xFF000033);
@@ -373,6 +373,14 @@ void VideoComponent::startVideoWithDelay()
 	}
 }
 
+bool VideoComponent::isAnimating()
+{
+	if (mIsPlaying || mStartDelayed || mIsWaitingForVideoToStart)
+		return true;
+
+	return mStaticImage.isAnimating() || GuiComponent::isAnimating();
+}
+
 void VideoComponent::update(int deltaTime)
 {
 	manageState();
@@ -228,9 +228,9 @@ void VideoVlcComponent::render(const Transform4x4f& parentTrans)
 		return;
 
 	
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 	
-	if (mRotation == 0 && !mTargetIsMin && !Renderer::isVisibleOnScreen(trans.translation().x(), trans.translation().y(), mSize.x(), mSize.y()))
+	if (!mTargetIsMin && !isOnScreen())
 		return;
 		
 	GuiComponent::renderChildren(trans);
@@ -128,7 +128,7 @@ void VolumeInfoComponent::render(const Transform4x4f& parentTrans)
 
 	GuiComponent::render(parentTrans);
 
-	Transform4x4f trans = parentTrans * getTransform();
+	Transform4x4f trans = getWorldTransform(parentTrans);
 	Renderer::setMatrix(trans);
 
 	float x = PADDING_PX + PADDING_BAR;
@@ -15,6 +15,7 @@ public:
 	~GuiInfoPopup();
 	void render(const Transform4x4f& parentTrans) override;
 	inline void stop() { running = false; };
+	bool isRunning() override { return running; }
 private:
 	std::string mMessage;
 	int mDuration;
@@ -7,13 +7,16 @@
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include "SensorService.h"
 
 #include <ifaddrs.h>
 #include <netinet/in.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <arpa/inet.h>
+#if !defined(USE_NULL_RENDERER)
 #include <go2/display.h>
+#endif
 #include <vector>
 
 int runShutdownCommand()
@@ -162,6 +165,15 @@ BatteryInformation queryBatteryInformation(bool summary)
 {
 	BatteryInformation ret;
 
+	if (summary && SensorService::getInstance()->isRunning())
+	{
+		SensorSnapshot snapshot = SensorService::getInstance()->getSnapshot();
+		ret.hasBattery = snapshot.hasBattery;
+		ret.level = snapshot.batteryLevel;
+		ret.isCharging = snapshot.isCharging;
+		return ret;
+	}
+
 	std::string batteryRootPath = queryBatteryRootPath();
 
 	// Find battery path - only at the first call
@@ -636,12 +648,18 @@ int queryBrightness()
 
 int queryBrightnessLevel()
 {
+#if defined(USE_NULL_RENDERER)
+	return 50;
+#else
 	return (int) go2_display_backlight_get(NULL);
+#endif
 }
 
 void saveBrightnessLevel(int brightness_level)
 {
+#if !defined(USE_NULL_RENDERER)
 	go2_display_backlight_set(NULL, brightness_level);
+#endif
 }
 
 SoftwareInformation querySoftwareInformation(bool summary)
@@ -62,7 +62,8 @@ struct BatteryInformation
 	float voltage;
 };
 
-BatteryInformation queryBatteryInformation(bool summary);
+BatteryInformation queryBatteryInformation(bool summary); // summary is served by the SensorService when running
+std::string queryBatteryRootPath();
 int queryBatteryLevel();
 bool queryBatteryCharging();
 float queryBatteryVoltage();
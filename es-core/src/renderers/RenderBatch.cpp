@@ -0,0 +1,105 @@
+#include "renderers/RenderBatch.h"
+
+namespace Renderer
+{
+	RenderBatch::RenderBatch()
+	{
+		mState.texture = 0;
+		mState.srcBlendFactor = Blend::SRC_ALPHA;
+		mState.dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA;
+
+		mVertices.reserve(4096);
+
+	} // RenderBatch
+
+	void RenderBatch::add(const State& _state, const Transform4x4f& _matrix, const Vertex* _vertices, const unsigned int _numVertices)
+	{
+		if (_numVertices < 3)
+			return;
+
+		mState = _state;
+
+		const float* tm = (const float*)&_matrix;
+
+		// Same rounding as setMatrix()
+		const float tx = (float)(int)(tm[12] + 0.5f);
+		const float ty = (float)(int)(tm[13] + 0.5f);
+
+		size_t first = mVertices.size();
+		mVertices.resize(first + (_numVertices - 2) * 3);
+
+		Vertex* dst = &mVertices[first];
+		Vertex* begin = dst;
+
+		// Unroll the strip into independent triangles so consecutive strips can be merged
+		for (unsigned int i = 2; i < _numVertices; ++i)
+		{
+			const Vertex* tri[3] = { &_vertices[i - 2], &_vertices[i - 1], &_vertices[i] };
+
+			// Skip the degenerate triangles used to chain quads in a strip (fonts, ninepatches)
+			if (tri[0]->pos == tri[1]->pos || tri[1]->pos == tri[2]->pos || tri[0]->pos == tri[2]->pos)
+				continue;
+
+			for (int j = 0; j < 3; ++j)
+			{
+				const Vertex& src = *tri[j];
+
+				dst->pos = Vector2f(tm[0] * src.pos.x() + tm[4] * src.pos.y() + tx, tm[1] * src.pos.x() + tm[5] * src.pos.y() + ty);
+				dst->tex = src.tex;
+				dst->col = src.col;
+				++dst;
+			}
+		}
+
+		mVertices.resize(first + (dst - begin));
+
+	} // add
+
+	void RenderBatch::clear()
+	{
+		// Keep the capacity for the next frame
+		mVertices.clear();
+
+	} // clear
+
+	namespace Stats
+	{
+		static FrameStats currentFrame = { 0, 0, 0, 0, 0 };
+		static FrameStats lastFrame    = { 0, 0, 0, 0, 0 };
+
+		void addPrimitive()
+		{
+			currentFrame.primitives++;
+
+		} // addPrimitive
+
+		void addDrawCall(const unsigned int _numVertices)
+		{
+			currentFrame.drawCalls++;
+			currentFrame.vertices += _numVertices;
+
+		} // addDrawCall
+
+		void addTextureUpload(const size_t _bytes)
+		{
+			currentFrame.textureUploads++;
+			currentFrame.uploadedBytes += (unsigned int)_bytes;
+
+		} // addTextureUpload
+
+		void endFrame()
+		{
+			lastFrame = currentFrame;
+			currentFrame = { 0, 0, 0, 0, 0 };
+
+		} // endFrame
+
+	} // Stats::
+
+	const FrameStats& getFrameStats()
+	{
+		return Stats::lastFrame;
+
+	} // getFrameStats
+
+} // Renderer::
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef ES_CORE_RENDERER_RENDER_BATCH_H
+#define ES_CORE_RENDERER_RENDER_BATCH_H
+
+#include "renderers/Renderer.h"
+#include "math/Transform4x4f.h"
+#include <vector>
+
+namespace Renderer
+{
+	// Accumulates triangle strips sharing the same texture & blend state into a single triangle list.
+	// Vertices are transformed on the CPU, so primitives drawn with different matrices still end up in the same batch.
+	// The vertex storage is kept between frames : once warmed up, batching does no allocation.
+	class RenderBatch
+	{
+	public:
+		struct State
+		{
+			unsigned int  texture;
+			Blend::Factor srcBlendFactor;
+			Blend::Factor dstBlendFactor;
+
+			bool operator==(const State& _other) const { return texture == _other.texture && srcBlendFactor == _other.srcBlendFactor && dstBlendFactor == _other.dstBlendFactor; }
+			bool operator!=(const State& _other) const { return !(*this == _other); }
+		};
+
+		RenderBatch();
+
+		// Returns false if the batch must be flushed first (different state)
+		bool canAdd(const State& _state) const { return mVertices.empty() || _state == mState; }
+		void add   (const State& _state, const Transform4x4f& _matrix, const Vertex* _vertices, const unsigned int _numVertices);
+		void clear ();
+
+		inline bool                       empty   () const { return mVertices.empty(); }
+		inline const State&               getState() const { return mState; }
+		inline const std::vector<Vertex>& getVertices() const { return mVertices; }
+
+	private:
+		State               mState;
+		std::vector<Vertex> mVertices;
+
+	}; // RenderBatch
+
+	namespace Stats
+	{
+		void addPrimitive();                            // one drawTriangleStrips / drawLines request
+		void addDrawCall (const unsigned int _numVertices); // one draw actually issued to the GPU
+		void addTextureUpload(const size_t _bytes);
+		void endFrame    ();
+
+	} // Stats::
+
+} // Renderer::
+
+#endif // ES_CORE_RENDERER_RENDER_BATCH_H
@@ -10,7 +10,9 @@
 #include <SDL.h>
 #include <stack>
 
+#if !defined(USE_NULL_RENDERER)
 #include <go2/display.h>
+#endif
 
 namespace Renderer
 {
@@ -46,9 +48,15 @@ namespace Renderer
 			return false;
 		}
 
+#if defined(USE_NULL_RENDERER)
+		// headless : no display to query
+		windowWidth = Settings::getInstance()->getInt("WindowWidth") > 0 ? Settings::getInstance()->getInt("WindowWidth") : 640;
+		windowHeight = Settings::getInstance()->getInt("WindowHeight") > 0 ? Settings::getInstance()->getInt("WindowHeight") : 480;
+#else
 		display = go2_display_create();
 		windowWidth = go2_display_height_get(display);
 		windowHeight = go2_display_width_get(display);
+#endif
 		screenWidth = windowWidth;
 		if (Renderer::isFullScreenMode())
 		{
@@ -74,7 +82,9 @@ namespace Renderer
 	static void destroyWindow()
 	{
 		destroyContext();
+#if !defined(USE_NULL_RENDERER)
 		go2_display_destroy(display);
+#endif
 		display = nullptr;
 
 		SDL_Quit();
@@ -291,6 +301,19 @@ namespace Renderer
 
 	go2_display_t* getDisplay()    { return display; }
 
+	size_t getTextureDataSize(const Texture::Type _type, const unsigned int _width, const unsigned int _height)
+	{
+		switch (_type)
+		{
+			case Texture::ALPHA:    { return (size_t)_width * _height;     } break;
+			case Texture::RGB565:
+			case Texture::RGBA4444: { return (size_t)_width * _height * 2; } break;
+			case Texture::ETC1:     { return (size_t)((_width + 3) / 4) * ((_height + 3) / 4) * 8; } break;
+			default:                { return (size_t)_width * _height * 4; }
+		}
+
+	} // getTextureDataSize
+
 	bool        isSmallScreen()    { return screenWidth < 400 || screenHeight < 400; };
 
 	bool        isFullScreenMode()    { return mFullScreenMode; };
@@ -3,6 +3,7 @@
 #define ES_CORE_RENDERER_RENDERER_H
 
 #include "math/Vector2f.h"
+#include <stddef.h>
 
 class  Transform4x4f;
 class  Vector2i;
@@ -34,8 +35,11 @@ namespace Renderer
 	{
 		enum Type
 		{
-			RGBA  = 0,
-			ALPHA = 1
+			RGBA     = 0,
+			ALPHA    = 1,
+			RGB565   = 2, // 16 bit, opaque
+			RGBA4444 = 3, // 16 bit, with alpha
+			ETC1     = 4  // compressed 4x4 blocks, opaque. Requires GL_OES_compressed_ETC1_RGB8_texture
 
 		}; // Type
 
@@ -63,6 +67,16 @@ namespace Renderer
 
 	}; // Vertex
 
+	struct FrameStats
+	{
+		unsigned int drawCalls;  // draws issued to the GPU
+		unsigned int primitives; // drawTriangleStrips / drawLines requests
+		unsigned int vertices;
+		unsigned int textureUploads; // createTexture / updateTexture with pixel data
+		unsigned int uploadedBytes;
+
+	}; // FrameStats
+
 	bool        init            (bool forceFullScreen = false);
 	void        deinit          ();
 	void        pushClipRect    (const Vector2i& _pos, const Vector2i& _size);
@@ -79,6 +93,8 @@ namespace Renderer
 	int         getScreenOffsetY();
 	int         getScreenRotate ();
 	go2_display_t* getDisplay();
+	const FrameStats& getFrameStats(); // of the last presented frame
+	size_t      getTextureDataSize(const Texture::Type _type, const unsigned int _width, const unsigned int _height); // bytes of pixel data for a texture of this type
 
 	// API specific
 	unsigned int convertColor      (const unsigned int _color);
@@ -86,6 +102,7 @@ namespace Renderer
 	void         setupWindow       ();
 	void         createContext     ();
 	void         destroyContext    ();
+	bool         isTextureTypeSupported(const Texture::Type _type);
 	unsigned int createTexture     (const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data);
 	void         destroyTexture    (const unsigned int _texture);
 	void         updateTexture     (const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data);
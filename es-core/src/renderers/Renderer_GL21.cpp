@@ -1,18 +1,28 @@
-#if defined(USE_OPENGL_21)
+#if defined(USE_OPENGL_21) && !defined(USE_NULL_RENDERER)
 
 #include "renderers/Renderer.h"
+#include "renderers/RenderBatch.h"
 #include "math/Transform4x4f.h"
 #include "Log.h"
 #include "Settings.h"
 
 #include <SDL_opengl.h>
 #include <SDL.h>
+#include <string.h>
 #include <vector>
 
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+
 namespace Renderer
 {
 	static SDL_GLContext sdlContext = nullptr;
 
+	// Last modelview matrix given to setMatrix : loading the same one again is skipped
+	static Transform4x4f currentMatrix;
+	static bool          currentMatrixValid = false;
+
 	static GLenum convertBlendFactor(const Blend::Factor _blendFactor)
 	{
 		switch(_blendFactor)
@@ -36,13 +46,41 @@ namespace Renderer
 	{
 		switch(_type)
 		{
-			case Texture::RGBA:  { return GL_RGBA;  } break;
-			case Texture::ALPHA: { return GL_ALPHA; } break;
-			default:             { return GL_ZERO;  }
+			case Texture::RGBA:     { return GL_RGBA;             } break;
+			case Texture::ALPHA:    { return GL_ALPHA;            } break;
+			case Texture::RGB565:   { return GL_RGB;              } break;
+			case Texture::RGBA4444: { return GL_RGBA;             } break;
+			case Texture::ETC1:     { return GL_ETC1_RGB8_OES;    } break;
+			default:                { return GL_ZERO;             }
 		}
 
 	} // convertTextureType
 
+	static GLenum convertTextureDataType(const Texture::Type _type)
+	{
+		switch(_type)
+		{
+			case Texture::RGB565:   { return GL_UNSIGNED_SHORT_5_6_5;   } break;
+			case Texture::RGBA4444: { return GL_UNSIGNED_SHORT_4_4_4_4; } break;
+			default:                { return GL_UNSIGNED_BYTE;          }
+		}
+
+	} // convertTextureDataType
+
+	static void uploadTexture(const Texture::Type _type, const unsigned int _width, const unsigned int _height, void* _data)
+	{
+		const GLenum type = convertTextureType(_type);
+
+		if (_type == Texture::ETC1)
+			glCompressedTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, (GLsizei)getTextureDataSize(_type, _width, _height), _data);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, convertTextureDataType(_type), _data);
+
+		if (_data != nullptr)
+			Stats::addTextureUpload(getTextureDataSize(_type, _width, _height));
+
+	} // uploadTexture
+
 	unsigned int convertColor(const unsigned int _color)
 	{
 		// convert from rgba to abgr
@@ -83,6 +121,7 @@ namespace Renderer
 	{
 		sdlContext = SDL_GL_CreateContext(getSDLWindow());
 		SDL_GL_MakeCurrent(getSDLWindow(), sdlContext);
+		currentMatrixValid = false;
 
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
@@ -99,9 +138,15 @@ namespace Renderer
 
 	} // destroyContext
 
+	bool isTextureTypeSupported(const Texture::Type _type)
+	{
+		// ETC1 is an OpenGL ES format
+		return _type != Texture::ETC1;
+
+	} // isTextureTypeSupported
+
 	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data)
 	{
-		const GLenum type = convertTextureType(_type);
 		unsigned int texture;
 
 		glGenTextures(1, &texture);
@@ -116,7 +161,7 @@ namespace Renderer
 		glPixelStorei(GL_PACK_ALIGNMENT, 1);
 		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-		glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data);
+		uploadTexture(_type, _width, _height, _data);
 
 		return texture;
 
@@ -132,13 +177,14 @@ namespace Renderer
 	{
 		bindTexture(_texture);
 
-		if (_x == -1 && _y == -1)
+		// Compressed textures can only be replaced as a whole
+		if ((_x == -1 && _y == -1) || _type == Texture::ETC1)
+			uploadTexture(_type, _width, _height, _data);
+		else
 		{
-			const GLenum type = convertTextureType(_type);
-			glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), convertTextureDataType(_type), _data);
+			Stats::addTextureUpload(getTextureDataSize(_type, _width, _height));
 		}
-		else
-			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), GL_UNSIGNED_BYTE, _data);
 
 		bindTexture(0);
 
@@ -168,6 +214,9 @@ namespace Renderer
 
 		glDrawArrays(GL_LINES, 0, _numVertices);
 
+		Stats::addPrimitive();
+		Stats::addDrawCall(_numVertices);
+
 		glDisableClientState(GL_COLOR_ARRAY);
 		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 		glDisableClientState(GL_VERTEX_ARRAY);
@@ -191,6 +240,9 @@ namespace Renderer
 
 		glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices);
 
+		Stats::addPrimitive();
+		Stats::addDrawCall(_numVertices);
+
 		glDisableClientState(GL_COLOR_ARRAY);
 		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 		glDisableClientState(GL_VERTEX_ARRAY);
@@ -203,11 +255,18 @@ namespace Renderer
 	{
 		glMatrixMode(GL_PROJECTION);
 		glLoadMatrixf((GLfloat*)&_projection);
+		glMatrixMode(GL_MODELVIEW);
 
 	} // setProjection
 
 	void setMatrix(const Transform4x4f& _matrix)
 	{
+		if (currentMatrixValid && memcmp(&currentMatrix, &_matrix, sizeof(Transform4x4f)) == 0)
+			return;
+
+		currentMatrix = _matrix;
+		currentMatrixValid = true;
+
 		Transform4x4f matrix = _matrix;
 		matrix.round();
 		glMatrixMode(GL_MODELVIEW);
@@ -264,6 +323,7 @@ namespace Renderer
 	void swapBuffers()
 	{
 		SDL_GL_SwapWindow(getSDLWindow());
+		Stats::endFrame();
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -1,15 +1,16 @@
-#if defined(USE_OPENGLES_10)
+#if defined(USE_OPENGLES_10) && !defined(USE_NULL_RENDERER)
 
 #include "renderers/Renderer.h"
+#include "renderers/RenderBatch.h"
 #include "Log.h"
 #include "Settings.h"
+#include "SensorService.h"
 #include "math/Transform4x4f.h"
 
 #include <GLES/gl.h>
 #include <SDL.h>
+#include <algorithm>
 #include <vector>
-#include <unistd.h>
-#include <fcntl.h>
 
 #include <go2/display.h>
 #include <go2/input.h>
@@ -26,8 +27,13 @@
 
 static go2_input_t* input = nullptr;
 static go2_surface_t* titlebarSurface = nullptr;
+static int titlebarState = -1;
 static unsigned int frame = 0;
 
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+
 namespace Renderer
 {
 	//static SDL_GLContext sdlContext = nullptr;
@@ -35,6 +41,24 @@ namespace Renderer
 	static go2_context_t* context = nullptr;
 	static go2_presenter_t* presenter = nullptr;
 
+	static RenderBatch    batch;
+	static Transform4x4f  currentMatrix  = Transform4x4f::Identity();
+	static unsigned int   currentTexture = 0;
+
+	// GL state cache, avoids redundant state changes. -1 = unknown
+	static int            boundTexture   = -1;
+	static int            textureEnabled = -1;
+	static int            blendEnabled   = -1;
+	static GLenum         blendSrc       = 0;
+	static GLenum         blendDst       = 0;
+	static bool           clientStates   = false;
+	static const Vertex*  vertexPointer  = nullptr;
+
+	enum ModelView { MODELVIEW_UNKNOWN, MODELVIEW_IDENTITY, MODELVIEW_CURRENT };
+	static ModelView      modelView      = MODELVIEW_UNKNOWN;
+
+	static bool           etc1Supported  = false;
+
 	static GLenum convertBlendFactor(const Blend::Factor _blendFactor)
 	{
 		switch(_blendFactor)
@@ -58,13 +82,156 @@ namespace Renderer
 	{
 		switch(_type)
 		{
-			case Texture::RGBA:  { return GL_RGBA;  } break;
-			case Texture::ALPHA: { return GL_ALPHA; } break;
-			default:             { return GL_ZERO;  }
+			case Texture::RGBA:     { return GL_RGBA;             } break;
+			case Texture::ALPHA:    { return GL_ALPHA;            } break;
+			case Texture::RGB565:   { return GL_RGB;              } break;
+			case Texture::RGBA4444: { return GL_RGBA;             } break;
+			case Texture::ETC1:     { return GL_ETC1_RGB8_OES;    } break;
+			default:                { return GL_ZERO;             }
 		}
 
 	} // convertTextureType
 
+	static GLenum convertTextureDataType(const Texture::Type _type)
+	{
+		switch(_type)
+		{
+			case Texture::RGB565:   { return GL_UNSIGNED_SHORT_5_6_5;   } break;
+			case Texture::RGBA4444: { return GL_UNSIGNED_SHORT_4_4_4_4; } break;
+			default:                { return GL_UNSIGNED_BYTE;          }
+		}
+
+	} // convertTextureDataType
+
+	static void uploadTexture(const Texture::Type _type, const unsigned int _width, const unsigned int _height, void* _data)
+	{
+		const GLenum type = convertTextureType(_type);
+
+		if (_type == Texture::ETC1)
+			glCompressedTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, (GLsizei)getTextureDataSize(_type, _width, _height), _data);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, convertTextureDataType(_type), _data);
+
+		if (_data != nullptr)
+			Stats::addTextureUpload(getTextureDataSize(_type, _width, _height));
+
+	} // uploadTexture
+
+	static void resetStateCache()
+	{
+		boundTexture   = -1;
+		textureEnabled = -1;
+		blendEnabled   = -1;
+		blendSrc       = 0;
+		blendDst       = 0;
+		clientStates   = false;
+		vertexPointer  = nullptr;
+		modelView      = MODELVIEW_UNKNOWN;
+
+	} // resetStateCache
+
+	static void applyTexture(const unsigned int _texture)
+	{
+		if (boundTexture != (int)_texture)
+		{
+			glBindTexture(GL_TEXTURE_2D, _texture);
+			boundTexture = (int)_texture;
+		}
+
+		const int enabled = _texture != 0 ? 1 : 0;
+		if (textureEnabled != enabled)
+		{
+			if (enabled) glEnable(GL_TEXTURE_2D);
+			else         glDisable(GL_TEXTURE_2D);
+
+			textureEnabled = enabled;
+		}
+
+	} // applyTexture
+
+	static void applyBlend(const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if (blendEnabled != 1)
+		{
+			glEnable(GL_BLEND);
+			blendEnabled = 1;
+		}
+
+		const GLenum src = convertBlendFactor(_srcBlendFactor);
+		const GLenum dst = convertBlendFactor(_dstBlendFactor);
+
+		if (src != blendSrc || dst != blendDst)
+		{
+			glBlendFunc(src, dst);
+			blendSrc = src;
+			blendDst = dst;
+		}
+
+	} // applyBlend
+
+	static void applyModelView(const ModelView _modelView)
+	{
+		if (modelView == _modelView)
+			return;
+
+		glMatrixMode(GL_MODELVIEW);
+
+		if (_modelView == MODELVIEW_IDENTITY)
+			glLoadIdentity();
+		else
+		{
+			Transform4x4f matrix = currentMatrix;
+			matrix.round();
+			glLoadMatrixf((GLfloat*)&matrix);
+		}
+
+		modelView = _modelView;
+
+	} // applyModelView
+
+	static void applyVertices(const Vertex* _vertices)
+	{
+		if (!clientStates)
+		{
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			glEnableClientState(GL_COLOR_ARRAY);
+			clientStates = true;
+		}
+
+		if (vertexPointer != _vertices)
+		{
+			glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
+			glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
+			glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+			vertexPointer = _vertices;
+		}
+
+	} // applyVertices
+
+	static void flushBatch()
+	{
+		if (batch.empty())
+			return;
+
+		const RenderBatch::State& state = batch.getState();
+		const std::vector<Vertex>& vertices = batch.getVertices();
+
+		applyTexture(state.texture);
+		applyBlend(state.srcBlendFactor, state.dstBlendFactor);
+		applyModelView(MODELVIEW_IDENTITY);
+
+		// The batch storage may have been reallocated since last frame
+		vertexPointer = nullptr;
+		applyVertices(vertices.data());
+
+		glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+		Stats::addDrawCall(vertices.size());
+
+		batch.clear();
+
+	} // flushBatch
+
 	unsigned int convertColor(const unsigned int _color)
 	{
 		// convert from rgba to abgr
@@ -110,6 +277,8 @@ namespace Renderer
 		if (!Renderer::isFullScreenMode())
 			titlebarSurface = go2_surface_create(display, w, 16, DRM_FORMAT_RGB565);
 
+		titlebarState = -1;
+
 		context = go2_context_create(display, w, h, &attr);
 		go2_context_make_current(context);
 
@@ -121,12 +290,20 @@ namespace Renderer
 		LOG(LogInfo) << "Renderer_GLES10::createContext() - Checking available OpenGL extensions...";
 		LOG(LogInfo) << "Renderer_GLES10::createContext() - ARB_texture_non_power_of_two: " << (glExts.find("ARB_texture_non_power_of_two") != std::string::npos ? "ok" : "MISSING");
 
+		etc1Supported = glExts.find("GL_OES_compressed_ETC1_RGB8_texture") != std::string::npos;
+		LOG(LogInfo) << "Renderer_GLES10::createContext() - OES_compressed_ETC1_RGB8_texture: " << (etc1Supported ? "ok" : "MISSING");
+
+		resetStateCache();
+
 	} // createContext
 
 	void destroyContext()
 	{
 		//SDL_GL_DeleteContext(sdlContext);
 		//sdlContext = nullptr;
+		batch.clear();
+		resetStateCache();
+
 		go2_context_destroy(context);
 		context = nullptr;
 
@@ -143,13 +320,20 @@ namespace Renderer
 		input = nullptr;
 	} // destroyContext
 
+	bool isTextureTypeSupported(const Texture::Type _type)
+	{
+		return _type != Texture::ETC1 || etc1Supported;
+
+	} // isTextureTypeSupported
+
 	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data)
 	{
-		const GLenum type = convertTextureType(_type);
 		unsigned int texture;
 
+		flushBatch();
+
 		glGenTextures(1, &texture);
-		bindTexture(texture);
+		applyTexture(texture);
 
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
@@ -160,7 +344,7 @@ namespace Renderer
 		glPixelStorei(GL_PACK_ALIGNMENT, 1);
 		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-		glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data);
+		uploadTexture(_type, _width, _height, _data);
 
 		return texture;
 
@@ -168,21 +352,31 @@ namespace Renderer
 
 	void destroyTexture(const unsigned int _texture)
 	{
+		// The pending batch may reference it
+		if (!batch.empty() && batch.getState().texture == _texture)
+			flushBatch();
+
 		glDeleteTextures(1, &_texture);
 
+		// Deleting the bound texture reverts the binding to 0
+		if (boundTexture == (int)_texture)
+			boundTexture = 0;
+
 	} // destroyTexture
 
 	void updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data)
 	{
-		bindTexture(_texture);
+		flushBatch();
+		applyTexture(_texture);
 
-		if (_x == -1 && _y == -1)
+		// Compressed textures can only be replaced as a whole
+		if ((_x == -1 && _y == -1) || _type == Texture::ETC1)
+			uploadTexture(_type, _width, _height, _data);
+		else
 		{
-			const GLenum type = convertTextureType(_type);
-			glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), convertTextureDataType(_type), _data);
+			Stats::addTextureUpload(getTextureDataSize(_type, _width, _height));
 		}
-		else
-			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), GL_UNSIGNED_BYTE, _data);
 
 		bindTexture(0);
 
@@ -190,61 +384,49 @@ namespace Renderer
 
 	void bindTexture(const unsigned int _texture)
 	{
-		glBindTexture(GL_TEXTURE_2D, _texture);
-
-		if(_texture == 0) glDisable(GL_TEXTURE_2D);
-		else              glEnable(GL_TEXTURE_2D);
+		// Applied when the primitives using it are flushed
+		currentTexture = _texture;
 
 	} // bindTexture
 
 	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
+		flushBatch();
 
-		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
-		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+		applyTexture(currentTexture);
+		applyBlend(_srcBlendFactor, _dstBlendFactor);
+		applyModelView(MODELVIEW_CURRENT);
+		applyVertices(_vertices);
 
 		glDrawArrays(GL_LINES, 0, _numVertices);
 
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
+		// Client memory may be reused by the caller
+		vertexPointer = nullptr;
 
-		glDisable(GL_BLEND);
+		Stats::addPrimitive();
+		Stats::addDrawCall(_numVertices);
 
 	} // drawLines
 
 	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
-		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
-
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices);
+		RenderBatch::State state;
+		state.texture = currentTexture;
+		state.srcBlendFactor = _srcBlendFactor;
+		state.dstBlendFactor = _dstBlendFactor;
 
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
+		if (!batch.canAdd(state))
+			flushBatch();
 
-		glDisable(GL_BLEND);
+		batch.add(state, currentMatrix, _vertices, _numVertices);
+		Stats::addPrimitive();
 
 	} // drawTriangleStrips
 
 	void setProjection(const Transform4x4f& _projection)
 	{
+		flushBatch();
+
 		glMatrixMode(GL_PROJECTION);
 		glLoadMatrixf((GLfloat*)&_projection);
 
@@ -252,15 +434,18 @@ namespace Renderer
 
 	void setMatrix(const Transform4x4f& _matrix)
 	{
-		Transform4x4f matrix = _matrix;
-		matrix.round();
-		glMatrixMode(GL_MODELVIEW);
-		glLoadMatrixf((GLfloat*)&matrix);
+		// Batched vertices are transformed on the CPU, the GL matrix is only loaded for unbatched draws
+		currentMatrix = _matrix;
+
+		if (modelView == MODELVIEW_CURRENT)
+			modelView = MODELVIEW_UNKNOWN;
 
 	} // setMatrix
 
 	void setViewport(const Rect& _viewport)
 	{
+		flushBatch();
+
 		// glViewport starts at the bottom left of the window
 		glViewport( _viewport.x, getWindowHeight() - _viewport.y - _viewport.h, _viewport.w, _viewport.h);
 
@@ -268,6 +453,8 @@ namespace Renderer
 
 	void setScissor(const Rect& _scissor)
 	{
+		flushBatch();
+
 		if((_scissor.x == 0) && (_scissor.y == 0) && (_scissor.w == 0) && (_scissor.h == 0))
 		{
 			glDisable(GL_SCISSOR_TEST);
@@ -285,10 +472,77 @@ namespace Renderer
 	{
 	} // setSwapInterval
 
+	// Icon strips hold 16px high icons : 0 = empty, then one icon per 5%
+	static int getLevelIconIndex(const int _level)
+	{
+		if (_level <= 0)
+			return 0;
+
+		return std::min(20, (_level + 4) / 5);
+
+	} // getLevelIconIndex
+
+	static void blitTitlebarIcon(const uint8_t* _src, const int _srcStride, const int _index, const int _x, const int _width)
+	{
+		const uint8_t* src = _src + (_index * 16 * _srcStride);
+
+		uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
+		int dst_stride = go2_surface_stride_get(titlebarSurface);
+
+		dst += _x * sizeof(short);
+
+		for (int y = 0; y < 16; ++y)
+		{
+			memcpy(dst, src, _width * sizeof(short));
+
+			src += _srcStride;
+			dst += dst_stride;
+		}
+
+	} // blitTitlebarIcon
+
+	static void updateTitlebar(const int _width)
+	{
+		// Values are sampled in background by the SensorService, no syscall here
+		SensorSnapshot sensors = SensorService::getInstance()->getSnapshot();
+
+		int batteryIndex    = sensors.batteryLevel == 1 ? 0 : std::max(1, getLevelIconIndex(sensors.batteryLevel));
+		int volumeIndex     = getLevelIconIndex(sensors.volume);
+		int brightnessIndex = getLevelIconIndex(sensors.brightness);
+
+		// Only redraw the titlebar surface when something changed
+		int state = batteryIndex | (volumeIndex << 5) | (brightnessIndex << 10) | (sensors.wifiConnected ? 1 << 15 : 0) | (sensors.acOnline ? 1 << 16 : 0);
+		if (state == titlebarState)
+			return;
+
+		titlebarState = state;
+
+		const int iconStride = 32 * sizeof(short);
+
+		blitTitlebarIcon(battery_image.pixel_data, iconStride, batteryIndex, _width - 32, 32);
+		blitTitlebarIcon(volume_image.pixel_data, iconStride, volumeIndex, 0, 32);
+		blitTitlebarIcon(header.pixel_data, header.width * sizeof(short), 0, (_width / 2) - (header.width / 2), header.width);
+		blitTitlebarIcon(brightness_image.pixel_data, iconStride, brightnessIndex, 64, 32);
+
+		if (sensors.wifiConnected)
+			blitTitlebarIcon(wifi_image.pixel_data, iconStride, 1, _width - 100, 32);
+		else
+			blitTitlebarIcon(blank_image.pixel_data, iconStride, 1, _width - 100, 32);
+
+		if (sensors.acOnline)
+			blitTitlebarIcon(power_image.pixel_data, iconStride, 1, _width - 65, 32);
+		else
+			blitTitlebarIcon(blank_image.pixel_data, iconStride, 1, _width - 65, 32);
+
+	} // updateTitlebar
+
 	void swapBuffers()
 	{
 		//SDL_GL_SwapWindow(getSDLWindow());
 
+		flushBatch();
+		Stats::endFrame();
+
 		if (context)
 		{
 			go2_display_t* display = getDisplay();
@@ -296,496 +550,7 @@ namespace Renderer
 			int h = go2_display_width_get(display);
 
 			if (!Renderer::isFullScreenMode())
-			{
-				{
-					// Battery level
-					const uint8_t* src = battery_image.pixel_data;
-					int src_stride = 32 * sizeof(short);
-
-					uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-					int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-					int batcapacity = 0;
-					int fd;
-					char buffer[10];
-					fd = open("/sys/class/power_supply/battery/capacity", O_RDONLY);
-					if (fd > 0)
-					{
-						memset(buffer, 0, 10);
-						ssize_t count = read(fd, buffer, 10);
-						if( count > 0 )
-						{
-							batcapacity = atoi(buffer);
-						}
-						close(fd);
-					}
-
-					int batteryIndex;
-					if (batcapacity == 1)
-					{
-						batteryIndex = 0;
-					}
-					else if (batcapacity <= 5)
-					{
-						batteryIndex = 1;
-					}
-					else if (batcapacity <= 10)
-					{
-						batteryIndex = 2;
-					}
-					else if (batcapacity <= 15)
-					{
-						batteryIndex = 3;
-					}
-					else if (batcapacity <= 20)
-					{
-						batteryIndex = 4;
-					}
-					else if (batcapacity <= 25)
-					{
-						batteryIndex = 5;
-					}
-					else if (batcapacity <= 30)
-					{
-						batteryIndex = 6;
-					}
-					else if (batcapacity <= 35)
-					{
-						batteryIndex = 7;
-					}
-					else if (batcapacity <= 40)
-					{
-						batteryIndex = 8;
-					}
-					else if (batcapacity <= 45)
-					{
-						batteryIndex = 9;
-					}
-					else if (batcapacity <= 50)
-					{
-						batteryIndex = 10;
-					}
-					else if (batcapacity <= 55)
-					{
-						batteryIndex = 11;
-					}
-					else if (batcapacity <= 60)
-					{
-						batteryIndex = 12;
-					}
-					else if (batcapacity <= 65)
-					{
-						batteryIndex = 13;
-					}
-					else if (batcapacity <= 70)
-					{
-						batteryIndex = 14;
-					}
-					else if (batcapacity <= 75)
-					{
-						batteryIndex = 15;
-					}
-					else if (batcapacity <= 80)
-					{
-						batteryIndex = 16;
-					}
-					else if (batcapacity <= 85)
-					{
-						batteryIndex = 17;
-					}
-					else if (batcapacity <= 90)
-					{
-						batteryIndex = 18;
-					}
-					else if (batcapacity <= 95)
-					{
-						batteryIndex = 19;
-					}
-					else if (batcapacity == 100)
-					{
-						batteryIndex = 20;
-					}
-					else
-					{
-						batteryIndex = 20;
-					}
-
-					src += (batteryIndex * 16 * src_stride);
-					dst += (w - 32) * sizeof(short);
-
-					for (int y = 0; y < 16; ++y)
-					{
-						memcpy(dst, src, 32 * sizeof(short));
-
-						src += src_stride;
-						dst += dst_stride;
-					}
-				} // Battery level END
-
-				{
-					// Volume level
-					const uint8_t* src = volume_image.pixel_data;
-					int src_stride = 32 * sizeof(short);
-
-					uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-					int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-					uint32_t volume = go2_audio_volume_get(NULL);
-
-					int volumeIndex;
-					if (volume == 0)
-					{
-						volumeIndex = 0;
-					}
-					else if (volume <= 5)
-					{
-						volumeIndex = 1;
-					}
-					else if (volume <= 10)
-					{
-						volumeIndex = 2;
-					}
-					else if (volume <= 15)
-					{
-						volumeIndex = 3;
-					}
-					else if (volume <= 20)
-					{
-						volumeIndex = 4;
-					}
-					else if (volume <= 25)
-					{
-						volumeIndex = 5;
-					}
-					else if (volume <= 30)
-					{
-						volumeIndex = 6;
-					}
-					else if (volume <= 35)
-					{
-						volumeIndex = 7;
-					}
-					else if (volume <= 40)
-					{
-						volumeIndex = 8;
-					}
-					else if (volume <= 45)
-					{
-						volumeIndex = 9;
-					}
-					else if (volume <= 50)
-					{
-						volumeIndex = 10;
-					}
-					else if (volume <= 55)
-					{
-						volumeIndex = 11;
-					}
-					else if (volume <= 60)
-					{
-						volumeIndex = 12;
-					}
-					else if (volume <= 65)
-					{
-						volumeIndex = 13;
-					}
-					else if (volume <= 70)
-					{
-						volumeIndex = 14;
-					}
-					else if (volume <= 75)
-					{
-						volumeIndex = 15;
-					}
-					else if (volume <= 80)
-					{
-						volumeIndex = 16;
-					}
-					else if (volume <= 85)
-					{
-						volumeIndex = 17;
-					}
-					else if (volume <= 90)
-					{
-						volumeIndex = 18;
-					}
-					else if (volume <= 95)
-					{
-						volumeIndex = 19;
-					}
-					else if (volume = 100)
-					{
-						volumeIndex = 20;
-					}
-					else
-					{
-						volumeIndex = 20;
-					}
-
-					src += (volumeIndex * 16 * src_stride);
-					//dst += (480 - 32) * sizeof(short);
-
-					for (int y = 0; y < 16; ++y)
-					{
-						memcpy(dst, src, 32 * sizeof(short));
-
-						src += src_stride;
-						dst += dst_stride;
-					}
-				} // Volume level END
-				{
-					// Title
-					const uint8_t* src = header.pixel_data;
-					int src_stride = header.width * sizeof(short);
-
-					uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-					int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-					dst += ((w / 2) - (header.width / 2)) * sizeof(short);
-
-					for (int y = 0; y < 16; ++y)
-					{
-						memcpy(dst, src, src_stride);
-
-						src += src_stride;
-						dst += dst_stride;
-					}
-				} // Title END
-				{
-					// Brightness level
-					const uint8_t* src = brightness_image.pixel_data;
-					int src_stride = 32 * sizeof(short);
-
-					uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-					int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-					int brightnessIndex = 0;
-					int brightness = 50;
-
-					try {
-						brightness = (int) go2_display_backlight_get(NULL);
-					} catch (...) {}
-
-					if (brightness == 0)
-					{
-						brightnessIndex = 0;
-					}
-					else if (brightness <= 5)
-					{
-						brightnessIndex = 1;
-					}
-					else if (brightness <= 10)
-					{
-						brightnessIndex = 2;
-					}
-					else if (brightness <= 15)
-					{
-						brightnessIndex = 3;
-					}
-					else if (brightness <= 20)
-					{
-						brightnessIndex = 4;
-					}
-					else if (brightness <= 25)
-					{
-						brightnessIndex = 5;
-					}
-					else if (brightness <= 30)
-					{
-						brightnessIndex = 6;
-					}
-					else if (brightness <= 35)
-					{
-						brightnessIndex = 7;
-					}
-					else if (brightness <= 40)
-					{
-						brightnessIndex = 8;
-					}
-					else if (brightness <= 45)
-					{
-						brightnessIndex = 9;
-					}
-					else if (brightness <= 50)
-					{
-						brightnessIndex = 10;
-					}
-					else if (brightness <= 55)
-					{
-						brightnessIndex = 11;
-					}
-					else if (brightness <= 60)
-					{
-						brightnessIndex = 12;
-					}
-					else if (brightness <= 65)
-					{
-						brightnessIndex = 13;
-					}
-					else if (brightness <= 70)
-					{
-						brightnessIndex = 14;
-					}
-					else if (brightness <= 75)
-					{
-						brightnessIndex = 15;
-					}
-					else if (brightness <= 80)
-					{
-						brightnessIndex = 16;
-					}
-					else if (brightness <= 85)
-					{
-						brightnessIndex = 17;
-					}
-					else if (brightness <= 90)
-					{
-						brightnessIndex = 18;
-					}
-					else if (brightness <= 95)
-					{
-						brightnessIndex = 19;
-					}
-					else if (brightness = 100)
-					{
-						brightnessIndex = 20;
-					}
-					else
-					{
-						brightnessIndex = 20;
-					}
-
-					src += (brightnessIndex * 16 * src_stride);
-					dst += (64) * sizeof(short);
-
-					for (int y = 0; y < 16; ++y)
-					{
-						memcpy(dst, src, 32 * sizeof(short));
-
-						src += src_stride;
-						dst += dst_stride;
-					}
-				} // Brightness level END
-
-				{
-
-					// WIFI ICONS
-					const uint8_t* src = wifi_image.pixel_data;
-					int src_stride = 32 * sizeof(short);
-
-					uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-					int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-					int wifiIndex = 0;
-
-					// Wifi
-					int fd;
-					char buffer[10];
-					fd = open("/sys/class/net/wlan0/operstate", O_RDONLY);
-					if (fd > 0)
-					{
-						memset(buffer, 0, 10);
-						ssize_t count = read(fd, buffer, 10);
-						if( count > 0 )
-						{
-							if( strstr( buffer, "up") != NULL )
-								wifiIndex = 1;
-							else
-								wifiIndex = 0;
-						}
-						close(fd);
-					}
-					if( wifiIndex == 1 )
-					{
-						src += (wifiIndex* 16 * src_stride);
-						dst += (w - 100) * sizeof(short);
-
-						for (int y = 0; y < 16; ++y)
-						{
-							memcpy(dst, src, 32 * sizeof(short));
-
-							src += src_stride;
-							dst += dst_stride;
-						}
-
-					}
-					else
-					{
-						const uint8_t* src = blank_image.pixel_data;
-						src += (1 * 16 * src_stride);
-						dst += (w - 100) * sizeof(short);
-
-						for (int y = 0; y < 16; ++y)
-						{
-							memcpy(dst, src, 32 * sizeof(short));
-
-							src += src_stride;
-							dst += dst_stride;
-						}
-
-					}
-				}// WIFI ICONS END
-
-				{
-
-					// POWER ICON
-					const uint8_t* src = power_image.pixel_data;
-					int src_stride = 32 * sizeof(short);
-
-					uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-					int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-					int powerIndex = 0;
-
-					// Power
-					int fd;
-					char buffer[10];
-					fd = open("/sys/class/power_supply/ac/online", O_RDONLY);
-					if (fd > 0)
-					{
-						memset(buffer, 0, 10);
-						ssize_t count = read(fd, buffer, 10);
-						if( count > 0 )
-						{
-							if( strstr( buffer, "1") != 0 )
-								powerIndex = 1;
-							else
-								powerIndex = 0;
-						}
-						close(fd);
-					}
-					if( powerIndex == 1 )
-					{
-						src += (powerIndex * 16 * src_stride);
-						dst += (w - 65) * sizeof(short);
-
-						for (int y = 0; y < 16; ++y)
-						{
-							memcpy(dst, src, 32 * sizeof(short));
-
-							src += src_stride;
-							dst += dst_stride;
-						}
-
-					}
-					else
-					{
-						const uint8_t* src = blank_image.pixel_data;
-						src += (1 * 16 * src_stride);
-						dst += (w - 65) * sizeof(short);
-
-						for (int y = 0; y < 16; ++y)
-						{
-							memcpy(dst, src, 32 * sizeof(short));
-
-							src += src_stride;
-							dst += dst_stride;
-						}
-
-					}
-				} // POWER ICON - END
-
-			} // if (!Renderer::isFullScreenMode())
+				updateTitlebar(w);
 
 			go2_context_swap_buffers(context);
 			go2_surface_t* surface = go2_context_surface_lock(context);
@@ -848,37 +613,25 @@ namespace Renderer
 		drawGLRoundedCorner(x + width, y + height - radius, ES_PI / 2.0f, ES_PI / 2.0f, radius, finalColor, vertex);
 		drawGLRoundedCorner(x + radius, y + height, ES_PI, ES_PI / 2.0f, radius, finalColor, vertex);
 
-		Vertex* vxs = new Vertex[vertex.size()];
-		for (int i = 0; i < vertex.size(); i++)
-			vxs[i] = vertex[i];
-
-		bindTexture(0);
+		flushBatch();
 
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vxs[0].pos);
-		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vxs[0].tex);
-		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &vxs[0].col);
+		currentTexture = 0;
+		applyTexture(0);
+		applyBlend(_srcBlendFactor, _dstBlendFactor);
+		applyModelView(MODELVIEW_CURRENT);
+		applyVertices(vertex.data());
 
 		glDrawArrays(GL_TRIANGLE_FAN, 0, vertex.size());
 
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisable(GL_BLEND);
+		vertexPointer = nullptr;
 
-		delete[] vxs;	
+		Stats::addPrimitive();
+		Stats::addDrawCall(vertex.size());
 	}
 
 	void enableRoundCornerStencil(float x, float y, float width, float height, float radius)
 	{
-		bool tx = glIsEnabled(GL_TEXTURE_2D);
-		glDisable(GL_TEXTURE_2D);
+		flushBatch();
 
 		glClear(GL_DEPTH_BUFFER_BIT);
 		glEnable(GL_STENCIL_TEST);
@@ -897,13 +650,11 @@ namespace Renderer
 		glStencilMask(0x00);
 		glStencilFunc(GL_EQUAL, 0, 0xFF);
 		glStencilFunc(GL_EQUAL, 1, 0xFF);
-
-		if (tx)
-			glEnable(GL_TEXTURE_2D);
 	}
 
 	void disableStencil()
 	{
+		flushBatch();
 		glDisable(GL_STENCIL_TEST);
 	}
 } // Renderer::
@@ -0,0 +1,212 @@
+#if defined(USE_NULL_RENDERER)
+
+#include "renderers/Renderer.h"
+#include "renderers/RenderBatch.h"
+#include "Log.h"
+#include "math/Transform4x4f.h"
+
+#include <map>
+
+// Headless backend : nothing reaches a GPU, but primitives go through the same batching as Renderer_GLES10,
+// so the frame stats (draw calls, vertices, texture uploads) match what the device would issue.
+namespace Renderer
+{
+	static RenderBatch    batch;
+	static Transform4x4f  currentMatrix  = Transform4x4f::Identity();
+	static unsigned int   currentTexture = 0;
+
+	static std::map<unsigned int, size_t> textures;
+	static unsigned int   nextTexture    = 1;
+
+	static void flushBatch()
+	{
+		if (batch.empty())
+			return;
+
+		Stats::addDrawCall(batch.getVertices().size());
+		batch.clear();
+
+	} // flushBatch
+
+	unsigned int convertColor(const unsigned int _color)
+	{
+		return _color;
+
+	} // convertColor
+
+	unsigned int getWindowFlags()
+	{
+		return 0;
+
+	} // getWindowFlags
+
+	void setupWindow()
+	{
+	} // setupWindow
+
+	void createContext()
+	{
+		LOG(LogInfo) << "Renderer_Null::createContext() - Headless renderer, " << getWindowWidth() << "x" << getWindowHeight();
+
+		batch.clear();
+		currentTexture = 0;
+
+	} // createContext
+
+	void destroyContext()
+	{
+		if (!textures.empty())
+		{
+			LOG(LogDebug) << "Renderer_Null::destroyContext() - " << textures.size() << " textures still alive";
+		}
+
+		textures.clear();
+		batch.clear();
+
+	} // destroyContext
+
+	bool isTextureTypeSupported(const Texture::Type _type)
+	{
+		return _type != Texture::ETC1;
+
+	} // isTextureTypeSupported
+
+	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data)
+	{
+		flushBatch();
+
+		unsigned int texture = nextTexture++;
+		textures[texture] = getTextureDataSize(_type, _width, _height);
+
+		if (_data != nullptr)
+			Stats::addTextureUpload(textures[texture]);
+
+		return texture;
+
+	} // createTexture
+
+	void destroyTexture(const unsigned int _texture)
+	{
+		if (!batch.empty() && batch.getState().texture == _texture)
+			flushBatch();
+
+		if (textures.erase(_texture) == 0)
+		{
+			LOG(LogWarning) << "Renderer_Null::destroyTexture() - Unknown texture " << _texture;
+		}
+
+	} // destroyTexture
+
+	void updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data)
+	{
+		flushBatch();
+
+		auto it = textures.find(_texture);
+		if (it == textures.end())
+		{
+			LOG(LogWarning) << "Renderer_Null::updateTexture() - Unknown texture " << _texture;
+			return;
+		}
+
+		size_t size = getTextureDataSize(_type, _width, _height);
+		if ((_x == -1 && _y == -1) || _type == Texture::ETC1)
+			it->second = size;
+
+		if (_data != nullptr)
+			Stats::addTextureUpload(size);
+
+	} // updateTexture
+
+	void bindTexture(const unsigned int _texture)
+	{
+		currentTexture = _texture;
+
+	} // bindTexture
+
+	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		flushBatch();
+
+		Stats::addPrimitive();
+		Stats::addDrawCall(_numVertices);
+
+	} // drawLines
+
+	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		RenderBatch::State state;
+		state.texture = currentTexture;
+		state.srcBlendFactor = _srcBlendFactor;
+		state.dstBlendFactor = _dstBlendFactor;
+
+		if (!batch.canAdd(state))
+			flushBatch();
+
+		batch.add(state, currentMatrix, _vertices, _numVertices);
+		Stats::addPrimitive();
+
+	} // drawTriangleStrips
+
+	void setProjection(const Transform4x4f& _projection)
+	{
+		flushBatch();
+
+	} // setProjection
+
+	void setMatrix(const Transform4x4f& _matrix)
+	{
+		currentMatrix = _matrix;
+
+	} // setMatrix
+
+	void setViewport(const Rect& _viewport)
+	{
+		flushBatch();
+
+	} // setViewport
+
+	void setScissor(const Rect& _scissor)
+	{
+		flushBatch();
+
+	} // setScissor
+
+	void setSwapInterval()
+	{
+	} // setSwapInterval
+
+	void swapBuffers()
+	{
+		flushBatch();
+		Stats::endFrame();
+
+	} // swapBuffers
+
+#define ROUNDING_PIECES 8
+
+	void drawRoundRect(float x, float y, float width, float height, float radius, unsigned int color, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		// GLES10 draws it as one unbatched triangle fan, ROUNDING_PIECES segments per corner
+		flushBatch();
+
+		Stats::addPrimitive();
+		Stats::addDrawCall(4 * (ROUNDING_PIECES + 1));
+
+	} // drawRoundRect
+
+	void enableRoundCornerStencil(float x, float y, float width, float height, float radius)
+	{
+		flushBatch();
+		drawRoundRect(x, y, width, height, radius, 0xFFFFFFFF);
+
+	} // enableRoundCornerStencil
+
+	void disableStencil()
+	{
+		flushBatch();
+
+	} // disableStencil
+
+} // Renderer::
+
+#endif // USE_NULL_RENDERER
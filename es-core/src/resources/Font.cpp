@@ -1,15 +1,20 @@
 #include "resources/Font.h"
 
 #include "renderers/Renderer.h" 
+#include "resources/TextureDataManager.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <string.h>
 
 FT_Library Font::sLibrary = NULL;
 
 int Font::getSize() const { return mSize; }
 
 std::map< std::pair<std::string, int>, std::weak_ptr<Font> > Font::sFontMap;
+std::vector<std::unique_ptr<Font::FontTexture>> Font::sTextures;
 
 Font::FontFace::FontFace(ResourceData&& d, int size) : data(d)
 {
@@ -40,10 +45,12 @@ size_t Font::getMemUsage() const
 {
 	size_t memUsage = 0;
 	for(auto it = mTextures.cbegin(); it != mTextures.cend(); it++)
-		memUsage += it->textureSize.x() * it->textureSize.y() * 4;
+		memUsage += (*it)->textureSize.x() * (*it)->textureSize.y() / Math::max(1, (*it)->users); // shared with other fonts
 
+	// Mapped font files are shared & paged in on demand
 	for(auto it = mFaceCache.cbegin(); it != mFaceCache.cend(); it++)
-		memUsage += it->second->data.length;
+		if (!it->second->data.mapped)
+			memUsage += it->second->data.length;
 
 	return memUsage;
 }
@@ -106,7 +113,7 @@ Font::~Font()
 	for (auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend(); it++)
 		delete it->second;
 
-	unload();
+	releaseTextures();
 }
 
 void Font::reload()
@@ -150,18 +157,33 @@ std::shared_ptr<Font> Font::get(int size, const std::string& path)
 
 void Font::unloadTextures()
 {
-	for(auto it = mTextures.begin(); it != mTextures.end(); it++)
+	for(auto it = sTextures.begin(); it != sTextures.end(); it++)
+		(*it)->deinitTexture();
+}
+
+void Font::releaseTextures()
+{
+	for (auto tex : mTextures)
 	{
-		it->deinitTexture();
+		tex->users--;
+		if (tex->users > 0)
+			continue;
+
+		auto it = std::find_if(sTextures.begin(), sTextures.end(), [tex](const std::unique_ptr<FontTexture>& t) { return t.get() == tex; });
+		if (it != sTextures.end())
+			sTextures.erase(it);
 	}
+
+	mTextures.clear();
 }
 
 Font::FontTexture::FontTexture()
 {
 	textureId = 0;
 	textureSize = Vector2i(2048, 512);
-	writePos = Vector2i::Zero();
-	rowHeight = 0;
+	pixels.resize(textureSize.x() * textureSize.y(), 0);
+	skyline.push_back({ 0, 0, textureSize.x() });
+	users = 0;
 }
 
 Font::FontTexture::~FontTexture()
@@ -171,38 +193,121 @@ Font::FontTexture::~FontTexture()
 
 bool Font::FontTexture::findEmpty(const Vector2i& size, Vector2i& cursor_out)
 {
-	if (size.x() >= textureSize.x() || size.y() >= textureSize.y())
+	// blank glyphs (space...) take no room
+	if (size.x() == 0 || size.y() == 0)
+	{
+		cursor_out = Vector2i::Zero();
+		return true;
+	}
+
+	// leave 1px of space between glyphs
+	const int width = size.x() + 1;
+	const int height = size.y() + 1;
+
+	if (width > textureSize.x() || height > textureSize.y())
 		return false;
 
-	if(writePos.x() + size.x() >= textureSize.x() &&
-		writePos.y() + rowHeight + size.y() + 1 < textureSize.y())
+	// bottom-left rule : lowest resulting top edge, then the narrowest node
+	int bestIndex = -1;
+	int bestTop = textureSize.y() + 1;
+	int bestWidth = textureSize.x() + 1;
+	int bestY = 0;
+
+	for (int i = 0; i < (int)skyline.size(); i++)
 	{
-		// row full, but it should fit on the next row
-		// move cursor to next row
-		writePos = Vector2i(0, writePos.y() + rowHeight + 1); // leave 1px of space between glyphs
-		rowHeight = 0;
+		if (skyline[i].x + width > textureSize.x())
+			break;
+
+		// the glyph rests on the highest node it spans
+		int y = 0;
+		int remaining = width;
+		for (int j = i; remaining > 0 && j < (int)skyline.size(); j++)
+		{
+			y = Math::max(y, skyline[j].y);
+			remaining -= skyline[j].width;
+		}
+
+		int top = y + height;
+		if (top > textureSize.y())
+			continue;
+
+		if (top < bestTop || (top == bestTop && skyline[i].width < bestWidth))
+		{
+			bestIndex = i;
+			bestTop = top;
+			bestWidth = skyline[i].width;
+			bestY = y;
+		}
 	}
 
-	if(writePos.x() + size.x() >= textureSize.x() ||
-		writePos.y() + size.y() >= textureSize.y())
-	{
-		// nope, still won't fit
+	if (bestIndex < 0)
 		return false;
-	}
 
-	cursor_out = writePos;
-	writePos[0] += size.x() + 1; // leave 1px of space between glyphs
+	SkylineNode node = { skyline[bestIndex].x, bestTop, width };
+	skyline.insert(skyline.begin() + bestIndex, node);
 
-	if(size.y() > rowHeight)
-		rowHeight = size.y();
+	// shrink or remove the nodes now covered by the glyph
+	for (int i = bestIndex + 1; i < (int)skyline.size(); )
+	{
+		int overlap = node.x + node.width - skyline[i].x;
+		if (overlap <= 0)
+			break;
 
+		if (overlap < skyline[i].width)
+		{
+			skyline[i].x += overlap;
+			skyline[i].width -= overlap;
+			break;
+		}
+
+		skyline.erase(skyline.begin() + i);
+	}
+
+	// merge neighbours at the same height
+	for (int i = 0; i < (int)skyline.size() - 1; )
+	{
+		if (skyline[i].y == skyline[i + 1].y)
+		{
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else
+			i++;
+	}
+
+	cursor_out = Vector2i(node.x, bestY);
 	return true;
 }
 
+void Font::FontTexture::writeGlyph(const Vector2i& cursor, const Vector2i& size, const unsigned char* buffer, int pitch)
+{
+	if (size.x() == 0 || size.y() == 0 || buffer == nullptr)
+		return;
+
+	for (int y = 0; y < size.y(); y++)
+		memcpy(&pixels[(cursor.y() + y) * textureSize.x() + cursor.x()], buffer + y * pitch, size.x());
+
+	if (textureId == 0)
+		return; // uploaded with the rest when the texture is recreated
+
+	if (pitch == size.x())
+		Renderer::updateTexture(textureId, Renderer::Texture::ALPHA, cursor.x(), cursor.y(), size.x(), size.y(), (void*)buffer);
+	else
+	{
+		std::vector<unsigned char> rows(size.x() * size.y());
+		for (int y = 0; y < size.y(); y++)
+			memcpy(&rows[y * size.x()], buffer + y * pitch, size.x());
+
+		Renderer::updateTexture(textureId, Renderer::Texture::ALPHA, cursor.x(), cursor.y(), size.x(), size.y(), rows.data());
+	}
+}
+
 void Font::FontTexture::initTexture()
 {
 	assert(textureId == 0);
-	textureId = Renderer::createTexture(Renderer::Texture::ALPHA, false, false, textureSize.x(), textureSize.y(), nullptr);
+	textureId = Renderer::createTexture(Renderer::Texture::ALPHA, false, false, textureSize.x(), textureSize.y(), pixels.data());
+	if (textureId != 0)
+		TextureDataManager::updateUsage(TextureClass::Font, 0, textureSize.x() * textureSize.y());
 }
 
 void Font::FontTexture::deinitTexture()
@@ -210,34 +315,46 @@ void Font::FontTexture::deinitTexture()
 	if(textureId != 0)
 	{
 		Renderer::destroyTexture(textureId);
+		TextureDataManager::updateUsage(TextureClass::Font, textureSize.x() * textureSize.y(), 0);
 		textureId = 0;
 	}
 }
 
 void Font::getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out)
 {
-	if(mTextures.size())
+	// glyphs of every font & size share the textures, newest ones are the most likely to have space
+	for (auto it = sTextures.rbegin(); it != sTextures.rend(); it++)
 	{
-		// check if the most recent texture has space
-		tex_out = &mTextures.back();
+		tex_out = it->get();
+		if (!tex_out->findEmpty(glyphSize, cursor_out))
+			continue;
+
+		if (std::find(mTextures.cbegin(), mTextures.cend(), tex_out) == mTextures.cend())
+		{
+			mTextures.push_back(tex_out);
+			tex_out->users++;
+		}
 
-		// will this one work?
-		if(tex_out->findEmpty(glyphSize, cursor_out))
-			return; // yes
+		return;
 	}
 
 	// current textures are full,
 	// make a new one
-	mTextures.push_back(FontTexture());
-	tex_out = &mTextures.back();
+	sTextures.push_back(std::unique_ptr<FontTexture>(new FontTexture()));
+	tex_out = sTextures.back().get();
 	tex_out->initTexture();
-	
+
 	bool ok = tex_out->findEmpty(glyphSize, cursor_out);
 	if(!ok)
 	{
 		LOG(LogError) << "Glyph too big to fit on a new texture (glyph size > " << tex_out->textureSize.x() << ", " << tex_out->textureSize.y() << ")!";
+		sTextures.pop_back();
 		tex_out = NULL;
+		return;
 	}
+
+	mTextures.push_back(tex_out);
+	tex_out->users++;
 }
 
 std::vector<std::string> getFallbackFontPaths()
@@ -274,7 +391,7 @@ FT_Face Font::getFaceForChar(unsigned int id)
 			// i == 0 -> mPath
 			// otherwise, take from fallbackFonts
 			const std::string& path = (i == 0 ? mPath : fallbackFonts.at(i - 1));
-			ResourceData data = ResourceManager::getInstance()->getFileData(path);			
+			ResourceData data = ResourceManager::getInstance()->getSharedFileData(path);
 			mFaceCache[i] = std::unique_ptr<FontFace>(new FontFace(std::move(data), i == 1 && mMaxGlyphHeight > 0 ? mMaxGlyphHeight : mSize)); // Reduce size of gyphs ????
 			fit = mFaceCache.find(i);
 		}
@@ -348,8 +465,8 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 	pGlyph->advance = Vector2f((float)g->metrics.horiAdvance / 64.0f, (float)g->metrics.vertAdvance / 64.0f);
 	pGlyph->bearing = Vector2f((float)g->metrics.horiBearingX / 64.0f, (float)g->metrics.horiBearingY / 64.0f);
 
-	// upload glyph bitmap to texture
-	Renderer::updateTexture(tex->textureId, Renderer::Texture::ALPHA, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), g->bitmap.buffer);
+	// keep the bitmap in the RAM copy, and upload it to texture
+	tex->writeGlyph(cursor, glyphSize, g->bitmap.buffer, g->bitmap.pitch);
 
 	// update max glyph height
 	if (id != 61446 && glyphSize.y() > mMaxGlyphHeight)
@@ -363,31 +480,12 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 	return pGlyph;
 }
 
-// completely recreate the texture data for all textures based on mGlyphs information
+// recreate the OpenGL textures from their RAM copy
 void Font::rebuildTextures()
 {
-	// recreate OpenGL textures
-	for(auto it = mTextures.begin(); it != mTextures.end(); it++)
-		it->initTexture();
-
-	// reupload the texture data
-	for(auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend(); it++)
-	{
-		FT_Face face = getFaceForChar(it->first);
-		FT_GlyphSlot glyphSlot = face->glyph;
-
-		// load the glyph bitmap through FT
-		FT_Load_Char(face, it->first, FT_LOAD_RENDER);
-
-		FontTexture* tex = it->second->texture;
-		
-		// find the position/size
-		Vector2i cursor((int)(it->second->texPos.x() * tex->textureSize.x()), (int)(it->second->texPos.y() * tex->textureSize.y()));
-		Vector2i glyphSize((int)(it->second->texSize.x() * tex->textureSize.x()), (int)(it->second->texSize.y() * tex->textureSize.y()));
-		
-		// upload to texture
-		Renderer::updateTexture(tex->textureId, Renderer::Texture::ALPHA, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), glyphSlot->bitmap.buffer);
-	}
+	for(auto it = sTextures.begin(); it != sTextures.end(); it++)
+		if ((*it)->textureId == 0)
+			(*it)->initTexture();
 }
 
 void Font::renderTextCache(TextCache* cache)
@@ -632,6 +730,8 @@ float Font::getNewlineStartOffset(const std::string& text, const unsigned int& c
 
 TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsigned int color, float xLen, Alignment alignment, float lineSpacing)
 {
+	PROFILE_SCOPE("Font::buildTextCache");
+
 	float x = offset[0] + (xLen != 0 ? getNewlineStartOffset(text, 0, xLen, alignment) : 0);
 	
 	float yTop = getGlyph('S')->bearing.y();
@@ -80,15 +80,27 @@ private:
 		unsigned int textureId;
 		Vector2i textureSize;
 
-		Vector2i writePos;
-		int rowHeight;
+		// RAM copy of the glyphs : the texture is recreated from it after a game, without calling FreeType again
+		std::vector<unsigned char> pixels;
+
+		// Skyline packer : top edge of the glyphs already placed, from left to right
+		struct SkylineNode
+		{
+			int x;
+			int y;
+			int width;
+		};
+
+		std::vector<SkylineNode> skyline;
+
+		int users; // number of fonts having glyphs on this texture
 
 		FontTexture();
 		~FontTexture();
 		bool findEmpty(const Vector2i& size, Vector2i& cursor_out);
+		void writeGlyph(const Vector2i& cursor, const Vector2i& size, const unsigned char* buffer, int pitch);
 
-		// you must call initTexture() after creating a FontTexture to get a textureId
-		void initTexture(); // initializes the OpenGL texture according to this FontTexture's settings, updating textureId
+		void initTexture(); // creates the OpenGL texture from the RAM copy, updating textureId
 		void deinitTexture(); // deinitializes the OpenGL texture if any exists, is automatically called in the destructor
 	};
 
@@ -101,10 +113,14 @@ private:
 		virtual ~FontFace();
 	};
 
-	void rebuildTextures();
-	void unloadTextures();
+	// Textures are shared by every font & size, a texture is freed when the last font using it goes away
+	static std::vector<std::unique_ptr<FontTexture>> sTextures;
+
+	static void rebuildTextures();
+	static void unloadTextures();
+	void releaseTextures();
 
-	std::vector<FontTexture> mTextures;
+	std::vector<FontTexture*> mTextures; // textures holding glyphs of this font
 
 	void getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out);
 
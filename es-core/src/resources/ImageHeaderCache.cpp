@@ -0,0 +1,456 @@
+#include "resources/ImageHeaderCache.h"
+
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define IMAGE_HEADER_CACHE_MAGIC	0x48495345 // "ESIH"
+#define IMAGE_HEADER_CACHE_VERSION	1
+
+#define MIN_CAPACITY				1024
+#define VALIDATE_PER_SAVE			256 // old entries checked against the file system on each shutdown
+
+#define SLOT_USED					1
+#define SLOT_REPLACED				2 // the entry was changed or removed during this session, see the shards
+
+struct ImageHeaderCache::FileHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int capacity; // slots, power of 2
+	unsigned int count;
+	unsigned int pathDataSize;
+	unsigned int validateCursor;
+	unsigned int pad[2];
+};
+
+struct ImageHeaderCache::Slot
+{
+	unsigned long long key;
+	long long mtime;
+	int size;
+	int width;
+	int height;
+	unsigned int flags;
+	unsigned int pathOffset;
+	unsigned int pathLength;
+};
+
+ImageHeaderCache* ImageHeaderCache::getInstance()
+{
+	static ImageHeaderCache* instance = new ImageHeaderCache();
+	return instance;
+}
+
+ImageHeaderCache::ImageHeaderCache() : mMapping(nullptr), mMappingSize(0), mSlots(nullptr), mCapacity(0), mPathData(nullptr), mPathDataSize(0), mValidateCursor(0), mMappedValid(false), mDirty(false)
+{
+	mPath = Utils::FileSystem::getEsConfigPath() + "/imagecache.bin";
+}
+
+unsigned long long ImageHeaderCache::getKey(const std::string& path)
+{
+	// FNV-1a, 0 is never used as a key
+	unsigned long long hash = 14695981039346656037ULL;
+
+	for (auto c : path)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ULL;
+	}
+
+	return hash == 0 ? 1 : hash;
+}
+
+bool ImageHeaderCache::isPersistent(const std::string& path, const Info& info)
+{
+	// Theme pictures are cheap to read again & change with the theme
+	return info.size > 0 && info.width > 0 && path.find("/themes/") == std::string::npos;
+}
+
+ImageHeaderCache::Shard& ImageHeaderCache::getShard(unsigned long long key)
+{
+	return mShards[(key >> 32) % IMAGE_HEADER_CACHE_SHARDS];
+}
+
+ImageHeaderCache::Slot* ImageHeaderCache::findSlot(unsigned long long key, const std::string& path)
+{
+	if (!mMappedValid)
+		return nullptr;
+
+	unsigned int mask = mCapacity - 1;
+
+	for (unsigned int i = 0, index = (unsigned int)key & mask; i < mCapacity; i++, index = (index + 1) & mask)
+	{
+		Slot* slot = &mSlots[index];
+		if ((slot->flags & SLOT_USED) == 0)
+			return nullptr;
+
+		if (slot->key == key && slot->pathLength == path.size() && (size_t)slot->pathOffset + slot->pathLength <= mPathDataSize &&
+			memcmp(mPathData + slot->pathOffset, path.data(), path.size()) == 0)
+			return slot;
+	}
+
+	return nullptr;
+}
+
+void ImageHeaderCache::load()
+{
+	// Replaced by this file
+	std::string oldFile = Utils::FileSystem::getEsConfigPath() + "/imagecache.db";
+	if (Utils::FileSystem::exists(oldFile))
+		Utils::FileSystem::removeFile(oldFile);
+
+	if (mMapping != nullptr)
+		return;
+
+	int fd = open(mPath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(FileHeader))
+	{
+		close(fd);
+		return;
+	}
+
+	// Private & writable : flagging replaced slots must not reach the file
+	void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (mapping == MAP_FAILED)
+	{
+		LOG(LogWarning) << "ImageHeaderCache : unable to map " << mPath;
+		return;
+	}
+
+	const FileHeader* header = (const FileHeader*)mapping;
+
+	bool valid = header->magic == IMAGE_HEADER_CACHE_MAGIC && header->version == IMAGE_HEADER_CACHE_VERSION &&
+		header->capacity > 0 && (header->capacity & (header->capacity - 1)) == 0 &&
+		sizeof(FileHeader) + (size_t)header->capacity * sizeof(Slot) + header->pathDataSize == (size_t)info.st_size;
+
+	if (!valid)
+	{
+		LOG(LogWarning) << "ImageHeaderCache : ignoring invalid " << mPath;
+		munmap(mapping, (size_t)info.st_size);
+		return;
+	}
+
+	mMapping = mapping;
+	mMappingSize = (size_t)info.st_size;
+	mCapacity = header->capacity;
+	mSlots = (Slot*)((char*)mapping + sizeof(FileHeader));
+	mPathData = (const char*)(mSlots + mCapacity);
+	mPathDataSize = header->pathDataSize;
+	mValidateCursor = header->validateCursor % mCapacity;
+	mMappedValid = true;
+
+	LOG(LogInfo) << "ImageHeaderCache : " << header->count << " entries";
+}
+
+bool ImageHeaderCache::isCurrent(const std::string& path, const Info& info)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return false;
+
+	if (info.size >= 0 && (long long)st.st_size != info.size)
+		return false;
+
+	return info.mtime == 0 || (long long)st.st_mtime == info.mtime;
+}
+
+bool ImageHeaderCache::get(const std::string& path, Info& info)
+{
+	unsigned long long key = getKey(path);
+	bool found = false;
+
+	Slot* slot = findSlot(key, path);
+	if (slot != nullptr && (__atomic_load_n(&slot->flags, __ATOMIC_ACQUIRE) & SLOT_REPLACED) == 0)
+	{
+		info = Info(slot->size, slot->width, slot->height, slot->mtime);
+		found = true;
+	}
+	else
+	{
+		Shard& shard = getShard(key);
+		std::unique_lock<std::mutex> lock(shard.lock);
+
+		auto it = shard.entries.find(path);
+		if (it != shard.entries.cend() && !it->second.removed)
+		{
+			info = it->second.info;
+			found = true;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	// The picture may have been replaced (scraped again...) since it was cached
+	if (!isCurrent(path, info))
+	{
+		remove(path);
+		return false;
+	}
+
+	return true;
+}
+
+void ImageHeaderCache::update(const std::string& path, const Info& info)
+{
+	unsigned long long key = getKey(path);
+	Slot* slot = findSlot(key, path);
+
+	Shard& shard = getShard(key);
+
+	{
+		std::unique_lock<std::mutex> lock(shard.lock);
+
+		Info current;
+		bool known = false;
+
+		auto it = shard.entries.find(path);
+		if (it != shard.entries.cend())
+		{
+			known = !it->second.removed;
+			current = it->second.info;
+		}
+		else if (slot != nullptr && (__atomic_load_n(&slot->flags, __ATOMIC_ACQUIRE) & SLOT_REPLACED) == 0)
+		{
+			known = true;
+			current = Info(slot->size, slot->width, slot->height, slot->mtime);
+		}
+
+		Info value = info;
+		if (value.mtime == 0 && known && current.size == value.size)
+			value.mtime = current.mtime;
+
+		if (known && current.size == value.size && current.width == value.width && current.height == value.height && current.mtime == value.mtime)
+			return;
+
+		Entry& entry = shard.entries[path];
+		entry.info = value;
+		entry.removed = false;
+
+		if (isPersistent(path, value) || (known && isPersistent(path, current)))
+			mDirty = true;
+	}
+
+	// Readers of the mapped slot are sent to the shard, which is already up to date
+	if (slot != nullptr)
+		__atomic_or_fetch(&slot->flags, SLOT_REPLACED, __ATOMIC_RELEASE);
+}
+
+void ImageHeaderCache::remove(const std::string& path)
+{
+	unsigned long long key = getKey(path);
+	Slot* slot = findSlot(key, path);
+
+	Shard& shard = getShard(key);
+
+	{
+		std::unique_lock<std::mutex> lock(shard.lock);
+
+		auto it = shard.entries.find(path);
+		if (it == shard.entries.cend() && slot == nullptr)
+			return;
+
+		Entry& entry = shard.entries[path];
+		entry.info = Info();
+		entry.removed = true;
+	}
+
+	if (slot != nullptr)
+	{
+		__atomic_or_fetch(&slot->flags, SLOT_REPLACED, __ATOMIC_RELEASE);
+		mDirty = true;
+	}
+}
+
+void ImageHeaderCache::clear()
+{
+	mMappedValid = false;
+
+	for (auto& shard : mShards)
+	{
+		std::unique_lock<std::mutex> lock(shard.lock);
+		shard.entries.clear();
+	}
+
+	Utils::FileSystem::removeFile(mPath);
+	mDirty = false;
+}
+
+void ImageHeaderCache::save()
+{
+	struct SaveEntry
+	{
+		unsigned long long key;
+		Info info;
+		const char* path;
+		unsigned int pathLength;
+	};
+
+	std::vector<SaveEntry> entries;
+	bool dirty = mDirty;
+
+	// Entries of this session
+	for (auto& shard : mShards)
+	{
+		std::unique_lock<std::mutex> lock(shard.lock);
+
+		for (auto& item : shard.entries)
+		{
+			const std::string& path = item.first;
+			Entry& entry = item.second;
+			if (entry.removed || !isPersistent(path, entry.info))
+				continue;
+
+			if (entry.info.mtime == 0)
+			{
+				struct stat info;
+				if (stat(path.c_str(), &info) != 0)
+					continue;
+
+				entry.info.mtime = (long long)info.st_mtime;
+			}
+
+			SaveEntry save = { getKey(path), entry.info, path.c_str(), (unsigned int)path.size() };
+			entries.push_back(save);
+		}
+	}
+
+	// Entries of the previous sessions, a slice of them is checked against the file system
+	if (mMappedValid)
+	{
+		for (unsigned int i = 0; i < mCapacity; i++)
+		{
+			Slot& slot = mSlots[i];
+			if ((slot.flags & SLOT_USED) == 0 || (slot.flags & SLOT_REPLACED) != 0)
+				continue;
+
+			if ((size_t)slot.pathOffset + slot.pathLength > mPathDataSize)
+				continue;
+
+			SaveEntry save = { slot.key, Info(slot.size, slot.width, slot.height, slot.mtime), mPathData + slot.pathOffset, slot.pathLength };
+
+			unsigned int distance = (i - mValidateCursor) & (mCapacity - 1);
+			if (distance < VALIDATE_PER_SAVE)
+			{
+				struct stat info;
+				std::string path(save.path, save.pathLength);
+
+				if (stat(path.c_str(), &info) != 0 || (long long)info.st_size != save.info.size || (long long)info.st_mtime != save.info.mtime)
+				{
+					dirty = true;
+					continue;
+				}
+			}
+
+			entries.push_back(save);
+		}
+
+		mValidateCursor = (mValidateCursor + VALIDATE_PER_SAVE) & (mCapacity - 1);
+
+		if (!dirty)
+		{
+			// Nothing changed : only move the validation window
+			int fd = open(mPath.c_str(), O_WRONLY);
+			if (fd >= 0)
+			{
+				if (pwrite(fd, &mValidateCursor, sizeof(mValidateCursor), offsetof(FileHeader, validateCursor)) != (ssize_t)sizeof(mValidateCursor))
+				{
+					LOG(LogWarning) << "ImageHeaderCache : unable to update " << mPath;
+				}
+
+				close(fd);
+			}
+
+			return;
+		}
+	}
+	else if (!dirty)
+		return;
+
+	unsigned int capacity = MIN_CAPACITY;
+	while (capacity < entries.size() * 2)
+		capacity *= 2;
+
+	std::vector<Slot> slots(capacity);
+	memset(slots.data(), 0, capacity * sizeof(Slot));
+
+	std::string pathData;
+	unsigned int count = 0;
+
+	for (auto& entry : entries)
+	{
+		auto isEntry = [&pathData, &entry](const Slot& slot)
+		{
+			return slot.key == entry.key && slot.pathLength == entry.pathLength && memcmp(pathData.data() + slot.pathOffset, entry.path, entry.pathLength) == 0;
+		};
+
+		unsigned int index = (unsigned int)entry.key & (capacity - 1);
+		while ((slots[index].flags & SLOT_USED) != 0 && !isEntry(slots[index]))
+			index = (index + 1) & (capacity - 1);
+
+		Slot& slot = slots[index];
+		if ((slot.flags & SLOT_USED) != 0)
+			continue; // session entries come first & win
+
+		slot.key = entry.key;
+		slot.mtime = entry.info.mtime;
+		slot.size = entry.info.size;
+		slot.width = entry.info.width;
+		slot.height = entry.info.height;
+		slot.flags = SLOT_USED;
+		slot.pathOffset = (unsigned int)pathData.size();
+		slot.pathLength = entry.pathLength;
+
+		pathData.append(entry.path, entry.pathLength);
+		count++;
+	}
+
+	FileHeader header;
+	memset(&header, 0, sizeof(FileHeader));
+	header.magic = IMAGE_HEADER_CACHE_MAGIC;
+	header.version = IMAGE_HEADER_CACHE_VERSION;
+	header.capacity = capacity;
+	header.count = count;
+	header.pathDataSize = (unsigned int)pathData.size();
+	header.validateCursor = mValidateCursor % capacity;
+
+	std::string tmpFile = mPath + ".tmp";
+
+	FILE* file = fopen(tmpFile.c_str(), "wb");
+	if (file == nullptr)
+	{
+		LOG(LogWarning) << "ImageHeaderCache : unable to write " << tmpFile;
+		return;
+	}
+
+	bool ok = fwrite(&header, sizeof(FileHeader), 1, file) == 1 &&
+		fwrite(slots.data(), sizeof(Slot), capacity, file) == capacity &&
+		fwrite(pathData.data(), 1, pathData.size(), file) == pathData.size();
+
+	ok = (fclose(file) == 0) && ok;
+
+	// The mapping of the previous file stays valid after the rename
+	if (!ok || std::rename(tmpFile.c_str(), mPath.c_str()) != 0)
+	{
+		LOG(LogWarning) << "ImageHeaderCache : unable to write " << mPath;
+		unlink(tmpFile.c_str());
+		return;
+	}
+
+	mDirty = false;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_IMAGE_HEADER_CACHE_H
+#define ES_CORE_RESOURCES_IMAGE_HEADER_CACHE_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#define IMAGE_HEADER_CACHE_SHARDS 16
+
+// Persistent cache of picture dimensions, stored in [ES config path]/imagecache.bin
+//
+// The file is an open addressing hash table keyed on a 64 bit hash of the path, followed by the paths, which
+// lookups compare so a hash collision can't return the header of another file.
+// It is memory mapped at startup and never modified : lookups in it don't take any lock.
+// Entries added or changed during the session go into sharded in-memory maps, and the mapped slot they
+// replace is flagged so readers look there instead.
+// On shutdown a new table is written with the entries of both. Each time, a slice of the old entries is
+// checked against the file system (size & modification time), so stale entries go away without a stat of every file.
+// A hit is checked the same way before it is returned.
+class ImageHeaderCache
+{
+public:
+	struct Info
+	{
+		Info() : size(0), width(0), height(0), mtime(0) { }
+		Info(int _size, int _width, int _height, long long _mtime = 0) : size(_size), width(_width), height(_height), mtime(_mtime) { }
+
+		int size;        // file size, < 0 : the file can't be read as a picture
+		int width;
+		int height;
+		long long mtime; // 0 : unknown
+	};
+
+	static ImageHeaderCache* getInstance();
+
+	void load();
+	void save();
+	void clear();
+
+	bool get(const std::string& path, Info& info);
+	void update(const std::string& path, const Info& info);
+	void remove(const std::string& path);
+
+private:
+	ImageHeaderCache();
+
+	struct FileHeader;
+	struct Slot;
+
+	struct Entry
+	{
+		Info info;
+		bool removed;
+	};
+
+	struct Shard
+	{
+		std::mutex lock;
+		std::unordered_map<std::string, Entry> entries;
+	};
+
+	static unsigned long long getKey(const std::string& path);
+	static bool isPersistent(const std::string& path, const Info& info);
+	static bool isCurrent(const std::string& path, const Info& info); // size & modification time still match the file
+
+	Slot* findSlot(unsigned long long key, const std::string& path);
+	Shard& getShard(unsigned long long key);
+
+	std::string mPath;
+
+	// Mapped table of the previous session
+	void*		mMapping;
+	size_t		mMappingSize;
+	Slot*		mSlots;
+	unsigned int mCapacity;
+	const char*	mPathData;
+	size_t		mPathDataSize;
+	unsigned int mValidateCursor;
+	std::atomic<bool> mMappedValid;
+
+	Shard		mShards[IMAGE_HEADER_CACHE_SHARDS];
+	std::atomic<bool> mDirty;
+};
+
+#endif // ES_CORE_RESOURCES_IMAGE_HEADER_CACHE_H
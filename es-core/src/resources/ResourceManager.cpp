@@ -1,7 +1,15 @@
 #include "ResourceManager.h"
 
 #include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include <fcntl.h>
 #include <fstream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Smaller files are cheaper to read than to map
+#define MIN_MAPPED_SIZE (16 * 1024)
 
 auto array_deleter = [](unsigned char* p) { delete[] p; };
 auto nop_deleter = [](unsigned char* /*p*/) { };
@@ -48,12 +56,26 @@ std::string ResourceManager::getResourcePath(const std::string& path) const
 	return path;
 }
 
-const ResourceData ResourceManager::getFileData(const std::string& path) const
+// A mapped file that is truncated or goes away raises SIGBUS on the next access. Only ES resources, themes & fonts
+// are mapped : scraped media is rewritten while ES runs, and roms can be on removable media
+static bool isMappable(const std::string& path)
+{
+	if (path.find("/resources/") != std::string::npos || path.find("/themes/") != std::string::npos)
+		return true;
+
+	std::string ext = Utils::String::toLower(Utils::FileSystem::getExtension(path));
+	return ext == ".ttf" || ext == ".otf";
+}
+
+const ResourceData ResourceManager::getFileData(const std::string& path, AccessHint hint) const
 {
 	//check if its a resource
 	const std::string respath = getResourcePath(path);
 
 	auto size = Utils::FileSystem::getFileSize(respath);
+	if (size >= MIN_MAPPED_SIZE && isMappable(respath))
+		return mapFile(respath, size, hint);
+
 	if (size > 0)
 	{
 		ResourceData data = loadFile(respath, size);
@@ -61,10 +83,73 @@ const ResourceData ResourceManager::getFileData(const std::string& path) const
 	}
 
 	//if the file doesn't exist, return an "empty" ResourceData
-	ResourceData data = {NULL, 0};
+	ResourceData data = {NULL, 0, false};
 	return data;
 }
 
+const ResourceData ResourceManager::getSharedFileData(const std::string& path) const
+{
+	const std::string respath = getResourcePath(path);
+
+	std::unique_lock<std::mutex> lock(mSharedLock);
+
+	auto it = mSharedMappings.find(respath);
+	if (it != mSharedMappings.cend())
+	{
+		std::shared_ptr<unsigned char> data = it->second.data.lock();
+		if (data != nullptr)
+		{
+			ResourceData ret = { data, it->second.length, true };
+			return ret;
+		}
+
+		mSharedMappings.erase(it);
+	}
+
+	ResourceData data = getFileData(respath, RANDOM);
+	if (data.mapped)
+	{
+		SharedMapping& mapping = mSharedMappings[respath];
+		mapping.data = data.ptr;
+		mapping.length = data.length;
+	}
+
+	return data;
+}
+
+ResourceData ResourceManager::mapFile(const std::string& path, size_t size, AccessHint hint) const
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		ResourceData data = {NULL, 0, false};
+		return data;
+	}
+
+	void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (address == MAP_FAILED)
+	{
+		LOG(LogWarning) << "ResourceManager : unable to map " << path << ", reading it";
+		return loadFile(path, size);
+	}
+
+	if (hint == SEQUENTIAL)
+	{
+		// Decoded right away : start reading ahead now
+		madvise(address, size, MADV_SEQUENTIAL);
+		madvise(address, size, MADV_WILLNEED);
+	}
+	else
+		madvise(address, size, MADV_RANDOM);
+
+	std::shared_ptr<unsigned char> data((unsigned char*)address, [size](unsigned char* p) { munmap(p, size); });
+
+	ResourceData ret = {data, size, true};
+	return ret;
+}
+
 
 
 ResourceData ResourceManager::loadFile(const std::string& path, size_t size) const
@@ -85,7 +170,7 @@ ResourceData ResourceManager::loadFile(const std::string& path, size_t size) con
 	stream.read((char*)data.get(), size);
 	stream.close();
 
-	ResourceData ret = {data, size};
+	ResourceData ret = {data, size, false};
 	return ret;
 }
 
@@ -3,18 +3,22 @@
 #define ES_CORE_RESOURCES_RESOURCE_MANAGER_H
 
 #include <list>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 
 
 //The ResourceManager exists to...
 //Allow loading resources embedded into the executable like an actual file.
 //Allow embedded resources to be optionally remapped to actual files for further customization.
 
+// Read-only content of a file. Big resource, theme & font files are memory mapped instead of being copied (mapped == true)
 struct ResourceData
 {
 	const std::shared_ptr<unsigned char> ptr;
 	const size_t length;
+	const bool mapped;
 };
 
 class ResourceManager;
@@ -37,8 +41,17 @@ public:
 	void unloadAll();
 	void reloadAll();
 
+	// How the data is going to be read, given to the kernel for the read-ahead of mapped files
+	enum AccessHint
+	{
+		SEQUENTIAL, // decoded once from start to end : pictures, SVG
+		RANDOM      // looked up for a long time : fonts
+	};
+
 	std::string getResourcePath(const std::string& path) const;
-	const ResourceData getFileData(const std::string& path) const;
+	const ResourceData getFileData(const std::string& path, AccessHint hint = SEQUENTIAL) const;
+	// Maps a file once for all its users, as long as one of them keeps it (a font used at several sizes...)
+	const ResourceData getSharedFileData(const std::string& path) const;
 	bool fileExists(const std::string& path) const;
 
 	static std::mutex FileSystemLock;
@@ -49,6 +62,16 @@ private:
 	static std::shared_ptr<ResourceManager> sInstance;
 
 	ResourceData loadFile(const std::string& path, size_t size) const;
+	ResourceData mapFile(const std::string& path, size_t size, AccessHint hint) const;
+
+	struct SharedMapping
+	{
+		std::weak_ptr<unsigned char> data;
+		size_t length;
+	};
+
+	mutable std::mutex mSharedLock;
+	mutable std::map<std::string, SharedMapping> mSharedMappings;
 
 	class ReloadableInfo
 	{
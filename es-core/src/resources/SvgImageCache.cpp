@@ -0,0 +1,101 @@
+#include "resources/SvgImageCache.h"
+
+#include "resources/ResourceManager.h"
+#include "Log.h"
+#include <nanosvg/nanosvg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define DPI 96
+#define MAX_SVG_IMAGES 128
+
+SvgImageCache* SvgImageCache::getInstance()
+{
+	static SvgImageCache* instance = new SvgImageCache();
+	return instance;
+}
+
+std::shared_ptr<NSVGimage> SvgImageCache::parse(const unsigned char* data, size_t length)
+{
+	if (data == nullptr || length == 0)
+		return nullptr;
+
+	// nsvgParse excepts a modifiable, null-terminated string
+	char* copy = (char*)malloc(length + 1);
+	if (copy == nullptr)
+		return nullptr;
+
+	memcpy(copy, data, length);
+	copy[length] = '\0';
+
+	NSVGimage* image = nsvgParse(copy, "px", DPI);
+	free(copy);
+
+	if (image == nullptr)
+		return nullptr;
+
+	return std::shared_ptr<NSVGimage>(image, nsvgDelete);
+}
+
+std::shared_ptr<NSVGimage> SvgImageCache::get(const std::string& path)
+{
+	std::string fullPath = ResourceManager::getInstance()->getResourcePath(path);
+
+	struct stat info;
+	if (stat(fullPath.c_str(), &info) != 0)
+		return nullptr;
+
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+
+		auto it = mEntries.find(fullPath);
+		if (it != mEntries.cend() && it->second.fileTime == (long long)info.st_mtime && it->second.fileSize == (long long)info.st_size)
+		{
+			it->second.lastUse = ++mUseCounter;
+			return it->second.image;
+		}
+	}
+
+	// Parsed outside the lock : two threads may parse the same file at once, the last one wins
+	const ResourceData data = ResourceManager::getInstance()->getFileData(fullPath);
+
+	std::shared_ptr<NSVGimage> image = parse(data.ptr.get(), data.length);
+	if (image == nullptr)
+	{
+		LOG(LogError) << "Error parsing SVG image " << path;
+		return nullptr;
+	}
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	Entry& entry = mEntries[fullPath];
+	entry.image = image;
+	entry.fileTime = (long long)info.st_mtime;
+	entry.fileSize = (long long)info.st_size;
+	entry.lastUse = ++mUseCounter;
+
+	evict();
+
+	return image;
+}
+
+void SvgImageCache::evict()
+{
+	while (mEntries.size() > MAX_SVG_IMAGES)
+	{
+		auto oldest = mEntries.begin();
+		for (auto it = mEntries.begin(); it != mEntries.end(); ++it)
+			if (it->second.lastUse < oldest->second.lastUse)
+				oldest = it;
+
+		// Textures still rasterizing it keep their own reference
+		mEntries.erase(oldest);
+	}
+}
+
+void SvgImageCache::clear()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	mEntries.clear();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_SVG_IMAGE_CACHE_H
+#define ES_CORE_RESOURCES_SVG_IMAGE_CACHE_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct NSVGimage;
+
+// Parsed SVG documents, shared by every texture rasterizing the same file.
+// Theme icons are rasterized again at each size change : the file is read & parsed only once.
+// nsvgRasterize doesn't modify the parsed image, so a tree can be rasterized by several loader threads at once.
+class SvgImageCache
+{
+public:
+	static SvgImageCache* getInstance();
+
+	// Returns the parsed document, reading the file if it's not cached or has changed. nullptr if it can't be parsed
+	std::shared_ptr<NSVGimage> get(const std::string& path);
+
+	// Parses a document without caching it
+	static std::shared_ptr<NSVGimage> parse(const unsigned char* data, size_t length);
+
+	void clear();
+
+private:
+	SvgImageCache() : mUseCounter(0) { }
+
+	struct Entry
+	{
+		std::shared_ptr<NSVGimage> image;
+		long long fileTime;
+		long long fileSize;
+		unsigned int lastUse;
+	};
+
+	void evict();
+
+	std::mutex mLock;
+	std::unordered_map<std::string, Entry> mEntries;
+	unsigned int mUseCounter;
+};
+
+#endif // ES_CORE_RESOURCES_SVG_IMAGE_CACHE_H
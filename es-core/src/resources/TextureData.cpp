@@ -3,6 +3,10 @@
 #include "math/Misc.h"
 #include "renderers/Renderer.h" 
 #include "resources/ResourceManager.h"
+#include "resources/SvgImageCache.h"
+#include "resources/ThumbnailCache.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/PixelUtil.h"
 #include "ImageIO.h"
 #include "Log.h"
 #include <nanosvg/nanosvg.h>
@@ -10,14 +14,25 @@
 #include <assert.h>
 #include <string.h>
 
-#define DPI 96
-
 bool TextureData::OPTIMIZEVRAM = false;
+TextureData::Compression TextureData::COMPRESSION = TextureData::COMPRESSION_NONE;
 
 TextureData::TextureData(bool tile, bool linear) : mTile(tile), mLinear(linear), mTextureID(0), mDataRGBA(nullptr), mScalable(false),
 									  mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f), mMaxSize(MaxSizeInfo()), mPackedSize(Vector2i(0,0)), mBaseSize(Vector2i(0, 0))
 {
 	mIsExternalDataRGBA = false;
+	mCompressing = false;
+	mReleasePending = false;
+	mFormat = Renderer::Texture::RGBA;
+
+	mClass = TextureClass::Theme;
+	mAccountedSize = 0;
+	mLruPrev = mLruNext = nullptr;
+	mLruLinked = false;
+	mLastUseFrame = 0;
+	mLoadPriority = TexturePriority::Visible;
+	mLoadPending = false;
+	mLoadFailed = false;
 }
 
 TextureData::~TextureData()
@@ -37,24 +52,29 @@ void TextureData::initFromPath(const std::string& path)
 bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length)
 {
 	// If already initialised then don't read again
-	std::unique_lock<std::mutex> lock(mMutex);
-	if (mDataRGBA)
-		return true;
-
-	// nsvgParse excepts a modifiable, null-terminated string
-	char* copy = (char*)malloc(length + 1);
-	assert(copy != NULL);
-	memcpy(copy, fileData, length);
-	copy[length] = '\0';
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mDataRGBA)
+			return true;
+	}
 
-	NSVGimage* svgImage = nsvgParse(copy, "px", DPI);
-	free(copy);
-	if (!svgImage)
+	std::shared_ptr<NSVGimage> svgImage = SvgImageCache::parse(fileData, length);
+	if (svgImage == nullptr)
 	{
 		LOG(LogError) << "Error parsing SVG image.";
 		return false;
 	}
 
+	return initSVGFromImage(svgImage.get());
+}
+
+bool TextureData::initSVGFromImage(NSVGimage* svgImage)
+{
+	// If already initialised then don't rasterize again
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (mDataRGBA)
+		return true;
+
 	if (svgImage->width == 0 || svgImage->height == 0)
 		return false;
 
@@ -102,20 +122,30 @@ bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length
 	else
 		mPackedSize = Vector2i(0, 0);
 	
-	unsigned char* dataRGBA = new unsigned char[mWidth * mHeight * 4];
+	// The same icon at the same size may already have been rasterized by a previous run
+	std::string cachePath = mPath.empty() ? mPath : ResourceManager::getInstance()->getResourcePath(mPath);
+
+	unsigned char* dataRGBA = ThumbnailCache::getInstance()->loadRaster(cachePath, mWidth, mHeight);
+	if (dataRGBA == nullptr)
+	{
+		dataRGBA = new unsigned char[mWidth * mHeight * 4];
+
+		double scale = ((float) ((int) mHeight)) / svgImage->height;
+		double scaleV = ((float) ((int) mWidth)) / svgImage->width;
+		if (scaleV < scale)
+			scale = scaleV;
 
-	double scale = ((float) ((int) mHeight)) / svgImage->height;
-	double scaleV = ((float) ((int) mWidth)) / svgImage->width;
-	if (scaleV < scale)
-		scale = scaleV;
+		NSVGrasterizer* rast = nsvgCreateRasterizer();
+		nsvgRasterize(rast, svgImage, 0, 0, scale, dataRGBA, (int)mWidth, (int)mHeight, (int)mWidth * 4);
+		nsvgDeleteRasterizer(rast);
 
-	NSVGrasterizer* rast = nsvgCreateRasterizer();
-	nsvgRasterize(rast, svgImage, 0, 0, scale, dataRGBA, (int)mWidth, (int)mHeight, (int)mWidth * 4);
-	nsvgDeleteRasterizer(rast);
+		ImageIO::flipPixelsVert(dataRGBA, mWidth, mHeight);
 
-	ImageIO::flipPixelsVert(dataRGBA, mWidth, mHeight);
+		ThumbnailCache::getInstance()->saveRaster(cachePath, dataRGBA, mWidth, mHeight);
+	}
 
 	mDataRGBA = dataRGBA;
+	updateMemoryUsage();
 
 	return true;
 }
@@ -143,6 +173,48 @@ bool TextureData::isRequiredTextureSizeOk()
 	return false;
 }
 
+Vector2i TextureData::getImageTargetSize()
+{
+	auto x = OPTIMIZEVRAM ? mMaxSize.x() : Renderer::getScreenWidth();
+	if (x > Renderer::getScreenWidth())
+		x = Renderer::getScreenWidth();
+
+	auto y = OPTIMIZEVRAM ? mMaxSize.y() : Renderer::getScreenHeight();
+	if (y > Renderer::getScreenHeight())
+		y = Renderer::getScreenHeight();
+
+	return Vector2i(x, y);
+}
+
+bool TextureData::initFromThumbnailCache(bool updateCache)
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mDataRGBA)
+			return true;
+	}
+
+	Vector2i target = getImageTargetSize();
+
+	size_t width, height, sourceLength;
+	Vector2i baseSize;
+
+	unsigned char* imageRGBA = ThumbnailCache::getInstance()->load(mPath, target.x(), target.y(), mMaxSize.externalZoom(), width, height, baseSize, sourceLength);
+	if (imageRGBA == nullptr)
+		return false;
+
+	mBaseSize = baseSize;
+	mPackedSize = Vector2i(width, height);
+	mSourceWidth = (float)width;
+	mSourceHeight = (float)height;
+	mScalable = false;
+
+	if (updateCache)
+		ImageIO::updateImageCache(mPath, sourceLength, mBaseSize.x(), mBaseSize.y());
+
+	return initFromRGBAEx(imageRGBA, width, height);
+}
+
 bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t length)
 {
 	size_t width, height;
@@ -155,21 +227,17 @@ bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t leng
 	}
 	
 
-	auto x = OPTIMIZEVRAM ? mMaxSize.x() : Renderer::getScreenWidth();
-	if (x > Renderer::getScreenWidth())
-		x = Renderer::getScreenWidth();
+	Vector2i target = getImageTargetSize();
 
-	auto y = OPTIMIZEVRAM ? mMaxSize.y() : Renderer::getScreenHeight();
-	if (y > Renderer::getScreenHeight())
-		y = Renderer::getScreenHeight();
-
-	unsigned char* imageRGBA = ImageIO::loadFromMemoryRGBA32Ex((const unsigned char*)(fileData), length, width, height, x, y, mMaxSize.externalZoom(), mBaseSize, mPackedSize);
+	unsigned char* imageRGBA = ImageIO::loadFromMemoryRGBA32Ex((const unsigned char*)(fileData), length, width, height, target.x(), target.y(), mMaxSize.externalZoom(), mBaseSize, mPackedSize);
 	if (imageRGBA == NULL)
 	{
 		LOG(LogError) << "Could not initialize texture from memory, invalid data!  (file path: " << mPath << ", data ptr: " << (size_t)fileData << ", reported size: " << length << ")";
 		return false;
 	}
 
+	ThumbnailCache::getInstance()->save(mPath, target.x(), target.y(), mMaxSize.externalZoom(), imageRGBA, width, height, mBaseSize, mPackedSize);
+
 	mSourceWidth = (float) width;
 	mSourceHeight = (float) height;
 	mScalable = false;
@@ -214,6 +282,7 @@ bool TextureData::initFromRGBA(const unsigned char* dataRGBA, size_t width, size
 	memcpy(mDataRGBA, dataRGBA, width * height * 4);
 	mWidth = width;
 	mHeight = height;
+	updateMemoryUsage();
 	return true;
 }
 
@@ -235,6 +304,7 @@ bool TextureData::initFromRGBAEx(unsigned char* dataRGBA, size_t width, size_t h
 	mDataRGBA = dataRGBA;
 	mWidth = width;
 	mHeight = height;
+	updateMemoryUsage();
 
 	return true;
 }
@@ -244,13 +314,15 @@ bool TextureData::initFromExternalRGBA(unsigned char* dataRGBA, size_t width, si
 	// If already initialised then don't read again
 	std::unique_lock<std::mutex> lock(mMutex);
 
-	if (!mIsExternalDataRGBA && mDataRGBA != nullptr)
+	if (!mIsExternalDataRGBA && mDataRGBA != nullptr && !mCompressing)
 		delete[] mDataRGBA;
 
 	mIsExternalDataRGBA = true;
 	mDataRGBA = dataRGBA;
+	mFormat = Renderer::Texture::RGBA;
 	mWidth = width;
 	mHeight = height;
+	updateMemoryUsage();
 
 	if (mTextureID != 0)
 		Renderer::updateTexture(mTextureID, Renderer::Texture::RGBA, -1, -1, mWidth, mHeight, mDataRGBA);
@@ -265,25 +337,130 @@ bool TextureData::load(bool updateCache)
 	// Need to load. See if there is a file
 	if (!mPath.empty())
 	{
-		std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
+		bool isSvg = mPath.substr(mPath.size() - 4, std::string::npos) == ".svg";
+
+		// A downscaled copy may already be on disk : no need to read & decode the source
+		if (!isSvg && initFromThumbnailCache(updateCache))
+		{
+			compress();
+			mLoadFailed = false;
+			return true;
+		}
 
-		const ResourceData& data = rm->getFileData(mPath);
 		// is it an SVG?
-		if (mPath.substr(mPath.size() - 4, std::string::npos) == ".svg")
+		if (isSvg)
 		{
 			mScalable = true; // ??? interest ?
-			retval = initSVGFromMemory((const unsigned char*)data.ptr.get(), data.length);
+
+			// The parsed document is shared by all the sizes the picture is rasterized at
+			std::shared_ptr<NSVGimage> svgImage = SvgImageCache::getInstance()->get(mPath);
+			retval = svgImage != nullptr && initSVGFromImage(svgImage.get());
+
+			if (updateCache && retval)
+				ImageIO::updateImageCache(mPath, Utils::FileSystem::getFileSize(ResourceManager::getInstance()->getResourcePath(mPath)), mBaseSize.x(), mBaseSize.y());
+
+			mLoadFailed = !retval;
+			return retval;
 		}
-		else
-			retval = initImageFromMemory((const unsigned char*)data.ptr.get(), data.length);
+
+		std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
+
+		const ResourceData& data = rm->getFileData(mPath);
+		retval = initImageFromMemory((const unsigned char*)data.ptr.get(), data.length);
 
 		if (updateCache && retval)
 			ImageIO::updateImageCache(mPath, data.length, mBaseSize.x(), mBaseSize.y());
+
+		if (retval)
+			compress();
+
+		mLoadFailed = !retval;
 	}
 
 	return retval;
 }
 
+TextureData::Compression TextureData::parseCompression(const std::string& value)
+{
+	if (value == "etc1")
+		return COMPRESSION_ETC1;
+
+	if (value == "16bit")
+		return COMPRESSION_16BIT;
+
+	return COMPRESSION_NONE;
+}
+
+void TextureData::compress()
+{
+	unsigned char* source;
+	size_t width, height;
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		// Theme assets, fonts & videos stay in RGBA : only scraped pictures are worth the quality loss
+		if (COMPRESSION == COMPRESSION_NONE || mClass != TextureClass::GameArt || mTile)
+			return;
+
+		if (mCompressing || mDataRGBA == nullptr || mIsExternalDataRGBA || mFormat != Renderer::Texture::RGBA || mWidth == 0 || mHeight == 0)
+			return;
+
+		source = mDataRGBA;
+		width = mWidth;
+		height = mHeight;
+		mCompressing = true;
+	}
+
+	// Encode without the lock, so the main thread doesn't wait in isLoaded() or get()
+	Renderer::Texture::Type format = Renderer::Texture::RGB565;
+	if (Utils::Pixel::hasAlpha(source, width, height))
+		format = Renderer::Texture::RGBA4444;
+	else if (COMPRESSION == COMPRESSION_ETC1 && Renderer::isTextureTypeSupported(Renderer::Texture::ETC1))
+		format = Renderer::Texture::ETC1;
+
+	unsigned char* data = new unsigned char[Renderer::getTextureDataSize(format, width, height)];
+
+	switch (format)
+	{
+	case Renderer::Texture::ETC1:
+		Utils::Pixel::toETC1(data, source, width, height);
+		break;
+	case Renderer::Texture::RGBA4444:
+		Utils::Pixel::toRGBA4444((unsigned short*)data, source, width, height);
+		break;
+	default:
+		Utils::Pixel::toRGB565((unsigned short*)data, source, width, height);
+		break;
+	}
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mCompressing = false;
+
+	bool replaced = mDataRGBA != source;
+	delete[] source;
+
+	if (mReleasePending)
+	{
+		// releaseRAM() was called meanwhile
+		mReleasePending = false;
+		delete[] data;
+
+		mDataRGBA = nullptr;
+		if (mTextureID == 0)
+			mFormat = Renderer::Texture::RGBA;
+	}
+	else if (replaced)
+		delete[] data; // by initFromExternalRGBA()
+	else
+	{
+		mDataRGBA = data;
+		mFormat = format;
+	}
+
+	updateMemoryUsage();
+}
+
 bool TextureData::isLoaded()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
@@ -303,8 +480,8 @@ bool TextureData::uploadAndBind()
 	}
 	else
 	{
-		// Load it if necessary
-		if (!mDataRGBA)
+		// Load it if necessary. Not ready either while compress() is running
+		if (!mDataRGBA || mCompressing)
 		{
 			return false;
 		}
@@ -312,7 +489,7 @@ bool TextureData::uploadAndBind()
 		if ((mWidth == 0) || (mHeight == 0) || (mDataRGBA == nullptr))
 			return false;
 
-		mTextureID = Renderer::createTexture(Renderer::Texture::RGBA, mLinear, mTile, mWidth, mHeight, mDataRGBA);
+		mTextureID = Renderer::createTexture(mFormat, mLinear, mTile, mWidth, mHeight, mDataRGBA);
 		if (mTextureID)
 		{
 			if (mDataRGBA != nullptr && !mIsExternalDataRGBA)
@@ -320,6 +497,8 @@ bool TextureData::uploadAndBind()
 
 			mDataRGBA = nullptr;
 		}
+
+		updateMemoryUsage();
 	}
 
 	return true;
@@ -332,6 +511,11 @@ void TextureData::releaseVRAM()
 	{
 		Renderer::destroyTexture(mTextureID);
 		mTextureID = 0;
+
+		if (mDataRGBA == nullptr)
+			mFormat = Renderer::Texture::RGBA;
+
+		updateMemoryUsage();
 	}
 }
 
@@ -339,10 +523,22 @@ void TextureData::releaseRAM()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 
+	// compress() is reading the buffer : it frees it when done
+	if (mCompressing)
+	{
+		mReleasePending = true;
+		return;
+	}
+
 	if (mDataRGBA != nullptr && !mIsExternalDataRGBA)
 		delete[] mDataRGBA;
 
 	mDataRGBA = 0;
+
+	if (mTextureID == 0)
+		mFormat = Renderer::Texture::RGBA;
+
+	updateMemoryUsage();
 }
 
 size_t TextureData::width()
@@ -397,10 +593,31 @@ void TextureData::setSourceSize(float width, float height)
 	}
 }
 
+void TextureData::setTextureClass(TextureClass::Type type)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (mClass == type)
+		return;
+
+	TextureDataManager::updateUsage(mClass, mAccountedSize, 0);
+	TextureDataManager::updateUsage(type, 0, mAccountedSize);
+	mClass = type;
+}
+
+void TextureData::updateMemoryUsage()
+{
+	size_t size = (mTextureID != 0 || mDataRGBA != nullptr) ? Renderer::getTextureDataSize(mFormat, mWidth, mHeight) : 0;
+	if (size == mAccountedSize)
+		return;
+
+	TextureDataManager::updateUsage(mClass, mAccountedSize, size);
+	mAccountedSize = size;
+}
+
 size_t TextureData::getVRAMUsage()
 {
 	if ((mTextureID != 0) || (mDataRGBA != nullptr))
-		return mWidth * mHeight * 4;
+		return Renderer::getTextureDataSize(mFormat, mWidth, mHeight);
 	else
 		return 0;
 }
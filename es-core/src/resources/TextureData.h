@@ -2,14 +2,17 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_H
 
+#include <atomic>
 #include <mutex>
 #include <string>
 
 #include "math/Vector2f.h"
 #include "math/Vector2i.h"
+#include "renderers/Renderer.h"
 #include "resources/TextureResource.h"
 
 // class TextureResource;
+struct NSVGimage;
 
 class TextureData
 {
@@ -19,6 +22,17 @@ public:
 
 	static bool OPTIMIZEVRAM;
 
+	// Game art can be kept in a smaller GPU format : 16 bit (RGB565, or RGBA4444 with transparency) or ETC1 when the GPU supports it
+	enum Compression
+	{
+		COMPRESSION_NONE  = 0,
+		COMPRESSION_16BIT = 1,
+		COMPRESSION_ETC1  = 2
+	};
+
+	static Compression COMPRESSION;
+	static Compression parseCompression(const std::string& value); // "none", "16bit" or "etc1"
+
 	// These functions populate mDataRGBA but do not upload the texture to VRAM
 
 	//!!!! Needs to be canonical path. Caller should check for duplicates before calling this
@@ -34,6 +48,12 @@ public:
 
 	bool isLoaded();
 
+	// A TextureLoader request is queued or running
+	bool isLoadPending() { return mLoadPending; }
+
+	// The picture couldn't be read by the last load : it isn't queued again until a direct load() succeeds
+	bool hasLoadFailed() { return mLoadFailed; }
+
 	// Upload the texture to VRAM if necessary and bind. Returns true if bound ok or
 	// false if either not loaded
 	bool uploadAndBind();
@@ -68,11 +88,24 @@ public:
 		return mDataRGBA;
 	}
 
+	void setTextureClass(TextureClass::Type type);
+	TextureClass::Type getTextureClass() { return mClass; }
+
 private:
+	friend class TextureDataManager;
+	friend class TextureLoader;
+
+	// Size the picture is scaled down to when it is decoded
+	Vector2i getImageTargetSize();
+	bool initFromThumbnailCache(bool updateCache);
+	bool initSVGFromImage(NSVGimage* svgImage);
+	void compress(); // Converts the RGBA pixels to the COMPRESSION format
+
 	std::mutex		mMutex;
 	bool			mTile;
 	bool			mLinear;
-	unsigned char*	mDataRGBA;
+	unsigned char*	mDataRGBA;	// pixels in mFormat
+	Renderer::Texture::Type mFormat;
 	size_t			mWidth;
 	size_t			mHeight;
 	float			mSourceWidth;
@@ -85,6 +118,25 @@ private:
 	MaxSizeInfo		mMaxSize;
 
 	bool			mIsExternalDataRGBA;
+
+	// compress() encodes mDataRGBA without holding mMutex : meanwhile it's neither uploaded nor freed
+	bool			mCompressing;
+	bool			mReleasePending;
+
+	// Memory accounting, see TextureDataManager
+	void updateMemoryUsage(); // mMutex must be held
+
+	TextureClass::Type	mClass;
+	size_t				mAccountedSize;
+
+	TextureData*	mLruPrev;
+	TextureData*	mLruNext;
+	bool			mLruLinked;
+	unsigned int	mLastUseFrame;
+
+	TexturePriority::Level mLoadPriority; // queue used by TextureLoader
+	std::atomic<bool>	mLoadPending;	// set & cleared by TextureLoader, under its lock
+	std::atomic<bool>	mLoadFailed;
 };
 
 #endif // ES_CORE_RESOURCES_TEXTURE_DATA_H
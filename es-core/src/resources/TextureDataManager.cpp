@@ -2,12 +2,24 @@
 
 #include "resources/TextureData.h"
 #include "resources/TextureResource.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "utils/StringUtil.h"
 #include "utils/FileSystemUtil.h"
+#include "utils/ThreadPool.h"
 #include <SDL_timer.h>
 
-TextureDataManager::TextureDataManager()
+#define LOW_WATERMARK_PERCENT	85 // eviction stops when the usage is back under this share of the budget
+#define PROTECTED_FRAMES		2  // textures used during the last frames are never evicted
+#define EVICTION_INTERVAL		250 // ms between two budget checks
+#define MAX_QUEUED_TEXTURES		96
+
+std::atomic<size_t>			TextureDataManager::sUsage[TextureClass::COUNT];
+std::atomic<unsigned int>	TextureDataManager::sEvictions(0);
+std::atomic<size_t>			TextureDataManager::sBudget[TextureClass::COUNT];
+std::atomic<size_t>			TextureDataManager::sMaxTotal(0);
+
+TextureDataManager::TextureDataManager() : mLruHead(nullptr), mLruTail(nullptr), mFrame(0), mLastEvictionCheck(0)
 {
 	unsigned char data[5 * 5 * 4];
 	mBlank = std::shared_ptr<TextureData>(new TextureData(false, false));
@@ -26,6 +38,104 @@ TextureDataManager::TextureDataManager()
 TextureDataManager::~TextureDataManager()
 {
 	delete mLoader;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (mLruHead != nullptr)
+		lruUnlink(mLruHead);
+}
+
+void TextureDataManager::updateUsage(TextureClass::Type type, size_t oldSize, size_t newSize)
+{
+	if (newSize > oldSize)
+		sUsage[type] += newSize - oldSize;
+	else
+		sUsage[type] -= oldSize - newSize;
+}
+
+void TextureDataManager::updateBudgets()
+{
+	static const char* budgetSettings[TextureClass::COUNT] = { "MaxVRAMTheme", "MaxVRAMGameArt", "MaxVRAMFont", "MaxVRAMVideo" };
+
+	for (int i = 0; i < TextureClass::COUNT; i++)
+		sBudget[i] = (size_t)Settings::getInstance()->getInt(budgetSettings[i]) * 1024 * 1024;
+
+	sMaxTotal = (size_t)Settings::getInstance()->getInt("MaxVRAM") * 1024 * 1024;
+}
+
+TextureMemoryStats TextureDataManager::getStats()
+{
+	// Budgets are read on every frame : cache them, and refresh them when a MaxVRAM* setting changes
+	static std::once_flag sBudgetsOnce;
+	std::call_once(sBudgetsOnce, []
+	{
+		updateBudgets();
+		Settings::getInstance()->addChangeListener("", [](const std::string& name)
+		{
+			if (Utils::String::startsWith(name, "MaxVRAM"))
+				updateBudgets();
+		});
+	});
+
+	TextureMemoryStats stats;
+	stats.total = 0;
+
+	for (int i = 0; i < TextureClass::COUNT; i++)
+	{
+		stats.usage[i] = sUsage[i];
+		stats.budget[i] = sBudget[i];
+
+		if (i != TextureClass::Font) // fonts are not part of MaxVRAM, as before
+			stats.total += stats.usage[i];
+	}
+
+	stats.maxTotal = sMaxTotal;
+	stats.evictions = sEvictions;
+	return stats;
+}
+
+void TextureDataManager::lruLink(TextureData* tex)
+{
+	tex->mLruPrev = nullptr;
+	tex->mLruNext = mLruHead;
+
+	if (mLruHead != nullptr)
+		mLruHead->mLruPrev = tex;
+	else
+		mLruTail = tex;
+
+	mLruHead = tex;
+	tex->mLruLinked = true;
+	tex->mLastUseFrame = mFrame;
+}
+
+void TextureDataManager::lruUnlink(TextureData* tex)
+{
+	if (!tex->mLruLinked)
+		return;
+
+	if (tex->mLruPrev != nullptr)
+		tex->mLruPrev->mLruNext = tex->mLruNext;
+	else
+		mLruHead = tex->mLruNext;
+
+	if (tex->mLruNext != nullptr)
+		tex->mLruNext->mLruPrev = tex->mLruPrev;
+	else
+		mLruTail = tex->mLruPrev;
+
+	tex->mLruPrev = tex->mLruNext = nullptr;
+	tex->mLruLinked = false;
+}
+
+void TextureDataManager::lruTouch(TextureData* tex)
+{
+	tex->mLastUseFrame = mFrame;
+
+	if (mLruHead == tex)
+		return;
+
+	lruUnlink(tex);
+	lruLink(tex);
 }
 
 void TextureDataManager::onTextureLoaded(std::shared_ptr<TextureData> tex)
@@ -34,8 +144,7 @@ void TextureDataManager::onTextureLoaded(std::shared_ptr<TextureData> tex)
 
 	for (auto it = mTextureLookup.cbegin(); it != mTextureLookup.cend(); it++)
 	{
-		std::shared_ptr<TextureData> texture = *(*it).second;		
-		if (texture == tex)
+		if (it->second == tex)
 		{
 			const TextureResource* pResource = it->first;
 			((TextureResource*)pResource)->onTextureLoaded(tex);
@@ -53,14 +162,14 @@ std::shared_ptr<TextureData> TextureDataManager::add(const TextureResource* key,
 	if (it != mTextureLookup.cend())
 	{
 		// Remove the list entry
-		mTextures.erase((*it).second);
+		lruUnlink(it->second.get());
 		// And the lookup
 		mTextureLookup.erase(it);
 	}
 
 	std::shared_ptr<TextureData> data = std::make_shared<TextureData>(tiled, linear);
-	mTextures.push_front(data);
-	mTextureLookup[key] = mTextures.cbegin();
+	lruLink(data.get());
+	mTextureLookup[key] = data;
 
 	return data;
 }
@@ -74,7 +183,7 @@ void TextureDataManager::remove(const TextureResource* key)
 	if (it != mTextureLookup.cend())
 	{
 		// Remove the list entry
-		mTextures.erase((*it).second);
+		lruUnlink(it->second.get());
 		// And the lookup
 		mTextureLookup.erase(it);
 	}
@@ -86,33 +195,61 @@ void TextureDataManager::cancelAsync(const TextureResource* key)
 
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.cend())
-		mLoader->remove(*(*it).second);
+		mLoader->remove(it->second);
+}
+
+void TextureDataManager::cancelAsync(const std::vector<const TextureResource*>& keys)
+{
+	std::vector<const TextureData*> textures;
+	textures.reserve(keys.size());
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	for (auto key : keys)
+	{
+		auto it = mTextureLookup.find(key);
+		if (it != mTextureLookup.cend())
+			textures.push_back(it->second.get());
+	}
+
+	// One loader lock for the whole batch
+	mLoader->remove(textures);
+}
+
+void TextureDataManager::setLoadPriority(const std::vector<const TextureResource*>& keys, TexturePriority::Level priority)
+{
+	std::vector<const TextureData*> textures;
+	textures.reserve(keys.size());
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	for (auto key : keys)
+	{
+		auto it = mTextureLookup.find(key);
+		if (it != mTextureLookup.cend())
+		{
+			it->second->mLoadPriority = priority;
+			textures.push_back(it->second.get());
+		}
+	}
+
+	mLoader->setPriority(textures, priority);
 }
 
 std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key, bool enableLoading)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 
-	// If it's in the cache then we want to remove it from it's current location and
-	// move it to the top
+	// If it's in the cache then we want to move it to the top of the LRU list
 	std::shared_ptr<TextureData> tex;
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.cend())
 	{
-		tex = *(*it).second;
+		tex = it->second;
+		lruTouch(tex.get());
 
-		if (mTextures.cbegin() != (*it).second)
-		{
-			// Remove the list entry
-			mTextures.erase((*it).second);
-			// Put it at the top
-			mTextures.push_front(tex);
-			// Store it back in the lookup
-			mTextureLookup[key] = mTextures.cbegin();
-		}
-
-		// Make sure it's loaded or queued for loading
-		if (enableLoading && !tex->isLoaded()) // FCATMP
+		// Make sure it's loaded or queued for loading. A picture that can't be read isn't retried on every frame
+		if (enableLoading && !tex->isLoaded() && !tex->hasLoadFailed()) // FCATMP
 		{
 			lock.unlock();
 			load(tex);
@@ -137,40 +274,16 @@ size_t TextureDataManager::getTotalSize()
 	std::unique_lock<std::mutex> lock(mMutex);
 
 	size_t total = 0;
-	for (auto tex : mTextures)
+	for (auto tex = mLruHead; tex != nullptr; tex = tex->mLruNext)
 		total += tex->width() * tex->height() * 4;
 
 	return total;
 }
 
-size_t TextureDataManager::getCommittedSize()
-{
-	std::unique_lock<std::mutex> lock(mMutex);
-
-	size_t total = 0;
-	for (auto tex : mTextures)
-		total += tex->getVRAMUsage();
-
-	return total;
-}
-
-size_t TextureDataManager::getQueueSize()
-{
-	return mLoader->getQueueSize();
-}
-
-bool compareTextures(const std::shared_ptr<TextureData>& first, const std::shared_ptr<TextureData>& second)
-{	
-	bool isResource = first->mPath.rfind(":/") == 0;
-	bool secondIsResource = second->mPath.rfind(":/") == 0;
-	if (isResource && !secondIsResource)
-		return true;
-
-	return false;
-}
-
 void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 {
+	PROFILE_SCOPE("TextureDataManager::load");
+
 	// See if it's already loaded
 	if (tex->isLoaded())
 	{
@@ -184,70 +297,115 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 		block = true; // Reload instantly or other instances will fade again
 	}
 
-	// Not loaded. Make sure there is room
-	size_t size = TextureResource::getTotalMemUsage();
-	size_t max_texture = (size_t)Settings::getInstance()->getInt("MaxVRAM") * 1024 * 1024;
-
-	if (size >= max_texture)
+	if (!block)
 	{
-		std::unique_lock<std::mutex> lock(mMutex);
+		mLoader->load(tex);
+	}
+	else
+	{				
+		mLoader->remove(tex);
+		tex->load();
+	}
+}
 
-		std::list<std::shared_ptr<TextureData>> orderedTextures(mTextures);
-		orderedTextures.sort(compareTextures);
+size_t TextureDataManager::evict(TextureClass::Type type, size_t usage, size_t target)
+{
+	// From the least recently used texture, skipping the ones that are still on screen
+	for (TextureData* tex = mLruTail; tex != nullptr && usage > target; )
+	{
+		TextureData* prev = tex->mLruPrev;
 
-		for (auto it = orderedTextures.crbegin(); it != orderedTextures.crend(); ++it)
+		if (tex->mClass == type && mFrame - tex->mLastUseFrame > PROTECTED_FRAMES)
 		{
-			if (size < max_texture)
-				break;
-
-			if ((*it) == tex)
-				continue;
-
+			size_t size = tex->mAccountedSize;
 			bool changed = false;
 
-			if ((*it)->isLoaded())
+			if (tex->isLoaded())
 			{
-				(*it)->releaseVRAM();
-				(*it)->releaseRAM();
-
+				tex->releaseVRAM();
+				tex->releaseRAM();
 				changed = true;
 			}
 
-			// It may be already in the loader queue. In this case it wouldn't have been using
-			// any VRAM yet but it will be. Remove it from the loader queue
-			if (mLoader->remove(*it))
+			// It may be in the loader queue. It's not using memory yet but it will
+			if (mLoader->remove(tex))
 				changed = true;
 
 			if (changed)
 			{
-				lock.unlock();
-				size = TextureResource::getTotalMemUsage();
-				lock.lock();
+				usage = usage > size ? usage - size : 0;
+				sEvictions++;
 			}
 		}
+
+		tex = prev;
 	}
 
-	if (!block)
+	return usage;
+}
+
+void TextureDataManager::update()
+{
+	mFrame++;
+
+	// Between two checks a frame only bumps the counter : no lock, no LRU walk
+	unsigned int now = SDL_GetTicks();
+	if (now - mLastEvictionCheck < EVICTION_INTERVAL)
+		return;
+
+	mLastEvictionCheck = now;
+
+	// Game art goes first : theme textures are shared by every view
+	static const TextureClass::Type evictable[] = { TextureClass::GameArt, TextureClass::Theme };
+
+	TextureMemoryStats stats = getStats();
+
+	bool overBudget = stats.maxTotal != 0 && stats.total > stats.maxTotal;
+	for (auto type : evictable)
+		overBudget = overBudget || (stats.budget[type] != 0 && stats.usage[type] > stats.budget[type]);
+
+	if (!overBudget)
+		return;
+
+	PROFILE_SCOPE("TextureDataManager::evict");
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	for (auto type : evictable)
 	{
-		mLoader->load(tex);
+		size_t budget = stats.budget[type];
+		if (budget == 0 || stats.usage[type] <= budget)
+			continue;
+
+		size_t usage = evict(type, stats.usage[type], budget / 100 * LOW_WATERMARK_PERCENT);
+		stats.total -= stats.usage[type] - usage;
+		stats.usage[type] = usage;
 	}
-	else
-	{				
-		mLoader->remove(tex);
-		tex->load();
+
+	if (stats.maxTotal == 0 || stats.total <= stats.maxTotal)
+		return;
+
+	size_t target = stats.maxTotal / 100 * LOW_WATERMARK_PERCENT;
+
+	for (auto type : evictable)
+	{
+		if (stats.total <= target)
+			break;
+
+		size_t others = stats.total - stats.usage[type];
+		size_t usage = evict(type, stats.usage[type], target > others ? target - others : 0);
+		stats.total = others + usage;
 	}
 }
 
-TextureLoader::TextureLoader(TextureDataManager* mgr) : mExit(false)
+TextureLoader::TextureLoader(TextureDataManager* mgr) : mExit(false), mActiveWorkers(0)
 {
 	mManager = mgr;
 
-	int num_threads = std::thread::hardware_concurrency() / 2;
-	if (num_threads == 0)
-		num_threads = 1;
-
-	for (size_t i = 0; i < num_threads; i++)
-		mThreads.push_back(std::thread(&TextureLoader::threadProc, this));
+	// Textures are loaded on the shared pool, but never on more than half of the cores
+	mMaxWorkers = std::thread::hardware_concurrency() / 2;
+	if (mMaxWorkers == 0)
+		mMaxWorkers = 1;
 }
 
 TextureLoader::~TextureLoader()
@@ -255,48 +413,47 @@ TextureLoader::~TextureLoader()
 	// Just abort any waiting texture
 	clearQueue();
 
-	// Exit the thread
+	// Wait for the textures being loaded
+	std::unique_lock<std::mutex> lock(mLoaderLock);
 	mExit = true;
-	mEvent.notify_all();
-	
-	for (std::thread& t : mThreads)
-		t.join();	
+	mEvent.wait(lock, [this]() { return mActiveWorkers == 0; });
 }
 
 void TextureLoader::threadProc()
 {
 	while (true)
 	{
-		// Wait for an event to say there is something in the queue
 		std::unique_lock<std::mutex> lock(mLoaderLock);
-		mEvent.wait(lock, [this]() { return mExit || !mTextureDataQ.empty(); });
 
-		if (mExit)
-			break;
+		int priority = TexturePriority::COUNT - 1;
+		while (priority >= 0 && mTextureDataQ[priority].empty())
+			priority--;
 
-		if (!mTextureDataQ.empty())
+		if (mExit || priority < 0)
 		{
-			std::shared_ptr<TextureData> textureData = mTextureDataQ.front();
-			mTextureDataQ.pop_front();
-
-			mProcessingTextureDataQ.push_back(textureData);
-
-			lock.unlock();
+			// Give the worker back to the pool
+			mActiveWorkers--;
+			mEvent.notify_all();
+			return;
+		}
 
-			if (textureData && !textureData->isLoaded())
-			{
-				std::this_thread::yield();
+		std::shared_ptr<TextureData> textureData = mTextureDataQ[priority].front();
+		mTextureDataQ[priority].pop_front();
+		mTextureDataLookup.erase(textureData.get());
 
-				textureData->load(true);
-				// mManager->onTextureLoaded(textureData);
+		mProcessingTextureDataQ.push_back(textureData);
 
-				lock.lock();
-				mProcessingTextureDataQ.remove(textureData);
-				lock.unlock();
-			}
+		lock.unlock();
 
-			std::this_thread::yield();
+		if (textureData && !textureData->isLoaded())
+		{
+			PROFILE_SCOPE("TextureLoader::load");
+			textureData->load(true);
 		}
+
+		lock.lock();
+		mProcessingTextureDataQ.remove(textureData);
+		textureData->mLoadPending = false;
 	}
 }
 
@@ -304,8 +461,8 @@ void TextureLoader::load(std::shared_ptr<TextureData> textureData)
 {
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
-	// Make sure it's not already loaded
-	if (textureData->isLoaded())
+	// Make sure it's not already loaded, or unreadable
+	if (textureData->isLoaded() || textureData->hasLoadFailed())
 		return;
 
 	// If is is currently loading, don't add again
@@ -313,28 +470,84 @@ void TextureLoader::load(std::shared_ptr<TextureData> textureData)
 		return;
 
 	// Remove it from the queue if it is already there
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
-		mTextureDataQ.erase(tx);
+	removeLocked(textureData.get());
+
+	// Put it on the start of its queue as we want the newly requested textures to load first
+	TexturePriority::Level priority = textureData->mLoadPriority;
+	mTextureDataQ[priority].push_front(textureData);
+
+	QueueLocation location = { priority, mTextureDataQ[priority].begin() };
+	mTextureDataLookup[textureData.get()] = location;
+	textureData->mLoadPending = true;
 
-	// Put it on the start of the queue as we want the newly requested textures to load first
-	mTextureDataQ.push_front(textureData);
-	mEvent.notify_one();
+	// Bounded queue : drop the oldest requests of the lowest priority
+	for (int level = 0; level < TexturePriority::COUNT && queuedCount() > MAX_QUEUED_TEXTURES; level++)
+	{
+		while (!mTextureDataQ[level].empty() && queuedCount() > MAX_QUEUED_TEXTURES)
+		{
+			mTextureDataQ[level].back()->mLoadPending = false;
+			mTextureDataLookup.erase(mTextureDataQ[level].back().get());
+			mTextureDataQ[level].pop_back();
+		}
+	}
+
+	if (!mExit && mActiveWorkers < mMaxWorkers)
+	{
+		mActiveWorkers++;
+		Utils::ThreadPool::getInstance()->queueWorkItem([this] { threadProc(); });
+	}
+}
+
+bool TextureLoader::removeLocked(const TextureData* textureData)
+{
+	auto it = mTextureDataLookup.find(textureData);
+	if (it == mTextureDataLookup.cend())
+		return false;
+
+	(*it->second.position)->mLoadPending = false;
+	mTextureDataQ[it->second.priority].erase(it->second.position);
+	mTextureDataLookup.erase(it);
+	return true;
 }
 
 bool TextureLoader::remove(std::shared_ptr<TextureData> textureData)
+{
+	return remove(textureData.get());
+}
+
+bool TextureLoader::remove(const TextureData* textureData)
 {
 	// Just remove it from the queue so we don't attempt to load it
 	std::unique_lock<std::mutex> lock(mLoaderLock);
+	return removeLocked(textureData);
+}
+
+void TextureLoader::remove(const std::vector<const TextureData*>& textures)
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	for (auto textureData : textures)
+		removeLocked(textureData);
+}
 
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
+void TextureLoader::setPriority(const std::vector<const TextureData*>& textures, TexturePriority::Level priority)
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	for (auto textureData : textures)
 	{
-		mTextureDataQ.erase(tx);
-		return true;
-	}
+		auto it = mTextureDataLookup.find(textureData);
+		if (it == mTextureDataLookup.cend() || it->second.priority == priority)
+			continue;
+
+		// Moves the node, no allocation
+		TextureQueue& source = mTextureDataQ[it->second.priority];
+		TextureQueue& target = mTextureDataQ[priority];
+		target.splice(target.begin(), source, it->second.position);
 
-	return false;
+		it->second.priority = priority;
+		it->second.position = target.begin();
+	}
 }
 
 size_t TextureLoader::getQueueSize()
@@ -344,8 +557,9 @@ size_t TextureLoader::getQueueSize()
 	// Gets the amount of video memory that will be used once all textures in
 	// the queue are loaded
 	size_t mem = 0;
-	for (auto tex : mTextureDataQ)	
-		mem += tex->width() * tex->height() * 4;
+	for (auto& queue : mTextureDataQ)
+		for (auto tex : queue)
+			mem += tex->width() * tex->height() * 4;
 
 	return mem;
 }
@@ -355,7 +569,15 @@ void TextureLoader::clearQueue()
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
 	// Just abort any waiting texture
-	mTextureDataQ.clear();
+	for (auto& queue : mTextureDataQ)
+	{
+		for (auto& textureData : queue)
+			textureData->mLoadPending = false;
+
+		queue.clear();
+	}
+
+	mTextureDataLookup.clear();
 }
 
 void TextureDataManager::clearQueue()
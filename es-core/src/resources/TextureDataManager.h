@@ -2,11 +2,13 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 
+#include <atomic>
 #include <condition_variable>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <thread>
 #include <algorithm>
@@ -15,6 +17,43 @@ class TextureData;
 class TextureResource;
 class TextureDataManager;
 
+// Memory accounting classes. Each one can have its own budget (MaxVRAMTheme, MaxVRAMGameArt... settings in MB, 0 = none)
+namespace TextureClass
+{
+	enum Type : unsigned char
+	{
+		Theme = 0,   // theme & embedded resources
+		GameArt = 1, // images, thumbnails, marquees...
+		Font = 2,    // glyph atlases
+		Video = 3,   // video frames & other textures filled by their owner
+		COUNT = 4
+	};
+}
+
+// Asynchronous load priorities, highest first out of the loader queue
+namespace TexturePriority
+{
+	enum Level : unsigned char
+	{
+		Prefetch = 0, // not on screen yet (grid rows around the visible ones...)
+		Visible = 1,  // default
+		Selected = 2,
+		COUNT = 3
+	};
+}
+
+struct TextureMemoryStats
+{
+	size_t usage[TextureClass::COUNT];
+	size_t budget[TextureClass::COUNT];
+	size_t total;
+	size_t maxTotal;
+	unsigned int evictions;
+};
+
+// Loads textures on the shared thread pool. The queue is split by priority, and newly requested
+// textures are served first within a priority. It is bounded : past MAX_QUEUED_TEXTURES the oldest
+// requests of the lowest priority are dropped. They are queued again if they're still needed when drawn
 class TextureLoader
 {
 public:
@@ -23,6 +62,9 @@ public:
 
 	void load(std::shared_ptr<TextureData> textureData);
 	bool remove(std::shared_ptr<TextureData> textureData);
+	bool remove(const TextureData* textureData);
+	void remove(const std::vector<const TextureData*>& textures);
+	void setPriority(const std::vector<const TextureData*>& textures, TexturePriority::Level priority);
 	void clearQueue();
 
 	size_t getQueueSize();
@@ -30,15 +72,27 @@ public:
 private:	
 	void threadProc();
 
+	typedef std::list<std::shared_ptr<TextureData>> TextureQueue;
+
+	struct QueueLocation
+	{
+		TexturePriority::Level priority;
+		TextureQueue::iterator position;
+	};
+
+	bool removeLocked(const TextureData* textureData);
+	size_t queuedCount() const { return mTextureDataLookup.size(); }
+
 	std::list<std::shared_ptr<TextureData>> 										mProcessingTextureDataQ;
 
-	std::list<std::shared_ptr<TextureData>> 										mTextureDataQ;
-	std::map<TextureData*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureDataLookup;
+	TextureQueue 																	mTextureDataQ[TexturePriority::COUNT];
+	std::unordered_map<const TextureData*, QueueLocation>							mTextureDataLookup;
 
-	std::vector<std::thread>	mThreads;	
 	std::mutex					mLoaderLock;
 	std::condition_variable		mEvent;
 	bool 						mExit;
+	int							mActiveWorkers;
+	int							mMaxWorkers;
 
 	TextureDataManager*			mManager;
 };
@@ -57,6 +111,12 @@ private:
 // to releaseRAM() which frees the memory buffer if the texture can be reloaded from
 // disk if needed again
 //
+// Every TextureData reports its size to the per-class byte counters when it changes, so
+// checking the budgets costs nothing. Managed textures are kept in an intrusive LRU list
+// that get() updates in O(1), and update() releases them from the tail when a budget is
+// exceeded. GL textures can only be destroyed on the main thread, so that's where it runs,
+// on a low rate tick
+//
 class TextureDataManager
 {
 public:
@@ -70,31 +130,54 @@ public:
 	// will be deleted when the other thread has finished with it
 	void remove(const TextureResource* key);
 	void cancelAsync(const TextureResource* key);
+	void cancelAsync(const std::vector<const TextureResource*>& keys);
+	void setLoadPriority(const std::vector<const TextureResource*>& keys, TexturePriority::Level priority);
 
 	std::shared_ptr<TextureData> get(const TextureResource* key, bool enableLoading = true);
 	bool bind(const TextureResource* key);
 
 	// Get the total size of all textures managed by this object, loaded and unloaded in bytes
 	size_t	getTotalSize();
-	// Get the total size of all committed textures (in VRAM) in bytes
-	size_t	getCommittedSize();
-	// Get the total size of all load-pending textures in the queue - these will
-	// be committed to VRAM as the queue is processed
-	size_t  getQueueSize();
-	// Load a texture, freeing resources as necessary to make space
+	// Load a texture. Memory is reclaimed by update(), not here
 	void load(std::shared_ptr<TextureData> tex, bool block = false);
 
 	void clearQueue();
 
 	void onTextureLoaded(std::shared_ptr<TextureData> tex);
 
+	// Called once per frame from the main thread. Every EVICTION_INTERVAL ms the budgets are checked
+	// without locking, and when one is exceeded the least recently used textures are released until
+	// the usage is back under the low watermark
+	void update();
+
+	// Byte counters are maintained incrementally by the textures themselves
+	static void updateUsage(TextureClass::Type type, size_t oldSize, size_t newSize);
+	static TextureMemoryStats getStats();
+
 private:
+	// Intrusive LRU list, most recently used first. Protected by mMutex
+	void lruLink(TextureData* tex);
+	void lruUnlink(TextureData* tex);
+	void lruTouch(TextureData* tex);
+
+	size_t evict(TextureClass::Type type, size_t usage, size_t target);
+	static void updateBudgets();
+
 	std::mutex					mMutex;
 
-	std::list<std::shared_ptr<TextureData> >												mTextures;
-	std::map<const TextureResource*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureLookup;
-	std::shared_ptr<TextureData>															mBlank;
-	TextureLoader*																			mLoader;
+	std::unordered_map<const TextureResource*, std::shared_ptr<TextureData>>	mTextureLookup;
+	TextureData*																mLruHead;
+	TextureData*																mLruTail;
+	std::atomic<unsigned int>													mFrame;
+	unsigned int																mLastEvictionCheck; // SDL ticks, main thread only
+
+	std::shared_ptr<TextureData>	mBlank;
+	TextureLoader*					mLoader;
+
+	static std::atomic<size_t>			sUsage[TextureClass::COUNT];
+	static std::atomic<unsigned int>	sEvictions;
+	static std::atomic<size_t>			sBudget[TextureClass::COUNT];	// bytes, from the MaxVRAM* settings
+	static std::atomic<size_t>			sMaxTotal;
 };
 
 #endif // ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
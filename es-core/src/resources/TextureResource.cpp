@@ -1,16 +1,32 @@
 #include "resources/TextureResource.h"
 
+#include "math/Misc.h"
 #include "utils/FileSystemUtil.h"
+#include "resources/SvgImageCache.h"
 #include "resources/TextureData.h"
+#include "utils/StringUtil.h"
 #include "ImageIO.h"
 #include "Settings.h"
 #include <cstring>
+#include <nanosvg/nanosvg.h>
 
 TextureDataManager		TextureResource::sTextureDataManager;
 
 std::map< TextureResource::TextureKeyType, std::weak_ptr<TextureResource>> TextureResource::sTextureMap;
 std::set<TextureResource*> 	TextureResource::sAllTextures;
 
+// Theme assets are shared by every view, anything else loaded from a file is considered game art
+static TextureClass::Type getTextureClass(const std::string& path)
+{
+	if (path.empty())
+		return TextureClass::Video;
+
+	if (path[0] == ':' || path.find("/themes/") != std::string::npos)
+		return TextureClass::Theme;
+
+	return TextureClass::GameArt;
+}
+
 TextureResource::TextureResource(const std::string& path, bool tile, bool linear, bool dynamic, bool allowAsync, MaxSizeInfo maxSize) : mTextureData(nullptr), mForceLoad(false)
 {
 #if _DEBUG
@@ -26,6 +42,7 @@ TextureResource::TextureResource(const std::string& path, bool tile, bool linear
 		if (dynamic)
 		{			
 			data = sTextureDataManager.add(this, tile, linear);
+			data->setTextureClass(getTextureClass(path));
 			data->setMaxSize(maxSize);
 			data->initFromPath(path);
 
@@ -36,10 +53,24 @@ TextureResource::TextureResource(const std::string& path, bool tile, bool linear
 
 			unsigned int width, height;
 			
-			if (allowAsync && Settings::getInstance()->getBool("ThreadedLoading") && ImageIO::getImageSize(fullpath.c_str(), &width, &height))
+			if (allowAsync && Settings::getInstance()->getBool("ThreadedLoading"))
 			{
-				data->setTemporarySize(width, height);
-				async = true;
+				if (Utils::String::toLower(Utils::FileSystem::getExtension(path)) == ".svg")
+				{
+					// The parsed document gives the size, the rasterization is left to the loader threads
+					std::shared_ptr<NSVGimage> svgImage = SvgImageCache::getInstance()->get(path);
+					if (svgImage != nullptr && svgImage->width >= 1 && svgImage->height >= 1)
+					{
+						width = (unsigned int)Math::round(svgImage->width);
+						height = (unsigned int)Math::round(svgImage->height);
+						async = true;
+					}
+				}
+				else
+					async = ImageIO::getImageSize(fullpath.c_str(), &width, &height);
+
+				if (async)
+					data->setTemporarySize(width, height);
 			}
 		
 			// Force the texture manager to load it using a blocking load
@@ -61,6 +92,7 @@ TextureResource::TextureResource(const std::string& path, bool tile, bool linear
 			mTextureData = std::shared_ptr<TextureData>(new TextureData(tile, linear));
 			
 			data = mTextureData;
+			data->setTextureClass(TextureClass::Theme);
 			data->setMaxSize(maxSize);
 			data->initFromPath(path);
 			// Load it so we can read the width/height
@@ -74,6 +106,7 @@ TextureResource::TextureResource(const std::string& path, bool tile, bool linear
 	{
 		// Create a texture managed by this class because it cannot be dynamically loaded and unloaded
 		mTextureData = std::shared_ptr<TextureData>(new TextureData(tile, linear));
+		mTextureData->setTextureClass(TextureClass::Video);
 	}
 
 	if (sAllTextures.find(this) == sAllTextures.end())
@@ -170,6 +203,7 @@ bool TextureResource::bind()
 void TextureResource::resetCache()
 {
 	sTextureDataManager.clearQueue();
+	SvgImageCache::getInstance()->clear();
 }
 
 void TextureResource::cancelAsync(std::shared_ptr<TextureResource> texture)
@@ -178,6 +212,32 @@ void TextureResource::cancelAsync(std::shared_ptr<TextureResource> texture)
 		sTextureDataManager.cancelAsync(texture.get());
 }
 
+void TextureResource::cancelAsync(const std::vector<std::shared_ptr<TextureResource>>& textures)
+{
+	std::vector<const TextureResource*> keys;
+	keys.reserve(textures.size());
+
+	for (auto& texture : textures)
+		if (texture != nullptr && texture->mTextureData == nullptr)
+			keys.push_back(texture.get());
+
+	if (keys.size())
+		sTextureDataManager.cancelAsync(keys);
+}
+
+void TextureResource::setLoadPriority(const std::vector<std::shared_ptr<TextureResource>>& textures, TexturePriority::Level priority)
+{
+	std::vector<const TextureResource*> keys;
+	keys.reserve(textures.size());
+
+	for (auto& texture : textures)
+		if (texture != nullptr && texture->mTextureData == nullptr)
+			keys.push_back(texture.get());
+
+	if (keys.size())
+		sTextureDataManager.setLoadPriority(keys, priority);
+}
+
 std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, bool tile, bool linear, bool forceLoad, bool dynamic, bool asReloadable, MaxSizeInfo maxSize)
 {
 	std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
@@ -287,20 +347,25 @@ bool TextureResource::isLoaded() const
 	return true;
 }
 
+bool TextureResource::isLoading() const
+{
+	// Not managed : loaded synchronously
+	if (mTextureData != nullptr)
+		return false;
+
+	auto data = sTextureDataManager.get(this, false);
+	return data != nullptr && data->isLoadPending();
+}
+
 size_t TextureResource::getTotalMemUsage()
 {
-	size_t total = 0;
-	// Count up all textures that manage their own texture data
-	for (auto tex : sAllTextures)
-	{
-		if (tex->mTextureData != nullptr)
-			total += tex->mTextureData->getVRAMUsage();
-	}
-	// Now get the committed memory from the manager
-	total += sTextureDataManager.getCommittedSize();
-	// And the size of the loading queue
-	total += sTextureDataManager.getQueueSize();
-	return total;
+	// Textures report their size themselves, fonts excluded
+	return TextureDataManager::getStats().total;
+}
+
+void TextureResource::update()
+{
+	sTextureDataManager.update();
 }
 
 size_t TextureResource::getTotalTextureSize()
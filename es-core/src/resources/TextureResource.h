@@ -53,6 +53,9 @@ protected:
 public:
 	static std::shared_ptr<TextureResource> get(const std::string& path, bool tile = false, bool linear = false, bool forceLoad = false, bool dynamic = true, bool asReloadable = true, MaxSizeInfo maxSize = MaxSizeInfo());
 	static void cancelAsync(std::shared_ptr<TextureResource> texture);
+	// Batch versions, for components that recycle many textures at once (grids...)
+	static void cancelAsync(const std::vector<std::shared_ptr<TextureResource>>& textures);
+	static void setLoadPriority(const std::vector<std::shared_ptr<TextureResource>>& textures, TexturePriority::Level priority);
 
 	void initFromPixels(const unsigned char* dataRGBA, size_t width, size_t height);
 	void initFromExternalPixels(unsigned char* dataRGBA, size_t width, size_t height);
@@ -65,6 +68,7 @@ public:
 	virtual ~TextureResource();
 
 	bool isLoaded() const;
+	bool isLoading() const; // an asynchronous load is queued or running
 	bool isTiled() const;
 
 	const Vector2i getSize() const;
@@ -74,6 +78,9 @@ public:
 	static size_t getTotalTextureSize(); // returns the number of bytes that would be used if all textures were in memory
 	static void resetCache();
 
+	// Enforces the texture memory budgets. Must be called from the main thread, once per frame
+	static void update();
+
 public:
 	virtual bool unload();
 	virtual void reload();
@@ -0,0 +1,586 @@
+#include "resources/ThumbnailCache.h"
+
+#include "resources/ResourceManager.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/ThreadPool.h"
+#include "ImageIO.h"
+#include "Log.h"
+#include "Settings.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define THUMBNAIL_CACHE_MAGIC	0x43545345 // "ESTC"
+#define THUMBNAIL_CACHE_VERSION	1
+
+#define MAX_TARGETS				4
+#define WARMUP_TARGETS			2
+#define WARMUP_MIN_USES			8 // a size must have been requested that many times to be warmed up (grid tiles, not backgrounds)
+
+namespace
+{
+	struct ThumbnailHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int width;      // 0 : the source doesn't need to be scaled at this size
+		unsigned int height;
+		unsigned int baseWidth;
+		unsigned int baseHeight;
+		unsigned long long sourceSize;
+		long long sourceTime;
+		long long sourceTimeNs;
+		unsigned int pathLength;
+		unsigned int pad;
+	};
+
+	long long now()
+	{
+		return (long long)time(nullptr);
+	}
+
+	bool readFully(int fd, void* buffer, size_t size)
+	{
+		unsigned char* ptr = (unsigned char*)buffer;
+		while (size > 0)
+		{
+			ssize_t count = read(fd, ptr, size);
+			if (count <= 0)
+				return false;
+
+			ptr += count;
+			size -= count;
+		}
+
+		return true;
+	}
+}
+
+ThumbnailCache* ThumbnailCache::getInstance()
+{
+	static ThumbnailCache* instance = new ThumbnailCache();
+	return instance;
+}
+
+ThumbnailCache::ThumbnailCache() : mIndexLoaded(false), mTotalSize(0), mWarmupRunning(false)
+{
+	mFolder = Utils::FileSystem::getEsConfigPath() + "/cache/thumbnails";
+}
+
+bool ThumbnailCache::isCacheable(const std::string& path)
+{
+	// Only real files : embedded resources are small & already in memory
+	if (path.empty() || path[0] != '/')
+		return false;
+
+	return Settings::getInstance()->getInt("ThumbnailCacheSize") > 0;
+}
+
+unsigned long long ThumbnailCache::getKey(const std::string& path, const Target& target)
+{
+	// FNV-1a
+	unsigned long long hash = 14695981039346656037ULL;
+
+	for (auto c : path)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ULL;
+	}
+
+	// Raster entries are flagged in the external zoom value, the keys of the scaled pictures are unchanged
+	unsigned int values[3] = { (unsigned int)target.maxWidth, (unsigned int)target.maxHeight, (target.externalZoom ? 1u : 0u) | (target.raster ? 2u : 0u) };
+	for (auto value : values)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 1099511628211ULL;
+		}
+	}
+
+	return hash;
+}
+
+std::string ThumbnailCache::getEntryPath(unsigned long long key)
+{
+	char name[24];
+	snprintf(name, sizeof(name), "%016llx.tex", key);
+	return mFolder + "/" + name;
+}
+
+void ThumbnailCache::loadIndex()
+{
+	if (mIndexLoaded)
+		return;
+
+	mIndexLoaded = true;
+
+	DIR* dir = opendir(mFolder.c_str());
+	if (dir == nullptr)
+		return;
+
+	struct dirent* entry;
+	while ((entry = readdir(dir)) != nullptr)
+	{
+		const char* name = entry->d_name;
+		if (strlen(name) != 20 || strcmp(name + 16, ".tex") != 0)
+			continue;
+
+		std::string path = mFolder + "/" + name;
+
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0)
+			continue;
+
+		unsigned long long key = strtoull(std::string(name, 16).c_str(), nullptr, 16);
+
+		Entry& item = mEntries[key];
+		item.size = (size_t)info.st_size;
+		item.lastUse = (long long)info.st_mtime;
+		item.used = false;
+		mTotalSize += item.size;
+	}
+
+	closedir(dir);
+}
+
+void ThumbnailCache::noteTarget(const Target& target)
+{
+	for (auto& item : mTargets)
+	{
+		if (item.target == target)
+		{
+			item.uses++;
+
+			if (item.uses == WARMUP_MIN_USES && !mWarmupRunning && !mWarmupQueue.empty())
+			{
+				mWarmupRunning = true;
+				Utils::ThreadPool::getInstance()->queueWorkItem([this] { processWarmup(); });
+			}
+
+			return;
+		}
+	}
+
+	TargetUse use = { target, 1 };
+
+	if (mTargets.size() < MAX_TARGETS)
+		mTargets.push_back(use);
+	else
+	{
+		auto leastUsed = std::min_element(mTargets.begin(), mTargets.end(), [](const TargetUse& a, const TargetUse& b) { return a.uses < b.uses; });
+		*leastUsed = use;
+	}
+}
+
+bool ThumbnailCache::hasWarmupTarget()
+{
+	for (auto& item : mTargets)
+		if (item.uses >= WARMUP_MIN_USES)
+			return true;
+
+	return false;
+}
+
+unsigned char* ThumbnailCache::load(const std::string& path, int maxWidth, int maxHeight, bool externalZoom, size_t& width, size_t& height, Vector2i& baseSize, size_t& sourceLength)
+{
+	if (maxWidth <= 0 || maxHeight <= 0 || !isCacheable(path))
+		return nullptr;
+
+	Target target = { maxWidth, maxHeight, externalZoom, false };
+
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		noteTarget(target);
+	}
+
+	return read(path, target, width, height, baseSize, sourceLength);
+}
+
+unsigned char* ThumbnailCache::loadRaster(const std::string& path, size_t width, size_t height)
+{
+	if (width == 0 || height == 0 || !isCacheable(path))
+		return nullptr;
+
+	Target target = { (int)width, (int)height, false, true };
+
+	size_t entryWidth, entryHeight, sourceLength;
+	Vector2i baseSize;
+
+	unsigned char* data = read(path, target, entryWidth, entryHeight, baseSize, sourceLength);
+	if (data != nullptr && (entryWidth != width || entryHeight != height))
+	{
+		delete[] data;
+		return nullptr;
+	}
+
+	return data;
+}
+
+unsigned char* ThumbnailCache::read(const std::string& path, const Target& target, size_t& width, size_t& height, Vector2i& baseSize, size_t& sourceLength)
+{
+	unsigned long long key = getKey(path, target);
+
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		loadIndex();
+
+		if (mEntries.find(key) == mEntries.cend())
+		{
+			mStats.misses++;
+			return nullptr;
+		}
+	}
+
+	struct stat sourceInfo;
+	if (stat(path.c_str(), &sourceInfo) != 0)
+		return nullptr;
+
+	std::string entryPath = getEntryPath(key);
+
+	int fd = open(entryPath.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		auto it = mEntries.find(key);
+		if (it != mEntries.cend())
+		{
+			mTotalSize -= it->second.size;
+			mEntries.erase(it);
+		}
+
+		mStats.misses++;
+		return nullptr;
+	}
+
+	ThumbnailHeader header;
+	std::string storedPath;
+
+	bool valid = readFully(fd, &header, sizeof(ThumbnailHeader)) &&
+		header.magic == THUMBNAIL_CACHE_MAGIC && header.version == THUMBNAIL_CACHE_VERSION &&
+		header.sourceSize == (unsigned long long)sourceInfo.st_size &&
+		header.sourceTime == (long long)sourceInfo.st_mtim.tv_sec && header.sourceTimeNs == (long long)sourceInfo.st_mtim.tv_nsec &&
+		header.pathLength == path.size();
+
+	if (valid)
+	{
+		storedPath.resize(header.pathLength);
+		valid = readFully(fd, &storedPath[0], header.pathLength) && storedPath == path;
+	}
+
+	unsigned char* data = nullptr;
+
+	if (valid && header.width > 0 && header.height > 0)
+	{
+		size_t size = (size_t)header.width * header.height * 4;
+		data = new unsigned char[size];
+
+		if (!readFully(fd, data, size))
+		{
+			delete[] data;
+			data = nullptr;
+			valid = false;
+		}
+	}
+
+	close(fd);
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	if (!valid)
+	{
+		// Outdated or damaged
+		unlink(entryPath.c_str());
+
+		auto it = mEntries.find(key);
+		if (it != mEntries.cend())
+		{
+			mTotalSize -= it->second.size;
+			mEntries.erase(it);
+		}
+
+		mStats.misses++;
+		return nullptr;
+	}
+
+	if (data == nullptr)
+		return nullptr;
+
+	// LRU : written to the file lazily, don't touch the SD card for every picture shown
+	auto it = mEntries.find(key);
+	if (it != mEntries.end())
+	{
+		it->second.lastUse = now();
+		it->second.used = true;
+	}
+
+	mStats.hits++;
+
+	width = header.width;
+	height = header.height;
+	baseSize = Vector2i(header.baseWidth, header.baseHeight);
+	sourceLength = (size_t)header.sourceSize;
+	return data;
+}
+
+void ThumbnailCache::save(const std::string& path, int maxWidth, int maxHeight, bool externalZoom, const unsigned char* data, size_t width, size_t height, const Vector2i& baseSize, const Vector2i& packedSize)
+{
+	if (maxWidth <= 0 || maxHeight <= 0 || !isCacheable(path))
+		return;
+
+	Target target = { maxWidth, maxHeight, externalZoom, false };
+	queueWrite(path, target, packedSize != Vector2i(0, 0) ? data : nullptr, width, height, baseSize);
+}
+
+void ThumbnailCache::saveRaster(const std::string& path, const unsigned char* data, size_t width, size_t height)
+{
+	if (width == 0 || height == 0 || data == nullptr || !isCacheable(path))
+		return;
+
+	Target target = { (int)width, (int)height, false, true };
+	queueWrite(path, target, data, width, height, Vector2i((int)width, (int)height));
+}
+
+void ThumbnailCache::queueWrite(const std::string& path, const Target& target, const unsigned char* data, size_t width, size_t height, const Vector2i& baseSize)
+{
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		loadIndex();
+
+		if (mEntries.find(getKey(path, target)) != mEntries.cend())
+			return;
+	}
+
+	std::shared_ptr<std::vector<unsigned char>> copy;
+	if (data != nullptr)
+		copy = std::make_shared<std::vector<unsigned char>>(data, data + width * height * 4);
+	else
+		width = height = 0;
+
+	Utils::ThreadPool::getInstance()->queueWorkItem([this, path, target, copy, width, height, baseSize]
+	{
+		write(path, target, copy ? copy->data() : nullptr, width, height, baseSize);
+	});
+}
+
+void ThumbnailCache::write(const std::string& path, const Target& target, const unsigned char* data, size_t width, size_t height, const Vector2i& baseSize)
+{
+	struct stat sourceInfo;
+	if (stat(path.c_str(), &sourceInfo) != 0)
+		return;
+
+	unsigned long long key = getKey(path, target);
+	std::string entryPath = getEntryPath(key);
+
+	// Unique per writer : two workers can thumbnail the same picture at the same time
+	std::string tmpFile = entryPath + ".XXXXXX";
+
+	if (!Utils::FileSystem::exists(mFolder))
+		Utils::FileSystem::createDirectory(mFolder);
+
+	ThumbnailHeader header;
+	memset(&header, 0, sizeof(ThumbnailHeader));
+	header.magic = THUMBNAIL_CACHE_MAGIC;
+	header.version = THUMBNAIL_CACHE_VERSION;
+	header.width = data == nullptr ? 0 : (unsigned int)width;
+	header.height = data == nullptr ? 0 : (unsigned int)height;
+	header.baseWidth = baseSize.x();
+	header.baseHeight = baseSize.y();
+	header.sourceSize = (unsigned long long)sourceInfo.st_size;
+	header.sourceTime = (long long)sourceInfo.st_mtim.tv_sec;
+	header.sourceTimeNs = (long long)sourceInfo.st_mtim.tv_nsec;
+	header.pathLength = (unsigned int)path.size();
+
+	int fd = mkstemp(&tmpFile[0]);
+	FILE* file = fd < 0 ? nullptr : fdopen(fd, "wb");
+	if (file == nullptr)
+	{
+		LOG(LogWarning) << "ThumbnailCache : unable to write " << tmpFile;
+
+		if (fd >= 0)
+		{
+			close(fd);
+			unlink(tmpFile.c_str());
+		}
+
+		return;
+	}
+
+	size_t pixelSize = data == nullptr ? 0 : width * height * 4;
+
+	bool ok = fwrite(&header, sizeof(ThumbnailHeader), 1, file) == 1;
+	if (ok)
+		ok = fwrite(path.data(), 1, path.size(), file) == path.size();
+	if (ok && pixelSize > 0)
+		ok = fwrite(data, 1, pixelSize, file) == pixelSize;
+
+	ok = (fclose(file) == 0) && ok;
+
+	if (!ok || std::rename(tmpFile.c_str(), entryPath.c_str()) != 0)
+	{
+		LOG(LogWarning) << "ThumbnailCache : unable to write " << entryPath;
+		unlink(tmpFile.c_str());
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	Entry& entry = mEntries[key];
+	mTotalSize -= entry.size;
+	entry.size = sizeof(ThumbnailHeader) + path.size() + pixelSize;
+	entry.lastUse = now();
+	entry.used = false;
+	mTotalSize += entry.size;
+
+	evict();
+}
+
+void ThumbnailCache::evict()
+{
+	size_t maxSize = (size_t)Settings::getInstance()->getInt("ThumbnailCacheSize") * 1024 * 1024;
+	if (mTotalSize <= maxSize)
+		return;
+
+	// Drop the least recently used entries until we're back to 90% of the budget, so we don't evict on every write
+	size_t targetSize = maxSize / 10 * 9;
+
+	std::vector<std::pair<long long, unsigned long long>> entries;
+	entries.reserve(mEntries.size());
+	for (auto& item : mEntries)
+		entries.push_back(std::make_pair(item.second.lastUse, item.first));
+
+	std::sort(entries.begin(), entries.end());
+
+	for (auto& item : entries)
+	{
+		if (mTotalSize <= targetSize)
+			break;
+
+		auto it = mEntries.find(item.second);
+		unlink(getEntryPath(item.second).c_str());
+		mTotalSize -= it->second.size;
+		mEntries.erase(it);
+	}
+
+	writeLastUses();
+}
+
+void ThumbnailCache::writeLastUses()
+{
+	for (auto& item : mEntries)
+	{
+		if (!item.second.used)
+			continue;
+
+		struct timespec times[2];
+		times[0].tv_sec = times[1].tv_sec = (time_t)item.second.lastUse;
+		times[0].tv_nsec = times[1].tv_nsec = 0;
+
+		utimensat(AT_FDCWD, getEntryPath(item.first).c_str(), times, 0);
+		item.second.used = false;
+	}
+}
+
+void ThumbnailCache::flush()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	writeLastUses();
+}
+
+void ThumbnailCache::warmup(const std::vector<std::string>& paths)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	mWarmupQueue.clear();
+	for (auto& path : paths)
+		if (isCacheable(path))
+			mWarmupQueue.push_back(path);
+
+	if (mWarmupRunning || mWarmupQueue.empty() || !hasWarmupTarget())
+		return;
+
+	mWarmupRunning = true;
+	Utils::ThreadPool::getInstance()->queueWorkItem([this] { processWarmup(); });
+}
+
+void ThumbnailCache::processWarmup()
+{
+	// Runs on a single worker : the warmup must not compete with the textures that are actually displayed
+	while (true)
+	{
+		std::string path;
+		std::vector<Target> targets;
+
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+
+			if (mWarmupQueue.empty() || !hasWarmupTarget())
+			{
+				mWarmupRunning = false;
+				return;
+			}
+
+			path = mWarmupQueue.front();
+			mWarmupQueue.pop_front();
+
+			loadIndex();
+
+			std::vector<TargetUse> uses = mTargets;
+			std::sort(uses.begin(), uses.end(), [](const TargetUse& a, const TargetUse& b) { return a.uses > b.uses; });
+
+			for (auto& item : uses)
+				if (item.uses >= WARMUP_MIN_USES && targets.size() < WARMUP_TARGETS && mEntries.find(getKey(path, item.target)) == mEntries.cend())
+					targets.push_back(item.target);
+		}
+
+		if (targets.empty())
+			continue;
+
+		const ResourceData data = ResourceManager::getInstance()->getFileData(path);
+		if (data.ptr == nullptr)
+			continue;
+
+		for (auto& target : targets)
+		{
+			size_t width, height;
+			Vector2i baseSize, packedSize;
+
+			unsigned char* imageRGBA = ImageIO::loadFromMemoryRGBA32Ex(data.ptr.get(), data.length, width, height, target.maxWidth, target.maxHeight, target.externalZoom, baseSize, packedSize);
+			if (imageRGBA == nullptr)
+				break;
+
+			write(path, target, packedSize == Vector2i(0, 0) ? nullptr : imageRGBA, width, height, baseSize);
+			delete[] imageRGBA;
+		}
+	}
+}
+
+void ThumbnailCache::clear()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	loadIndex();
+
+	for (auto& item : mEntries)
+		unlink(getEntryPath(item.first).c_str());
+
+	mEntries.clear();
+	mTotalSize = 0;
+}
+
+ThumbnailCache::Stats ThumbnailCache::getStats()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	Stats stats = mStats;
+	stats.entries = (unsigned int)mEntries.size();
+	stats.bytes = mTotalSize;
+	return stats;
+}
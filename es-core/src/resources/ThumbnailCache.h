@@ -0,0 +1,114 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+#define ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+
+#include "math/Vector2i.h"
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// On-disk cache of downscaled images, stored in [ES config path]/cache/thumbnails
+//
+// When a picture is bigger than the size it will be displayed at, TextureData decodes it and resizes
+// it to fit. The result is saved here as a raw RGBA buffer, so the next time the same picture is needed
+// at the same size, the file is read as-is instead of being decoded & resized again.
+//
+// An entry is keyed on the source path and the target size, and remembers the size & modification time
+// of the source so it is dropped when the picture changes. Pictures that don't need to be scaled get an
+// empty entry, so they are not decoded again by the warmup.
+// The total size is bounded by the ThumbnailCacheSize setting (MB), the least recently used entries go first.
+// Uses are tracked in memory, and only written to the files' modification times on eviction and at exit.
+class ThumbnailCache
+{
+public:
+	struct Stats
+	{
+		Stats() : hits(0), misses(0), entries(0), bytes(0) { }
+
+		unsigned int hits;
+		unsigned int misses;
+		unsigned int entries;
+		size_t bytes;
+	};
+
+	static ThumbnailCache* getInstance();
+
+	// Returns the cached RGBA buffer (allocated with new[]) or nullptr.
+	// baseSize receives the size of the source picture & sourceLength the size of the source file
+	unsigned char* load(const std::string& path, int maxWidth, int maxHeight, bool externalZoom, size_t& width, size_t& height, Vector2i& baseSize, size_t& sourceLength);
+
+	// Saves a copy of a decoded picture in background. A null packedSize means the picture was not scaled
+	void save(const std::string& path, int maxWidth, int maxHeight, bool externalZoom, const unsigned char* data, size_t width, size_t height, const Vector2i& baseSize, const Vector2i& packedSize);
+
+	// Rasterized vector pictures, stored at their exact size. They don't take part in the warmup
+	unsigned char* loadRaster(const std::string& path, size_t width, size_t height);
+	void saveRaster(const std::string& path, const unsigned char* data, size_t width, size_t height);
+
+	// Builds the missing entries for these pictures in background, at the sizes textures were recently requested at.
+	// Replaces the pictures of a previous warmup that are not processed yet
+	void warmup(const std::vector<std::string>& paths);
+
+	void clear();
+
+	// Writes the last use of the entries read since the last flush (the modification time of their file). Called at exit
+	void flush();
+
+	Stats getStats();
+
+private:
+	ThumbnailCache();
+
+	struct Target
+	{
+		int maxWidth;
+		int maxHeight;
+		bool externalZoom;
+		bool raster; // exact size of a rasterized SVG
+
+		bool operator==(const Target& other) const { return maxWidth == other.maxWidth && maxHeight == other.maxHeight && externalZoom == other.externalZoom && raster == other.raster; }
+	};
+
+	struct TargetUse
+	{
+		Target target;
+		unsigned int uses;
+	};
+
+	struct Entry
+	{
+		size_t size;
+		long long lastUse;
+		bool used; // lastUse is newer than the file's modification time
+	};
+
+	bool isCacheable(const std::string& path);
+	void loadIndex();
+	void noteTarget(const Target& target);
+	bool hasWarmupTarget();
+	unsigned char* read(const std::string& path, const Target& target, size_t& width, size_t& height, Vector2i& baseSize, size_t& sourceLength);
+	void queueWrite(const std::string& path, const Target& target, const unsigned char* data, size_t width, size_t height, const Vector2i& baseSize);
+	void write(const std::string& path, const Target& target, const unsigned char* data, size_t width, size_t height, const Vector2i& baseSize);
+	void evict();
+	void writeLastUses();
+	void processWarmup();
+
+	static unsigned long long getKey(const std::string& path, const Target& target);
+	std::string getEntryPath(unsigned long long key);
+
+	std::mutex mLock;
+	std::string mFolder;
+	bool mIndexLoaded;
+
+	std::unordered_map<unsigned long long, Entry> mEntries;
+	size_t mTotalSize;
+	Stats mStats;
+
+	std::vector<TargetUse> mTargets; // sizes textures were requested at, with their request count
+
+	std::deque<std::string> mWarmupQueue;
+	bool mWarmupRunning;
+};
+
+#endif // ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
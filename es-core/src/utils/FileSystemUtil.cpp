@@ -9,8 +9,14 @@
 #include <string.h>
 #include "platform.h"
 
+#include <algorithm>
+#include <atomic>
 #include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <thread>
 #include <unistd.h>
+#include <unordered_map>
 #include <mutex>
 
 #include <fstream>
@@ -78,7 +84,7 @@ namespace Utils
 		
 		struct FileCache
 		{
-			FileCache() {}
+			FileCache() : exists(false), directory(false), hidden(false), isSymLink(false) {}
 
 			FileCache(bool _exists, bool _dir) 
 			{
@@ -109,91 +115,428 @@ namespace Utils
 			bool hidden;
 			bool isSymLink;
 
-			static int fromStat64(const std::string& key, struct stat64* info)
+			static int fromStat64(const std::string& key, struct stat64* info);
+			static bool beginRead(const std::string& dir, unsigned int& generation);
+			static void add(const std::string& key, FileCache cache, unsigned int generation);
+			static bool get(const std::string& key, FileCache& cache);
+			static void setDirectoryComplete(const std::string& path, unsigned int generation);
+			static void invalidate(const std::string& key);
+			static void resetCache();
+		};
+
+		// Entries are grouped by directory, and directories are spread over shards by hash, each with its own lock.
+		// A directory whose whole listing was read is "complete" : any name missing from it is known not to exist.
+		// Within a FileSystemCacheActivator scope everything is cached. In persistent mode, directories watched
+		// with inotify stay cached for the process lifetime and are invalidated when their content changes.
+		// The watch is added by beginRead, before the directory is read or stat'ed, and what was read is only kept
+		// if no change was reported in between (the bucket generation is the same).
+		namespace
+		{
+			#define FILECACHE_SHARDS 16
+
+			std::atomic<unsigned int> sGeneration(0);
+
+			// Never 0, which means "not cached"
+			inline unsigned int nextGeneration()
+			{
+				unsigned int generation = ++sGeneration;
+				return generation == 0 ? ++sGeneration : generation;
+			}
+
+			struct DirBucket
+			{
+				DirBucket() : complete(false), watch(-1), generation(nextGeneration()) { }
+
+				bool complete;
+				int  watch; // inotify watch descriptor, -1 : not watched yet, -2 : can't be watched
+				unsigned int generation; // changes with every reported change
+				std::unordered_map<std::string, FileCache> entries; // by file name
+			};
+
+			struct FileCacheShard
 			{
-				int ret = stat64(key.c_str(), info);
+				std::mutex lock;
+				std::unordered_map<std::string, DirBucket> dirs;
+			};
+
+			FileCacheShard sShards[FILECACHE_SHARDS];
 
-				std::unique_lock<std::mutex> lock(mFileCacheMutex);
+			std::atomic<int>  sActivatorCount(0);
+			std::atomic<bool> sPersistent(false);
 
-				FileCache cache(ret == 0, false);
-				if (cache.exists)
+			std::atomic<unsigned long long> sHits(0);
+			std::atomic<unsigned long long> sNegativeHits(0);
+			std::atomic<unsigned long long> sMisses(0);
+			std::atomic<unsigned long long> sStatCalls(0);
+			std::atomic<unsigned long long> sDirReads(0);
+
+			int                  sInotifyFd = -1;
+			std::thread          sWatcherThread;
+			std::atomic<bool>    sWatcherRunning(false);
+			std::mutex           sWatchLock;
+			std::unordered_map<int, std::vector<std::string>> sWatchedDirs;
+
+			inline FileCacheShard& getShard(const std::string& dir)
+			{
+				return sShards[std::hash<std::string>()(dir) % FILECACHE_SHARDS];
+			}
+
+			// Split without allocating once the thread local buffers are warm
+			inline bool splitPath(const std::string& key, std::string& dir, std::string& name)
+			{
+				size_t slash = key.rfind('/');
+				if (slash == std::string::npos || slash == key.size() - 1)
+					return false;
+
+				dir.assign(key, 0, slash == 0 ? 1 : slash);
+				name.assign(key, slash + 1, std::string::npos);
+				return true;
+			}
+
+			// Called with the shard locked. Returns true if entries of this directory may be cached
+			bool canCache(const std::string& dir, DirBucket& bucket)
+			{
+				if (sPersistent)
 				{
-					cache.directory = S_ISDIR(info->st_mode);
-					cache.isSymLink = S_ISLNK(info->st_mode);
+					// Pseudo file systems don't reliably report their changes
+					if (bucket.watch == -1 && (Utils::String::startsWith(dir, "/sys") || Utils::String::startsWith(dir, "/proc") || Utils::String::startsWith(dir, "/dev")))
+						bucket.watch = -2;
+
+					if (bucket.watch == -1)
+					{
+						bucket.watch = inotify_add_watch(sInotifyFd, dir.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+						if (bucket.watch < 0)
+							bucket.watch = -2;
+						else
+						{
+							std::unique_lock<std::mutex> lock(sWatchLock);
+							auto& dirs = sWatchedDirs[bucket.watch];
+							if (std::find(dirs.cbegin(), dirs.cend(), dir) == dirs.cend())
+								dirs.push_back(dir);
+						}
+					}
+
+					if (bucket.watch >= 0)
+						return true;
 				}
 
-				mFileCache[key] = cache;
+				return sActivatorCount > 0;
+			}
 
-				return ret;
+			void dropDirectory(const std::string& dir)
+			{
+				FileCacheShard& shard = getShard(dir);
+				std::unique_lock<std::mutex> lock(shard.lock);
+				shard.dirs.erase(dir);
+			}
+
+			void onFileChanged(const std::string& dir, const std::string& name, bool isDir)
+			{
+				{
+					FileCacheShard& shard = getShard(dir);
+					std::unique_lock<std::mutex> lock(shard.lock);
+
+					auto it = shard.dirs.find(dir);
+					if (it != shard.dirs.end())
+					{
+						it->second.entries.erase(name);
+						it->second.complete = false;
+						it->second.generation = nextGeneration();
+					}
+				}
+
+				if (isDir)
+					dropDirectory(dir == "/" ? "/" + name : dir + "/" + name);
 			}
 
-			static void add(const std::string& key, FileCache cache)
+			void watcherProc()
 			{
-				if (!mEnabled)
-					return;
+				char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+				while (sWatcherRunning)
+				{
+					struct pollfd pfd = { sInotifyFd, POLLIN, 0 };
+					if (poll(&pfd, 1, 250) <= 0)
+						continue;
 
-				std::unique_lock<std::mutex> lock(mFileCacheMutex);
-				mFileCache[key] = cache;
+					ssize_t len = read(sInotifyFd, buffer, sizeof(buffer));
+					if (len <= 0)
+						continue;
+
+					for (char* ptr = buffer; ptr < buffer + len; )
+					{
+						const struct inotify_event* event = (const struct inotify_event*)ptr;
+						ptr += sizeof(struct inotify_event) + event->len;
+
+						if (event->mask & IN_Q_OVERFLOW)
+						{
+							// Events were lost : nothing can be trusted anymore
+							FileCache::resetCache();
+							continue;
+						}
+
+						std::vector<std::string> dirs;
+
+						{
+							std::unique_lock<std::mutex> lock(sWatchLock);
+							auto it = sWatchedDirs.find(event->wd);
+							if (it == sWatchedDirs.cend())
+								continue;
+
+							dirs = it->second;
+
+							if (event->mask & IN_IGNORED)
+								sWatchedDirs.erase(it);
+						}
+
+						for (auto& dir : dirs)
+						{
+							if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+								dropDirectory(dir);
+							else if (event->len > 0)
+								onFileChanged(dir, event->name, (event->mask & IN_ISDIR) != 0);
+						}
+					}
+				}
 			}
+		}
+
+		int FileCache::fromStat64(const std::string& key, struct stat64* info)
+		{
+			static thread_local std::string dir, name;
+			unsigned int generation = 0;
+			bool cache = splitPath(key, dir, name) && beginRead(dir, generation);
 
-			static FileCache* get(const std::string& key)
+			int ret = stat64(key.c_str(), info);
+			sStatCalls++;
+
+			if (!cache)
+				return ret;
+
+			FileCache entry(ret == 0, false);
+			if (entry.exists)
 			{
-				if (!mEnabled)
-					return nullptr;
+				entry.directory = S_ISDIR(info->st_mode);
+				entry.isSymLink = S_ISLNK(info->st_mode);
+			}
+
+			add(key, entry, generation);
+
+			return ret;
+		}
+
+		// To call before reading or stat'ing the content of dir. False if it can't be cached
+		bool FileCache::beginRead(const std::string& dir, unsigned int& generation)
+		{
+			if (!sPersistent && sActivatorCount == 0)
+				return false;
+
+			FileCacheShard& shard = getShard(dir);
+			std::unique_lock<std::mutex> lock(shard.lock);
+
+			DirBucket& bucket = shard.dirs[dir];
+			if (!canCache(dir, bucket))
+				return false;
+
+			generation = bucket.generation;
+			return true;
+		}
+
+		void FileCache::add(const std::string& key, FileCache cache, unsigned int generation)
+		{
+			if (!sPersistent && sActivatorCount == 0)
+				return;
+
+			static thread_local std::string dir, name;
+			if (!splitPath(key, dir, name))
+				return;
+
+			FileCacheShard& shard = getShard(dir);
+			std::unique_lock<std::mutex> lock(shard.lock);
+
+			auto it = shard.dirs.find(dir);
+			if (it != shard.dirs.end() && it->second.generation == generation && canCache(dir, it->second))
+				it->second.entries[name] = cache;
+		}
 
-				std::unique_lock<std::mutex> lock(mFileCacheMutex);
+		bool FileCache::get(const std::string& key, FileCache& cache)
+		{
+			if (!sPersistent && sActivatorCount == 0)
+				return false;
+
+			static thread_local std::string dir, name;
+			if (!splitPath(key, dir, name))
+				return false;
 
-				auto it = mFileCache.find(key);
-				if (it != mFileCache.cend())
-					return &it->second;
+			FileCacheShard& shard = getShard(dir);
+			std::unique_lock<std::mutex> lock(shard.lock);
 
-				it = mFileCache.find(Utils::FileSystem::getParent(key)+"/*");
-				if (it != mFileCache.cend())
+			auto it = shard.dirs.find(dir);
+			if (it != shard.dirs.end())
+			{
+				auto entry = it->second.entries.find(name);
+				if (entry != it->second.entries.cend())
 				{
-					mFileCache[key] = FileCache(false, false);
-					return &mFileCache[key];
-				}				
+					cache = entry->second;
+					sHits++;
+					return true;
+				}
 
-				return nullptr;
+				if (it->second.complete)
+				{
+					// Not in a complete listing : doesn't exist
+					cache = FileCache(false, false);
+					it->second.entries[name] = cache;
+					sNegativeHits++;
+					return true;
+				}
 			}
 
-			static void resetCache()
+			sMisses++;
+			return false;
+		}
+
+		void FileCache::setDirectoryComplete(const std::string& path, unsigned int generation)
+		{
+			if (!sPersistent && sActivatorCount == 0)
+				return;
+
+			FileCacheShard& shard = getShard(path);
+			std::unique_lock<std::mutex> lock(shard.lock);
+
+			auto it = shard.dirs.find(path);
+			if (it == shard.dirs.end() || !canCache(path, it->second))
+				return;
+
+			// Something changed while the directory was read : the listing may be stale
+			if (it->second.generation != generation)
 			{
-				std::unique_lock<std::mutex> lock(mFileCacheMutex);
-				mFileCache.clear();
+				it->second.entries.clear();
+				it->second.complete = false;
+				return;
 			}
 
-			static void setEnabled(bool value) { mEnabled = value; }
+			it->second.complete = true;
+		}
 
-		private:
-			static std::map<std::string, FileCache> mFileCache;
-			static std::mutex mFileCacheMutex;
-			static bool mEnabled;
-		};
+		void FileCache::invalidate(const std::string& key)
+		{
+			std::string dir, name;
+			if (splitPath(key, dir, name))
+				onFileChanged(dir, name, true);
+		}
 
-		std::map<std::string, FileCache> FileCache::mFileCache;
-		std::mutex FileCache::mFileCacheMutex;
-		bool FileCache::mEnabled = false;
+		void FileCache::resetCache()
+		{
+			// Buckets go, but the kernel watches stay : they're reused when the directories are cached again
+			for (int i = 0; i < FILECACHE_SHARDS; i++)
+			{
+				std::unique_lock<std::mutex> lock(sShards[i].lock);
+				sShards[i].dirs.clear();
+			}
+		}
 
-		FileSystemCacheActivator::FileSystemCacheActivator()
+		bool enablePersistentFileCache()
 		{
-			if (mReferenceCount == 0)
+			if (sPersistent)
+				return true;
+
+			sInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (sInotifyFd < 0)
 			{
-				FileCache::setEnabled(true);
-				FileCache::resetCache();
+				LOG(LogWarning) << "FileCache - inotify is not available, the file cache is only used while loading";
+				return false;
+			}
+
+			FileCache::resetCache();
+
+			sWatcherRunning = true;
+			sWatcherThread = std::thread(&watcherProc);
+			sPersistent = true;
+			return true;
+		}
+
+		void disablePersistentFileCache()
+		{
+			if (!sPersistent)
+				return;
+
+			sPersistent = false;
+			sWatcherRunning = false;
+
+			if (sWatcherThread.joinable())
+				sWatcherThread.join();
+
+			close(sInotifyFd);
+			sInotifyFd = -1;
+
+			{
+				std::unique_lock<std::mutex> lock(sWatchLock);
+				sWatchedDirs.clear();
 			}
 
-			mReferenceCount++;
+			FileCache::resetCache();
+		}
+
+		FileCacheStats getFileCacheStats()
+		{
+			FileCacheStats stats;
+			stats.hits = sHits;
+			stats.negativeHits = sNegativeHits;
+			stats.misses = sMisses;
+			stats.statCalls = sStatCalls;
+			stats.dirReads = sDirReads;
+			stats.directories = 0;
+			stats.entries = 0;
+
+			for (int i = 0; i < FILECACHE_SHARDS; i++)
+			{
+				std::unique_lock<std::mutex> lock(sShards[i].lock);
+				stats.directories += sShards[i].dirs.size();
+
+				for (auto& dir : sShards[i].dirs)
+					stats.entries += dir.second.entries.size();
+			}
+
+			return stats;
+		}
+
+		FileSystemCacheActivator::FileSystemCacheActivator()
+		{
+			if (sActivatorCount++ == 0 && !sPersistent)
+				FileCache::resetCache();
+
+			mReferenceCount = sActivatorCount;
 		}
 
 		FileSystemCacheActivator::~FileSystemCacheActivator()
 		{
-			mReferenceCount--;
+			if (--sActivatorCount > 0)
+				return;
 
-			if (mReferenceCount <= 0)
+			mReferenceCount = 0;
+
+			FileCacheStats stats = getFileCacheStats();
+			LOG(LogDebug) << "FileCache - hits: " << stats.hits << ", negative hits: " << stats.negativeHits << ", misses: " << stats.misses << ", entries: " << stats.entries;
+
+			if (!sPersistent)
 			{
-				FileCache::setEnabled(false);
 				FileCache::resetCache();
+				return;
+			}
+
+			// Keep only what inotify can invalidate
+			for (int i = 0; i < FILECACHE_SHARDS; i++)
+			{
+				std::unique_lock<std::mutex> lock(sShards[i].lock);
+
+				for (auto it = sShards[i].dirs.begin(); it != sShards[i].dirs.end(); )
+				{
+					if (it->second.watch < 0)
+						it = sShards[i].dirs.erase(it);
+					else
+						++it;
+				}
 			}
 		}
 
@@ -207,9 +550,11 @@ namespace Utils
 			// only parse the directory, if it's a directory
 			if (isDirectory(path))
 			{
-				FileCache::add(path + "/*", FileCache(true, true));
+				unsigned int generation = 0;
+				bool cache = FileCache::beginRead(path, generation);
 
 				DIR* dir = opendir(path.c_str());
+				sDirReads++;
 
 				if (dir != NULL)
 				{
@@ -229,13 +574,18 @@ namespace Utils
 							fi.path = fullName;
 							fi.hidden = Utils::FileSystem::isHidden(fullName);
 							fi.directory = (entry->d_type == 4); // DT_DIR;
+							fi.symlink = (entry->d_type == 10); // DT_LNK;
 							contentList.push_back(fi);
 
-							FileCache::add(fullName, FileCache(entry, fi.hidden));
+							if (cache)
+								FileCache::add(fullName, FileCache(entry, fi.hidden), generation);
 						}
 					}
 
 					closedir(dir);
+
+					if (cache)
+						FileCache::setDirectoryComplete(path, generation);
 				}
 
 			}
@@ -244,6 +594,31 @@ namespace Utils
 			return contentList;
 
 		} // getDirContent
+
+		unsigned int beginDirInfoCache(const std::string& _path)
+		{
+			unsigned int generation = 0;
+			if (!FileCache::beginRead(getGenericPath(_path), generation))
+				return 0;
+
+			return generation;
+		}
+
+		void setDirInfoCache(const std::string& _path, const fileList& _content, unsigned int _generation)
+		{
+			if (_generation == 0)
+				return;
+
+			for (auto& fi : _content)
+			{
+				FileCache cache(true, fi.directory);
+				cache.hidden = fi.hidden;
+				cache.isSymLink = fi.symlink;
+				FileCache::add(fi.path, cache, _generation);
+			}
+
+			FileCache::setDirectoryComplete(getGenericPath(_path), _generation);
+		} // setDirInfoCache
 		
 		stringList getDirContent(const std::string& _path, const bool _recursive, const bool includeHidden)
 		{
@@ -253,10 +628,11 @@ namespace Utils
 			// only parse the directory, if it's a directory
 			if(isDirectory(path))
 			{		
-				FileCache::add(path + "/*", FileCache(true, true));
-
+				unsigned int generation = 0;
+				bool cache = FileCache::beginRead(path, generation);
 
 				DIR* dir = opendir(path.c_str());
+				sDirReads++;
 
 				if(dir != NULL)
 				{
@@ -272,7 +648,8 @@ namespace Utils
 						{
 							std::string fullName(getGenericPath(path + "/" + name));
 
-							FileCache::add(fullName, FileCache(fullName, entry));
+							if (cache)
+								FileCache::add(fullName, FileCache(fullName, entry), generation);
 
 							if (!includeHidden && Utils::FileSystem::isHidden(fullName))
 								continue;
@@ -285,6 +662,9 @@ namespace Utils
 					}
 
 					closedir(dir);
+
+					if (cache)
+						FileCache::setDirectoryComplete(path, generation);
 				}
 
 			}
@@ -673,6 +1053,7 @@ namespace Utils
 			struct stat info;
 
 			// check if lstat succeeded
+			sStatCalls++;
 			if(lstat(path.c_str(), &info) == 0)
 			{
 				resolved.resize(info.st_size);
@@ -694,7 +1075,9 @@ namespace Utils
 				return true;
 
 			// try to remove file
-			return (unlink(path.c_str()) == 0);
+			bool removed = (unlink(path.c_str()) == 0);
+			FileCache::invalidate(path);
+			return removed;
 
 		} // removeFile
 
@@ -727,13 +1110,13 @@ namespace Utils
 			fclose(dest);
 			fclose(source);
 
+			FileCache::invalidate(pathD);
+
 			return true;
 		} // removeFile
 
 		bool createDirectory(const std::string& _path)
 		{
-			FileCache::resetCache();
-
 			std::string path = getGenericPath(_path);
 
 			// don't create if it already exists
@@ -742,7 +1125,10 @@ namespace Utils
 
 			// try to create directory
 			if(mkdir(path.c_str(), 0755) == 0)
+			{
+				FileCache::invalidate(path);
 				return true;
+			}
 
 			// failed to create directory, try to create the parent
 			std::string parent = getParent(path);
@@ -752,7 +1138,9 @@ namespace Utils
 				createDirectory(parent);
 
 			// try to create directory again now that the parent should exist
-			return (mkdir(path.c_str(), 0755) == 0);
+			bool created = (mkdir(path.c_str(), 0755) == 0);
+			FileCache::invalidate(path);
+			return created;
 
 		} // createDirectory
 
@@ -761,9 +1149,9 @@ namespace Utils
 			if (_path.empty())
 				return false;
 
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists;
+			FileCache it;
+			if (FileCache::get(_path, it))
+				return it.exists;
 
 			std::string path = getGenericPath(_path);
 			struct stat64 info;
@@ -781,6 +1169,7 @@ namespace Utils
 			struct stat64 info;
 
 			// check if stat64 succeeded
+			sStatCalls++;
 			if ((stat64(path.c_str(), &info) == 0))
 				return (size_t) info.st_size;
 
@@ -793,6 +1182,7 @@ namespace Utils
 			struct stat64 info;
 
 			// check if stat64 succeeded
+			sStatCalls++;
 			if ((stat64(path.c_str(), &info) == 0))
 				return Utils::Time::DateTime(info.st_ctime);
 
@@ -805,6 +1195,7 @@ namespace Utils
 			struct stat64 info;
 
 			// check if stat64 succeeded
+			sStatCalls++;
 			if ((stat64(path.c_str(), &info) == 0))
 				return Utils::Time::DateTime(info.st_mtime);
 
@@ -823,9 +1214,9 @@ namespace Utils
 
 		bool isRegularFile(const std::string& _path)
 		{
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists && !it->directory && !it->isSymLink;
+			FileCache it;
+			if (FileCache::get(_path, it))
+				return it.exists && !it.directory && !it.isSymLink;
 
 			std::string path = getGenericPath(_path);
 			struct stat64 info;
@@ -841,9 +1232,9 @@ namespace Utils
 
 		bool isDirectory(const std::string& _path)
 		{
-			auto it = FileCache::get(_path);
-			if (it != nullptr && !it->isSymLink)
-				return it->exists && it->directory;
+			FileCache it;
+			if (FileCache::get(_path, it) && !it.isSymLink)
+				return it.exists && it.directory;
 
 			std::string path = getGenericPath(_path);
 			struct stat64 info;
@@ -858,9 +1249,9 @@ namespace Utils
 
 		bool isSymlink(const std::string& _path)
 		{		
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists && it->isSymLink;
+			FileCache it;
+			if (FileCache::get(_path, it))
+				return it.exists && it.isSymLink;
 				
 			std::string path = getGenericPath(_path);
 
@@ -877,9 +1268,9 @@ namespace Utils
 
 		bool isHidden(const std::string& _path)
 		{
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists && it->hidden;
+			FileCache it;
+			if (FileCache::get(_path, it))
+				return it.exists && it.hidden;
 
 			std::string path = getGenericPath(_path);
 
@@ -960,6 +1351,8 @@ namespace Utils
 			fs.open(fileName.c_str(), std::fstream::out);
 			fs << text;
 			fs.close();
+
+			FileCache::invalidate(getGenericPath(fileName));
 		}  // writeAllText
 
 
@@ -58,16 +58,36 @@ namespace Utils
 			std::string path;
 			bool hidden;
 			bool directory;
+			bool symlink;
 		};
 
 		typedef std::list<FileInfo> fileList;
 
 		fileList        getDirInfo     (const std::string& _path/*, const bool _recursive = false*/);
+		unsigned int    beginDirInfoCache(const std::string& _path); // watch the directory, before checking a known listing is still valid
+		void            setDirInfoCache(const std::string& _path, const fileList& _content, unsigned int _generation); // seed the file cache with it
 
 		std::string readAllText        (const std::string fileName);
 		void        writeAllText       (const std::string fileName, const std::string text);
 		bool        copyFile           (const std::string src, const std::string dst);
 
+		struct FileCacheStats
+		{
+			unsigned long long hits;
+			unsigned long long negativeHits; // answered "doesn't exist" from a complete directory listing
+			unsigned long long misses;
+			unsigned long long statCalls; // stat / lstat syscalls issued (cache misses, sizes, dates)
+			unsigned long long dirReads;  // opendir syscalls
+			size_t             directories;
+			size_t             entries;
+		};
+
+		// Keeps the file cache for the process lifetime, invalidated by inotify. Returns false if inotify is unavailable
+		bool           enablePersistentFileCache();
+		void           disablePersistentFileCache();
+		FileCacheStats getFileCacheStats();
+
+		// Caches everything during its scope (loading). Outside, only the directories inotify can watch stay cached
 		class FileSystemCacheActivator
 		{
 		public:
@@ -0,0 +1,534 @@
+#include "utils/PixelUtil.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string.h>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIXEL_KERNEL_NEON
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PIXEL_KERNEL_SSE2
+#endif
+
+namespace Utils
+{
+	namespace Pixel
+	{
+		// Exact (c * a) / 255, rounded
+		static inline unsigned int mul255(unsigned int c, unsigned int a)
+		{
+			unsigned int t = c * a + 128;
+			return (t + (t >> 8)) >> 8;
+		}
+
+		static void convertRowScalar(unsigned char* dst, const unsigned char* src, size_t width, unsigned int flags)
+		{
+			const unsigned int* in = (const unsigned int*)src;
+			unsigned int* out = (unsigned int*)dst;
+
+			for (size_t x = 0; x < width; x++)
+			{
+				unsigned int c = in[x];
+
+				if (flags & SWAP_RED_BLUE)
+					c = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
+
+				if (flags & PREMULTIPLY_ALPHA)
+				{
+					unsigned int a = c >> 24;
+					c = (c & 0xFF000000) | (mul255((c >> 16) & 0xFF, a) << 16) | (mul255((c >> 8) & 0xFF, a) << 8) | mul255(c & 0xFF, a);
+				}
+
+				out[x] = c;
+			}
+		}
+
+#if defined(PIXEL_KERNEL_NEON)
+
+		static inline uint8x16_t premultiplyNEON(uint8x16_t c, uint8x16_t a)
+		{
+			uint16x8_t lo = vmull_u8(vget_low_u8(c), vget_low_u8(a));
+			uint16x8_t hi = vmull_u8(vget_high_u8(c), vget_high_u8(a));
+
+			// (t + ((t + 128) >> 8) + 128) >> 8 : same rounding as mul255
+			return vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)), vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+		}
+
+		static void convertRow(unsigned char* dst, const unsigned char* src, size_t width, unsigned int flags)
+		{
+			size_t x = 0;
+
+			// 16 pixels at a time, deinterleaved into one register per channel
+			for (; x + 16 <= width; x += 16)
+			{
+				uint8x16x4_t v = vld4q_u8(src + x * 4);
+
+				if (flags & SWAP_RED_BLUE)
+				{
+					uint8x16_t tmp = v.val[0];
+					v.val[0] = v.val[2];
+					v.val[2] = tmp;
+				}
+
+				if (flags & PREMULTIPLY_ALPHA)
+				{
+					v.val[0] = premultiplyNEON(v.val[0], v.val[3]);
+					v.val[1] = premultiplyNEON(v.val[1], v.val[3]);
+					v.val[2] = premultiplyNEON(v.val[2], v.val[3]);
+				}
+
+				vst4q_u8(dst + x * 4, v);
+			}
+
+			if (x < width)
+				convertRowScalar(dst + x * 4, src + x * 4, width - x, flags);
+		}
+
+		const char* getKernelName() { return "NEON"; }
+
+#elif defined(PIXEL_KERNEL_SSE2)
+
+		// 2 pixels, one channel per 16 bit lane
+		static inline __m128i premultiplySSE2(__m128i px)
+		{
+			const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+			const __m128i alphaFactor = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+			const __m128i round = _mm_set1_epi16(128);
+
+			__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			a = _mm_or_si128(_mm_andnot_si128(alphaLanes, a), alphaFactor); // alpha * 255 / 255 keeps alpha
+
+			__m128i t = _mm_add_epi16(_mm_mullo_epi16(px, a), round);
+			return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+		}
+
+		static void convertRow(unsigned char* dst, const unsigned char* src, size_t width, unsigned int flags)
+		{
+			const __m128i maskAG = _mm_set1_epi32(0xFF00FF00);
+			const __m128i maskB = _mm_set1_epi32(0x000000FF);
+			const __m128i maskR = _mm_set1_epi32(0x00FF0000);
+			const __m128i zero = _mm_setzero_si128();
+
+			size_t x = 0;
+
+			for (; x + 4 <= width; x += 4)
+			{
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + x * 4));
+
+				if (flags & SWAP_RED_BLUE)
+				{
+					__m128i r = _mm_and_si128(_mm_slli_epi32(v, 16), maskR);
+					__m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), maskB);
+					v = _mm_or_si128(_mm_and_si128(v, maskAG), _mm_or_si128(r, b));
+				}
+
+				if (flags & PREMULTIPLY_ALPHA)
+				{
+					__m128i lo = premultiplySSE2(_mm_unpacklo_epi8(v, zero));
+					__m128i hi = premultiplySSE2(_mm_unpackhi_epi8(v, zero));
+					v = _mm_packus_epi16(lo, hi);
+				}
+
+				_mm_storeu_si128((__m128i*)(dst + x * 4), v);
+			}
+
+			if (x < width)
+				convertRowScalar(dst + x * 4, src + x * 4, width - x, flags);
+		}
+
+		const char* getKernelName() { return "SSE2"; }
+
+#else
+
+		static void convertRow(unsigned char* dst, const unsigned char* src, size_t width, unsigned int flags)
+		{
+			convertRowScalar(dst, src, width, flags);
+		}
+
+		const char* getKernelName() { return "scalar"; }
+
+#endif
+
+		template<void (*RowFunction)(unsigned char*, const unsigned char*, size_t, unsigned int)>
+		static void convertRows(unsigned char* dst, const unsigned char* src, size_t width, size_t height, size_t srcPitch, unsigned int flags)
+		{
+			size_t dstPitch = width * 4;
+
+			for (size_t y = 0; y < height; y++)
+			{
+				const unsigned char* srcRow = src + ((flags & FLIP_VERTICAL) ? height - 1 - y : y) * srcPitch;
+				unsigned char* dstRow = dst + y * dstPitch;
+
+				if ((flags & (SWAP_RED_BLUE | PREMULTIPLY_ALPHA)) == 0)
+					memcpy(dstRow, srcRow, dstPitch);
+				else
+					RowFunction(dstRow, srcRow, width, flags);
+			}
+		}
+
+		void convert(unsigned char* dst, const unsigned char* src, size_t width, size_t height, size_t srcPitch, unsigned int flags)
+		{
+			convertRows<convertRow>(dst, src, width, height, srcPitch, flags);
+		}
+
+		void convertScalar(unsigned char* dst, const unsigned char* src, size_t width, size_t height, size_t srcPitch, unsigned int flags)
+		{
+			convertRows<convertRowScalar>(dst, src, width, height, srcPitch, flags);
+		}
+
+		void flipVertical(unsigned char* pixels, size_t width, size_t height)
+		{
+			// Rows are swapped through a small stack buffer, so there's no allocation whatever the picture size
+			unsigned char chunk[1024];
+			size_t pitch = width * 4;
+
+			for (size_t y = 0; y < height / 2; y++)
+			{
+				unsigned char* top = pixels + y * pitch;
+				unsigned char* bottom = pixels + (height - 1 - y) * pitch;
+
+				for (size_t offset = 0; offset < pitch; offset += sizeof(chunk))
+				{
+					size_t count = std::min(sizeof(chunk), pitch - offset);
+
+					memcpy(chunk, top + offset, count);
+					memcpy(top + offset, bottom + offset, count);
+					memcpy(bottom + offset, chunk, count);
+				}
+			}
+		}
+
+		void resize(unsigned char* dst, size_t dstWidth, size_t dstHeight, const unsigned char* src, size_t srcWidth, size_t srcHeight)
+		{
+			if (dstWidth == 0 || dstHeight == 0 || srcWidth == 0 || srcHeight == 0)
+				return;
+
+			// Source columns covered by each destination column
+			std::vector<size_t> columns(dstWidth + 1);
+			for (size_t x = 0; x <= dstWidth; x++)
+				columns[x] = x * srcWidth / dstWidth;
+
+			std::vector<unsigned int> sums(dstWidth * 4);
+
+			for (size_t y = 0; y < dstHeight; y++)
+			{
+				size_t y0 = y * srcHeight / dstHeight;
+				size_t y1 = std::max(y0 + 1, (y + 1) * srcHeight / dstHeight);
+
+				std::fill(sums.begin(), sums.end(), 0);
+
+				for (size_t sy = y0; sy < y1; sy++)
+				{
+					const unsigned char* row = src + sy * srcWidth * 4;
+					unsigned int* sum = sums.data();
+
+					for (size_t x = 0; x < dstWidth; x++, sum += 4)
+					{
+						size_t x1 = std::max(columns[x] + 1, columns[x + 1]);
+						for (const unsigned char* px = row + columns[x] * 4; px < row + x1 * 4; px += 4)
+						{
+							sum[0] += px[0];
+							sum[1] += px[1];
+							sum[2] += px[2];
+							sum[3] += px[3];
+						}
+					}
+				}
+
+				unsigned char* out = dst + y * dstWidth * 4;
+				const unsigned int* sum = sums.data();
+
+				for (size_t x = 0; x < dstWidth; x++, sum += 4, out += 4)
+				{
+					unsigned int count = (unsigned int)((std::max(columns[x] + 1, columns[x + 1]) - columns[x]) * (y1 - y0));
+					unsigned int half = count / 2;
+
+					out[0] = (unsigned char)((sum[0] + half) / count);
+					out[1] = (unsigned char)((sum[1] + half) / count);
+					out[2] = (unsigned char)((sum[2] + half) / count);
+					out[3] = (unsigned char)((sum[3] + half) / count);
+				}
+			}
+		}
+
+		bool hasAlpha(const unsigned char* rgba, size_t width, size_t height)
+		{
+			const unsigned int* pixels = (const unsigned int*)rgba;
+			size_t count = width * height;
+
+			for (size_t i = 0; i < count; i++)
+				if ((pixels[i] >> 24) != 0xFF)
+					return true;
+
+			return false;
+		}
+
+		void toRGB565(unsigned short* dst, const unsigned char* rgba, size_t width, size_t height)
+		{
+			size_t count = width * height;
+
+			for (size_t i = 0; i < count; i++, rgba += 4)
+				dst[i] = (unsigned short)(((rgba[0] >> 3) << 11) | ((rgba[1] >> 2) << 5) | (rgba[2] >> 3));
+		}
+
+		void toRGBA4444(unsigned short* dst, const unsigned char* rgba, size_t width, size_t height)
+		{
+			size_t count = width * height;
+
+			for (size_t i = 0; i < count; i++, rgba += 4)
+				dst[i] = (unsigned short)(((rgba[0] >> 4) << 12) | ((rgba[1] >> 4) << 8) | ((rgba[2] >> 4) << 4) | (rgba[3] >> 4));
+		}
+
+		static const int etc1Modifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+
+		struct ETC1SubBlock
+		{
+			int color[3];       // expanded base color
+			int table;
+			unsigned int error;
+			unsigned char indexes[8];
+		};
+
+		static inline int clamp255(int value)
+		{
+			return value < 0 ? 0 : (value > 255 ? 255 : value);
+		}
+
+		// Picks the modifier table & pixel indexes giving the smallest error for a base color
+		static void fitETC1SubBlock(const unsigned char* pixels[8], ETC1SubBlock& sub)
+		{
+			sub.error = 0xFFFFFFFF;
+
+			for (int table = 0; table < 8; table++)
+			{
+				int offsets[4] = { etc1Modifiers[table][0], etc1Modifiers[table][1], -etc1Modifiers[table][0], -etc1Modifiers[table][1] };
+
+				unsigned int error = 0;
+				unsigned char indexes[8];
+
+				for (int p = 0; p < 8 && error < sub.error; p++)
+				{
+					unsigned int best = 0xFFFFFFFF;
+
+					for (int m = 0; m < 4; m++)
+					{
+						int dr = clamp255(sub.color[0] + offsets[m]) - pixels[p][0];
+						int dg = clamp255(sub.color[1] + offsets[m]) - pixels[p][1];
+						int db = clamp255(sub.color[2] + offsets[m]) - pixels[p][2];
+
+						unsigned int e = (unsigned int)(dr * dr + dg * dg + db * db);
+						if (e < best)
+						{
+							best = e;
+							indexes[p] = (unsigned char)m;
+						}
+					}
+
+					error += best;
+				}
+
+				if (error < sub.error)
+				{
+					sub.error = error;
+					sub.table = table;
+					memcpy(sub.indexes, indexes, sizeof(indexes));
+				}
+			}
+		}
+
+		static void encodeETC1Block(unsigned char* dst, const unsigned char* block[16])
+		{
+			// block[] is indexed x * 4 + y, like the ETC1 pixel indexes
+			unsigned long long bestBits = 0;
+			unsigned int bestError = 0xFFFFFFFF;
+
+			for (int flip = 0; flip < 2; flip++)
+			{
+				const unsigned char* pixels[2][8];
+				int average[2][3];
+
+				for (int half = 0; half < 2; half++)
+				{
+					int sum[3] = { 0, 0, 0 };
+					int n = 0;
+
+					for (int x = 0; x < 4; x++)
+					{
+						for (int y = 0; y < 4; y++)
+						{
+							bool inHalf = flip ? (y / 2 == half) : (x / 2 == half);
+							if (!inHalf)
+								continue;
+
+							const unsigned char* px = block[x * 4 + y];
+							pixels[half][n++] = px;
+							sum[0] += px[0]; sum[1] += px[1]; sum[2] += px[2];
+						}
+					}
+
+					for (int c = 0; c < 3; c++)
+						average[half][c] = (sum[c] + 4) / 8;
+				}
+
+				// Differential mode if the 5 bit colors are close enough, individual 4 bit colors otherwise
+				int q[2][3];
+				bool differential = true;
+
+				for (int c = 0; c < 3; c++)
+				{
+					q[0][c] = (average[0][c] * 31 + 127) / 255;
+					q[1][c] = (average[1][c] * 31 + 127) / 255;
+
+					int delta = q[1][c] - q[0][c];
+					if (delta < -4 || delta > 3)
+						differential = false;
+				}
+
+				ETC1SubBlock sub[2];
+
+				for (int half = 0; half < 2; half++)
+				{
+					for (int c = 0; c < 3; c++)
+					{
+						if (differential)
+							sub[half].color[c] = (q[half][c] << 3) | (q[half][c] >> 2);
+						else
+						{
+							q[half][c] = (average[half][c] * 15 + 127) / 255;
+							sub[half].color[c] = (q[half][c] << 4) | q[half][c];
+						}
+					}
+
+					fitETC1SubBlock(pixels[half], sub[half]);
+				}
+
+				unsigned int error = sub[0].error + sub[1].error;
+				if (error >= bestError)
+					continue;
+
+				bestError = error;
+
+				unsigned long long bits = 0;
+
+				if (differential)
+				{
+					for (int c = 0; c < 3; c++)
+						bits |= (unsigned long long)((q[0][c] << 3) | ((q[1][c] - q[0][c]) & 7)) << (56 - c * 8);
+				}
+				else
+				{
+					for (int c = 0; c < 3; c++)
+						bits |= (unsigned long long)((q[0][c] << 4) | q[1][c]) << (56 - c * 8);
+				}
+
+				bits |= (unsigned long long)((sub[0].table << 5) | (sub[1].table << 2) | (differential ? 2 : 0) | flip) << 32;
+
+				// Pixel indexes : msb in bits 16-31, lsb in bits 0-15. Modifier order is +a, +b, -a, -b -> 00, 01, 10, 11
+				for (int half = 0; half < 2; half++)
+				{
+					int n = 0;
+					for (int x = 0; x < 4; x++)
+					{
+						for (int y = 0; y < 4; y++)
+						{
+							bool inHalf = flip ? (y / 2 == half) : (x / 2 == half);
+							if (!inHalf)
+								continue;
+
+							int bit = x * 4 + y;
+							int index = sub[half].indexes[n++];
+
+							bits |= (unsigned long long)(index >> 1) << (16 + bit);
+							bits |= (unsigned long long)(index & 1) << bit;
+						}
+					}
+				}
+
+				bestBits = bits;
+			}
+
+			// Big endian
+			for (int i = 0; i < 8; i++)
+				dst[i] = (unsigned char)(bestBits >> (56 - i * 8));
+		}
+
+		void toETC1(unsigned char* dst, const unsigned char* rgba, size_t width, size_t height)
+		{
+			if (width == 0 || height == 0)
+				return;
+
+			for (size_t by = 0; by < height; by += 4)
+			{
+				for (size_t bx = 0; bx < width; bx += 4)
+				{
+					// Partial blocks repeat the last row / column
+					const unsigned char* block[16];
+					for (int x = 0; x < 4; x++)
+						for (int y = 0; y < 4; y++)
+							block[x * 4 + y] = rgba + (std::min(by + y, height - 1) * width + std::min(bx + x, width - 1)) * 4;
+
+					encodeETC1Block(dst, block);
+					dst += 8;
+				}
+			}
+		}
+
+		std::string benchmark(size_t width, size_t height, int iterations)
+		{
+			typedef void (*ConvertFunction)(unsigned char*, const unsigned char*, size_t, size_t, size_t, unsigned int);
+
+			std::vector<unsigned char> source(width * height * 4);
+			for (size_t i = 0; i < source.size(); i++)
+				source[i] = (unsigned char)((i * 2654435761u) >> 13);
+
+			std::vector<unsigned char> simd(source.size());
+			std::vector<unsigned char> scalar(source.size());
+
+			struct Case { const char* name; unsigned int flags; };
+			Case cases[] =
+			{
+				{ "swizzle", SWAP_RED_BLUE },
+				{ "swizzle+flip", SWAP_RED_BLUE | FLIP_VERTICAL },
+				{ "swizzle+flip+premultiply", SWAP_RED_BLUE | FLIP_VERTICAL | PREMULTIPLY_ALPHA }
+			};
+
+			auto measure = [&](ConvertFunction function, std::vector<unsigned char>& dst, unsigned int flags)
+			{
+				auto start = std::chrono::steady_clock::now();
+				for (int i = 0; i < iterations; i++)
+					function(dst.data(), source.data(), width, height, width * 4, flags);
+
+				return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+			};
+
+			std::stringstream ss;
+			ss << "Pixel kernels : " << getKernelName() << ", " << width << "x" << height << ", " << iterations << " iterations\n";
+
+			for (auto& item : cases)
+			{
+				double scalarTime = measure(convertScalar, scalar, item.flags);
+				double simdTime = measure(convert, simd, item.flags);
+
+				ss << "  " << item.name << " : scalar " << (int)scalarTime << " us, " << getKernelName() << " " << (int)simdTime << " us";
+				if (simdTime > 0)
+					ss << " (x" << (scalarTime / simdTime) << ")";
+				if (simd != scalar)
+					ss << " MISMATCH";
+				ss << "\n";
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations; i++)
+				flipVertical(simd.data(), width, height);
+
+			ss << "  in-place flip : " << (int)(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations) << " us\n";
+			return ss.str();
+		}
+
+	} // Pixel::
+
+} // Utils::
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef ES_CORE_UTILS_PIXEL_UTIL_H
+#define ES_CORE_UTILS_PIXEL_UTIL_H
+
+#include <stddef.h>
+#include <string>
+
+namespace Utils
+{
+	// 32 bit pixel kernels used when decoded pictures are copied into texture buffers.
+	// The SIMD path (NEON on ARM, SSE2 on x86) is selected at compile time, with a scalar fallback
+	namespace Pixel
+	{
+		enum ConvertFlags : unsigned int
+		{
+			SWAP_RED_BLUE     = 1, // BGRA <-> RGBA
+			FLIP_VERTICAL     = 2, // last source row becomes the first destination row
+			PREMULTIPLY_ALPHA = 4
+		};
+
+		// Copies a width x height picture from src (rows srcPitch bytes apart) to the tightly packed dst, applying the flags in a single pass.
+		// dst & src must not overlap
+		void convert(unsigned char* dst, const unsigned char* src, size_t width, size_t height, size_t srcPitch, unsigned int flags);
+		void convertScalar(unsigned char* dst, const unsigned char* src, size_t width, size_t height, size_t srcPitch, unsigned int flags);
+
+		// In-place vertical flip of a tightly packed picture
+		void flipVertical(unsigned char* pixels, size_t width, size_t height);
+
+		// Resamples a tightly packed RGBA picture : each destination pixel is the average of the source pixels it covers
+		// (box filter), or the nearest source pixel when enlarging
+		void resize(unsigned char* dst, size_t dstWidth, size_t dstHeight, const unsigned char* src, size_t srcWidth, size_t srcHeight);
+
+		// True if at least one pixel of the RGBA picture is not fully opaque
+		bool hasAlpha(const unsigned char* rgba, size_t width, size_t height);
+
+		// Packs a RGBA picture into 16 bit pixels, in the layout of GL_UNSIGNED_SHORT_5_6_5 / GL_UNSIGNED_SHORT_4_4_4_4
+		void toRGB565(unsigned short* dst, const unsigned char* rgba, size_t width, size_t height);
+		void toRGBA4444(unsigned short* dst, const unsigned char* rgba, size_t width, size_t height);
+
+		// Encodes the RGB channels of a RGBA picture as ETC1 4x4 blocks (8 bytes each, partial blocks are padded).
+		// Fast encoder : per block, both sub-block layouts are tried with the averaged base colors and the best modifier table.
+		// dst must hold Renderer::getTextureDataSize(Renderer::Texture::ETC1, width, height) bytes
+		void toETC1(unsigned char* dst, const unsigned char* rgba, size_t width, size_t height);
+
+		const char* getKernelName();
+
+		// Times the SIMD & scalar kernels on a synthetic picture and returns a report
+		std::string benchmark(size_t width = 640, size_t height = 480, int iterations = 50);
+
+	} // Pixel::
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_PIXEL_UTIL_H
@@ -1,84 +1,240 @@
 #include "ThreadPool.h"
 
+#include "Log.h"
+#include "Settings.h"
+
+#include <pthread.h>
+#include <sched.h>
+
 namespace Utils
 {
-	ThreadPool::ThreadPool() : mRunning(true), mWaiting(false), mNumWork(0)
+	static thread_local ThreadPool* sCurrentPool = nullptr;
+	static thread_local size_t sCurrentWorker = 0;
+
+	ThreadPool* ThreadPool::getInstance()
+	{
+		// Created on first use, so it's destroyed before the static objects which queue work (ie TextureDataManager)
+		static ThreadPool sInstance([]
+		{
+			int numThreads = Settings::getInstance()->getInt("ThreadPoolSize");
+			if (numThreads <= 0)
+				numThreads = std::max(2, (int)std::thread::hardware_concurrency());
+
+			return (size_t)numThreads;
+		}(), (unsigned int)Settings::getInstance()->getInt("ThreadPoolAffinity"));
+
+		return &sInstance;
+	}
+
+	ThreadPool::ThreadPool(size_t numThreads, unsigned int affinityMask) : mNextWorker(0), mPendingWork(0), mExit(false)
+	{
+		LOG(LogInfo) << "ThreadPool - Starting " << numThreads << " workers";
+
+		mWorkers.reserve(numThreads);
+
+		for (size_t i = 0; i < numThreads; i++)
+			mWorkers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+		for (size_t i = 0; i < numThreads; i++)
+			mWorkers[i]->thread = std::thread(&ThreadPool::threadProc, this, i, affinityMask);
+	}
+
+	ThreadPool::~ThreadPool()
 	{
-		size_t num_threads = std::thread::hardware_concurrency() * 2;
+		{
+			std::unique_lock<std::mutex> lock(mParkLock);
+			mExit = true;
+		}
 
-		auto doWork = [&](size_t id)
+		mParkEvent.notify_all();
+
+		for (auto& worker : mWorkers)
 		{
-			while (mRunning)
+			// exit() called from a worker can't join itself
+			if (worker->thread.get_id() == std::this_thread::get_id())
+				worker->thread.detach();
+			else if (worker->thread.joinable())
+				worker->thread.join();
+		}
+	}
+
+	bool ThreadPool::isWorkerThread() const
+	{
+		return sCurrentPool == this;
+	}
+
+	void ThreadPool::queueWorkItem(work_function work)
+	{
+		// Workers push on their own deque, other threads spread the work round-robin
+		size_t index = isWorkerThread() ? sCurrentWorker : mNextWorker++ % mWorkers.size();
+
+		mPendingWork++;
+
+		{
+			std::unique_lock<std::mutex> lock(mWorkers[index]->lock);
+			mWorkers[index]->queue.push_back(work);
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mParkLock);
+		}
+
+		mParkEvent.notify_one();
+	}
+
+	bool ThreadPool::popWorkItem(size_t index, work_function& work)
+	{
+		if (index < mWorkers.size())
+		{
+			Worker* worker = mWorkers[index].get();
+
+			std::unique_lock<std::mutex> lock(worker->lock);
+			if (!worker->queue.empty())
 			{
-				_mutex.lock();
-				if (!mWorkQueue.empty())
-				{
-					auto work = mWorkQueue.front();
-					mWorkQueue.pop();
-					_mutex.unlock();
+				work = worker->queue.back();
+				worker->queue.pop_back();
+				mPendingWork--;
+				return true;
+			}
+		}
 
-					try
-					{
-						work();
-					}
-					catch (...) {}
+		for (size_t i = 1; i <= mWorkers.size(); i++)
+		{
+			Worker* victim = mWorkers[(index + i) % mWorkers.size()].get();
 
-					mNumWork--;
-				}
-				else
-				{
-					_mutex.unlock();
+			std::unique_lock<std::mutex> lock(victim->lock);
+			if (!victim->queue.empty())
+			{
+				work = victim->queue.front();
+				victim->queue.pop_front();
+				mPendingWork--;
+				return true;
+			}
+		}
 
-					// Extra code : Exit finished threads
-					if (mWaiting)
-						return;
+		return false;
+	}
 
-					std::this_thread::yield();
-					std::this_thread::sleep_for(std::chrono::milliseconds(1));
-				}
+	bool ThreadPool::runPendingWorkItem()
+	{
+		work_function work;
+		if (!popWorkItem(isWorkerThread() ? sCurrentWorker : mWorkers.size(), work))
+			return false;
+
+		try
+		{
+			work();
+		}
+		catch (...) {}
+
+		return true;
+	}
+
+	void ThreadPool::threadProc(size_t index, unsigned int affinityMask)
+	{
+		sCurrentPool = this;
+		sCurrentWorker = index;
+
+		if (affinityMask != 0)
+		{
+			cpu_set_t cpuset;
+			CPU_ZERO(&cpuset);
+
+			for (int cpu = 0; cpu < 32; cpu++)
+				if (affinityMask & (1u << cpu))
+					CPU_SET(cpu, &cpuset);
+
+			if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) != 0)
+			{
+				LOG(LogWarning) << "ThreadPool - Unable to set affinity of worker " << index;
 			}
-		};
+		}
+
+		while (true)
+		{
+			if (runPendingWorkItem())
+				continue;
 
-		mThreads.reserve(num_threads);
+			std::unique_lock<std::mutex> lock(mParkLock);
+			if (mExit && mPendingWork.load() == 0)
+				return;
 
-		for (size_t i = 0; i < num_threads; i++)
-			mThreads.push_back(std::thread(doWork, i));
+			mParkEvent.wait(lock, [this] { return mPendingWork.load() > 0 || mExit; });
+		}
 	}
 
-	ThreadPool::~ThreadPool()
+	TaskGroup::TaskGroup() : mPool(ThreadPool::getInstance()), mNumWork(0)
 	{
-		mRunning = false;
+	}
 
-		for (std::thread& t : mThreads)
-			if (t.joinable())
-				t.join();
+	TaskGroup::~TaskGroup()
+	{
+		wait();
 	}
 
-	void ThreadPool::queueWorkItem(work_function work)
+	void TaskGroup::queueWorkItem(ThreadPool::work_function work)
 	{
-		_mutex.lock();
-		mWorkQueue.push(work);
-		mNumWork++;
-		_mutex.unlock();
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+			mNumWork++;
+		}
+
+		mPool->queueWorkItem([this, work]
+		{
+			try
+			{
+				work();
+			}
+			catch (...) {}
+
+			// Waiters on workers look for new pending items every time an item ends
+			std::unique_lock<std::mutex> lock(mLock);
+			mNumWork--;
+			mEvent.notify_all();
+		});
 	}
 
-	void ThreadPool::wait()
+	void TaskGroup::wait()
 	{
-		mWaiting = true;
-		while (mNumWork.load() > 0)
-			std::this_thread::yield();
+		if (mPool->isWorkerThread())
+		{
+			// Help the pool instead of blocking one of its workers
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mLock);
+					if (mNumWork == 0)
+						return;
+				}
+
+				if (!mPool->runPendingWorkItem())
+				{
+					// Our remaining items are running on other workers : sleep until one of them ends
+					std::unique_lock<std::mutex> lock(mLock);
+					if (mNumWork == 0)
+						return;
+
+					size_t remaining = mNumWork;
+					mEvent.wait(lock, [this, remaining] { return mNumWork != remaining; });
+				}
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(mLock);
+		mEvent.wait(lock, [this] { return mNumWork == 0; });
 	}
 
-	void ThreadPool::wait(work_function work, int delay)
+	void TaskGroup::wait(ThreadPool::work_function work, int delay)
 	{
-		mWaiting = true;
+		std::unique_lock<std::mutex> lock(mLock);
 
-		while (mNumWork.load() > 0)
+		while (mNumWork > 0)
 		{
+			lock.unlock();
 			work();
+			lock.lock();
 
-			std::this_thread::yield();
-			std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+			mEvent.wait_for(lock, std::chrono::milliseconds(delay), [this] { return mNumWork == 0; });
 		}
 	}
-}
\ No newline at end of file
+}
@@ -2,31 +2,85 @@
 
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <deque>
 #include <atomic>
 #include <functional>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <vector>
 
 namespace Utils
 {
+	// Process wide worker pool.
+	// Every worker owns a deque : it pops its own work items LIFO and steals FIFO from the other workers when it runs dry.
+	// Idle workers are parked on a condition variable. Size & cpu affinity come from the ThreadPoolSize / ThreadPoolAffinity settings.
 	class ThreadPool
 	{
 	public:
 		typedef std::function<void(void)> work_function;
 
-		ThreadPool();
-		~ThreadPool();
+		static ThreadPool* getInstance();
 
 		void queueWorkItem(work_function work);
-		void wait();
-		void wait(work_function work, int delay = 50);
+
+		template<typename F>
+		auto submit(F func) -> std::future<decltype(func())>
+		{
+			typedef decltype(func()) result_type;
+
+			auto task = std::make_shared<std::packaged_task<result_type()>>(func);
+			std::future<result_type> ret = task->get_future();
+			queueWorkItem([task] { (*task)(); });
+			return ret;
+		}
+
+		// Runs one pending work item on the calling thread. Returns false if there was nothing to run
+		bool runPendingWorkItem();
+
+		bool isWorkerThread() const;
+		size_t getThreadCount() const { return mWorkers.size(); }
 
 	private:
-		bool mRunning;
-		bool mWaiting;
-		std::queue<work_function> mWorkQueue;
-		std::atomic<size_t> mNumWork;
-		std::mutex _mutex;
-		std::vector<std::thread> mThreads;
+		// Destroyed at exit : the workers finish the queued items, then are joined
+		ThreadPool(size_t numThreads, unsigned int affinityMask);
+		~ThreadPool();
+
+		struct Worker
+		{
+			std::deque<work_function> queue;
+			std::mutex lock;
+			std::thread thread;
+		};
+
+		bool popWorkItem(size_t index, work_function& work);
+		void threadProc(size_t index, unsigned int affinityMask);
 
+		std::vector<std::unique_ptr<Worker>> mWorkers;
+		std::atomic<size_t> mNextWorker;
+		std::atomic<size_t> mPendingWork;
+		bool mExit;
+
+		std::mutex mParkLock;
+		std::condition_variable mParkEvent;
+	};
+
+	// Set of work items queued on the shared pool which can be waited for.
+	// When waited from a worker thread, pending items of the pool are run meanwhile so nested groups can't deadlock.
+	class TaskGroup
+	{
+	public:
+		TaskGroup();
+		~TaskGroup();
+
+		void queueWorkItem(ThreadPool::work_function work);
+		void wait();
+		void wait(ThreadPool::work_function work, int delay = 50);
+
+	private:
+		ThreadPool* mPool;
+		size_t mNumWork;
+		std::mutex mLock;
+		std::condition_variable mEvent;
 	};
-}
\ No newline at end of file
+}